@@ -31,10 +31,15 @@
 #include "event.h"
 #include "ewmh.h"
 #include "globalconf.h"
+#include "luagc.h"
+#include "luaprof.h"
 #include "objects/client.h"
 #include "objects/screen.h"
+#include "roundtrip.h"
 #include "spawn.h"
+#include "startup.h"
 #include "systray.h"
+#include "xrequest.h"
 #include "xwindow.h"
 #include "options.h"
 
@@ -132,12 +137,18 @@ awesome_atexit(bool restart)
                         globalconf.screen->root,
                         AWESOME_CLIENT_ORDER, XCB_ATOM_WINDOW, 32, n, wins);
 
+    /* Write the client lists which changed since the last refresh */
+    ewmh_refresh();
+
     a_dbus_cleanup();
 
     systray_cleanup();
 
     /* Close Lua */
+    luaA_profiler_shutdown();
+    roundtrip_enable(false);
     lua_close(L);
+    luaA_pool_delete(&globalconf.lua_pool);
 
     screen_cleanup();
 
@@ -451,10 +462,18 @@ a_glib_poll(GPollFD *ufds, guint nfsd, gint timeout)
     struct timeval now, length_time;
     float length;
     int saved_errno;
+    gint64 gc_time = 0;
     lua_State *L = globalconf_get_lua_State();
 
     /* Do all deferred work now */
+    startup_profile_begin("first refresh");
     awesome_refresh();
+    startup_profile_end();
+
+    /* The startup is over once the first refresh is done */
+    startup_profile_finish();
+
+    xrequest_iteration_end();
 
     /* Check if the Lua stack is the way it should be */
     if (lua_gettop(L) != 0) {
@@ -469,6 +488,18 @@ a_glib_poll(GPollFD *ufds, guint nfsd, gint timeout)
     if (globalconf.pending_event != NULL)
         timeout = 0;
 
+    /* Collect some garbage now rather than while handling the next event, but
+     * only if there is nothing else to do. Finalizers can change what has to
+     * be drawn or sent to the X server, so refresh again after collecting. */
+    if (timeout != 0)
+        gc_time = luaA_gc_idle(L);
+    if (gc_time > 0)
+        awesome_refresh();
+
+    /* The time spent collecting counts towards the next timeout */
+    if (timeout > 0)
+        timeout = MAX(0, timeout - (gint) (gc_time / 1000));
+
     /* Check how long this main loop iteration took */
     gettimeofday(&now, NULL);
     timersub(&now, &last_wakeup, &length_time);
@@ -572,6 +603,7 @@ main(int argc, char **argv)
     int xfd;
     xdgHandle xdg;
     xcb_query_tree_cookie_t tree_c;
+    gint64 start_time = startup_profile_init();
 
     /* The default values for the init flags */
     int default_init_flags = INIT_FLAG_NONE
@@ -586,6 +618,10 @@ main(int argc, char **argv)
     globalconf.mousegrabber = LUA_REFNIL;
     globalconf.exit_code = EXIT_SUCCESS;
     globalconf.api_level = awesome_default_api_level();
+    xrequest_init();
+#ifdef WITH_LUA_POOL_ALLOCATOR
+    globalconf.lua_pool_allocator = true;
+#endif
     buffer_init(&globalconf.startup_errors);
 
     /* save argv */
@@ -651,6 +687,8 @@ main(int argc, char **argv)
     if (!(default_init_flags & INIT_FLAG_FORCE_CMD_ARGS))
         options_init_config(&xdg, awesome_argv[0], confpath, &default_init_flags, &searchpath);
 
+    startup_profile_add("options", start_time);
+
     /* Setup pipe for SIGCHLD processing */
     if (!g_unix_open_pipe(sigchld_pipe, FD_CLOEXEC, NULL))
         fatal("Failed to create pipe");
@@ -660,6 +698,7 @@ main(int argc, char **argv)
     g_unix_signal_add(SIGINT, exit_on_signal, NULL);
     g_unix_signal_add(SIGTERM, exit_on_signal, NULL);
     g_unix_signal_add(SIGHUP, restart_on_signal, NULL);
+    g_unix_signal_add(SIGUSR2, luaA_profiler_toggle, NULL);
 
     struct sigaction sa = { .sa_handler = signal_fatal, .sa_flags = SA_RESETHAND };
     sigemptyset(&sa.sa_mask);
@@ -681,6 +720,7 @@ main(int argc, char **argv)
     globalconf.preferred_icon_size = 0;
 
     /* X stuff */
+    startup_profile_begin("X connection");
     globalconf.connection = xcb_connect(NULL, &globalconf.default_screen);
     if(xcb_connection_has_error(globalconf.connection))
         fatal("cannot open display (error %d)", xcb_connection_has_error(globalconf.connection));
@@ -728,12 +768,17 @@ main(int argc, char **argv)
 
     /* Did we get some usable data from the above X11 setup? */
     draw_test_cairo_xcb();
+    startup_profile_end();
 
     /* Acquire the WM_Sn selection */
+    startup_profile_begin("WM selection");
     acquire_WM_Sn(default_init_flags & INIT_FLAG_REPLACE_WM);
+    startup_profile_end();
 
     /* initialize dbus */
+    startup_profile_begin("D-Bus");
     a_dbus_init();
+    startup_profile_end();
 
     /* Get the file descriptor corresponding to the X connection */
     xfd = xcb_get_file_descriptor(globalconf.connection);
@@ -757,6 +802,8 @@ main(int argc, char **argv)
     /* Prefetch the maximum request length */
     xcb_prefetch_maximum_request_length(globalconf.connection);
 
+    startup_profile_begin("X extensions");
+
     /* check for xtest extension */
     const xcb_query_extension_reply_t *query;
     query = xcb_get_extension_data(globalconf.connection, &xcb_test_id);
@@ -782,7 +829,9 @@ main(int argc, char **argv)
     if (globalconf.have_xfixes)
         xcb_discard_reply(globalconf.connection,
                 xcb_xfixes_query_version(globalconf.connection, 1, 0).sequence);
+    startup_profile_end();
 
+    startup_profile_begin("X setup");
     event_init();
 
     /* Allocate the key symbols */
@@ -836,16 +885,21 @@ main(int argc, char **argv)
 
     /* we will receive events, stop grabbing server */
     xutil_ungrab_server(globalconf.connection);
+    startup_profile_end();
 
     /* get the current wallpaper, from now on we are informed when it changes */
+    startup_profile_begin("wallpaper");
     root_update_wallpaper();
+    startup_profile_end();
 
     /* init lua */
+    startup_profile_begin("Lua setup");
     luaA_init(&xdg, &searchpath);
     string_array_wipe(&searchpath);
     init_rng();
 
     ewmh_init_lua();
+    startup_profile_end();
 
     /* Parse and run configuration file before adding the screens */
     if (globalconf.no_auto_screen)
@@ -853,16 +907,25 @@ main(int argc, char **argv)
         /* Disable automatic screen creation, awful.screen has a fallback */
         globalconf.ignore_screens = true;
 
+        startup_profile_begin("rc.lua");
         if(!luaA_parserc(&xdg, confpath))
             fatal("couldn't find any rc file");
+        startup_profile_end();
     }
 
     /* init screens information */
+    startup_profile_begin("screens");
     screen_scan();
+    startup_profile_end();
 
     /* Parse and run configuration file after adding the screens */
-    if (((!globalconf.no_auto_screen) && !luaA_parserc(&xdg, confpath)))
-        fatal("couldn't find any rc file");
+    if (!globalconf.no_auto_screen)
+    {
+        startup_profile_begin("rc.lua");
+        if(!luaA_parserc(&xdg, confpath))
+            fatal("couldn't find any rc file");
+        startup_profile_end();
+    }
 
     p_delete(&confpath);
 
@@ -870,7 +933,9 @@ main(int argc, char **argv)
 
     /* Both screen scanning mode have this signal, it cannot be in screen_scan
        since the automatic screen generation don't have executed rc.lua yet. */
+    startup_profile_begin("screen scanned");
     screen_emit_scanned();
+    startup_profile_end();
 
     /* Exit if the user doesn't read the instructions properly */
     if (globalconf.no_auto_screen && !globalconf.screens.len)
@@ -878,14 +943,18 @@ main(int argc, char **argv)
               "screen object before or inside the screen \"scanned\" "
               " signal. Using AwesomeWM with no screen is **not supported**.");
 
+    startup_profile_begin("scan");
     client_emit_scanning();
 
     /* scan existing windows */
     scan(tree_c);
 
     client_emit_scanned();
+    startup_profile_end();
 
+    startup_profile_begin("startup signal");
     luaA_emit_startup();
+    startup_profile_end();
 
     /* Setup the main context */
     g_main_context_set_poll_func(g_main_context_default(), &a_glib_poll);
@@ -14,6 +14,16 @@ option(COMPRESS_MANPAGES "compress manpages" ON)
 option(GENERATE_DOC "generate API documentation" ON)
 option(DO_COVERAGE "build with coverage" OFF)
 autoOption(WITH_XCB_ERRORS "build with xcb-errors")
+option(WITH_LUA_POOL_ALLOCATOR "use the pooled Lua allocator by default" OFF)
+# Tracking X requests and round-trips replaces functions of libxcb, which only
+# debug and profiling builds should pay for.
+if(CMAKE_BUILD_TYPE MATCHES "^(Debug|RelWithDebInfo)$")
+    set(WITH_XCB_INTERPOSER_DEFAULT ON)
+else()
+    set(WITH_XCB_INTERPOSER_DEFAULT OFF)
+endif()
+option(WITH_XCB_INTERPOSER "track X requests and round-trips by interposing libxcb"
+    ${WITH_XCB_INTERPOSER_DEFAULT})
 if (GENERATE_DOC AND DO_COVERAGE)
     message(STATUS "Not generating API documentation with DO_COVERAGE")
     set(GENERATE_DOC OFF)
@@ -200,6 +210,7 @@ set(AWESOME_REQUIRED_LDFLAGS
     ${AWESOME_COMMON_REQUIRED_LDFLAGS}
     ${AWESOME_REQUIRED_LDFLAGS}
     ${LUA_LIBRARIES}
+    ${CMAKE_DL_LIBS}
     )
 
 set(AWESOME_REQUIRED_INCLUDE_DIRS
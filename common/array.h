@@ -23,6 +23,7 @@
 #ifndef AWESOME_COMMON_ARRAY_H
 #define AWESOME_COMMON_ARRAY_H
 
+#include <stdint.h>
 #include <stdlib.h>
 
 #include "common/util.h"
@@ -163,5 +164,139 @@
     ARRAY_TYPE(type_t, pfx) \
     BARRAY_FUNCS(type_t, pfx, dtor, cmp)
 
+/** Open addressing hash map type.
+ * Entries live in tab, and hashes holds the mixed hash of each slot, 0 for
+ * the empty ones, so that a zeroed map is a valid empty map. size is 0 or a
+ * power of two.
+ */
+#define HASHMAP_TYPE(type_t, pfx)                                           \
+    typedef struct pfx##_hashmap_t {                                        \
+        type_t *tab;                                                        \
+        unsigned long *hashes;                                              \
+        int len, size;                                                      \
+    } pfx##_hashmap_t;
+
+/** The number of slots of a map when its first entry is inserted */
+#define HASHMAP_MIN_SIZE 8
+
+#define hashmap_foreach(var, map) \
+    for(int __foreach_index_##var = 0; \
+        __foreach_index_##var < (map).size; \
+        __foreach_index_##var = (map).size) \
+        for(typeof((map).tab) var = NULL; \
+            __foreach_index_##var < (map).size; \
+            ++__foreach_index_##var) \
+            if((map).hashes[__foreach_index_##var] && \
+               (var = &(map).tab[__foreach_index_##var]))
+
+/** Spread the bits of a hash over the slots, and never return 0.
+ * \param hash The hash of an entry.
+ * \return The hash stored in the map.
+ */
+static inline unsigned long
+hashmap_mix(unsigned long hash)
+{
+    uint64_t h = hash;
+    h ^= h >> 33;
+    h *= UINT64_C(0xff51afd7ed558ccd);
+    h ^= h >> 33;
+    return (unsigned long) h ? (unsigned long) h : 1;
+}
+
+/** Hash map functions.
+ * Collisions are resolved with linear probing, and removal shifts the
+ * following entries back instead of leaving tombstones. Like with ordered
+ * arrays, pointers to entries are invalidated by insert and remove.
+ * hash returns an unsigned long for an entry, cmp returns 0 when two entries
+ * have the same key.
+ */
+#define HASHMAP_FUNCS(type_t, pfx, dtor, hash, cmp)                         \
+    static inline void pfx##_hashmap_init(pfx##_hashmap_t *map) {           \
+        p_clear(map, 1);                                                    \
+    }                                                                       \
+    static inline void pfx##_hashmap_wipe(pfx##_hashmap_t *map) {           \
+        for (int i = 0; i < map->size; i++) {                               \
+            if (map->hashes[i]) {                                           \
+                dtor(&map->tab[i]);                                         \
+            }                                                               \
+        }                                                                   \
+        p_delete(&map->tab);                                                \
+        p_delete(&map->hashes);                                             \
+        map->len = map->size = 0;                                           \
+    }                                                                       \
+    static inline void                                                      \
+    pfx##_hashmap_resize(pfx##_hashmap_t *map, int size)                    \
+    {                                                                       \
+        pfx##_hashmap_t old = *map;                                         \
+        int mask = size - 1;                                                \
+        map->tab = p_new(type_t, size);                                     \
+        map->hashes = p_new(unsigned long, size);                           \
+        map->size = size;                                                   \
+        for (int i = 0; i < old.size; i++) {                                \
+            if (!old.hashes[i])                                             \
+                continue;                                                   \
+            int j = old.hashes[i] & mask;                                   \
+            while (map->hashes[j])                                          \
+                j = (j + 1) & mask;                                         \
+            map->hashes[j] = old.hashes[i];                                 \
+            map->tab[j] = old.tab[i];                                       \
+        }                                                                   \
+        p_delete(&old.tab);                                                 \
+        p_delete(&old.hashes);                                              \
+    }                                                                       \
+    static inline type_t *                                                  \
+    pfx##_hashmap_lookup(pfx##_hashmap_t *map, type_t *e)                   \
+    {                                                                       \
+        if (!map->len)                                                      \
+            return NULL;                                                    \
+        unsigned long h = hashmap_mix(hash(e));                             \
+        int mask = map->size - 1;                                           \
+        for (int i = h & mask; map->hashes[i]; i = (i + 1) & mask)          \
+            if (map->hashes[i] == h && cmp(e, &map->tab[i]) == 0)           \
+                return &map->tab[i];                                        \
+        return NULL;                                                        \
+    }                                                                       \
+    static inline void                                                      \
+    pfx##_hashmap_insert(pfx##_hashmap_t *map, type_t e)                    \
+    {                                                                       \
+        unsigned long h = hashmap_mix(hash(&e));                            \
+        /* Keep the load factor under 3/4 */                                \
+        if ((map->len + 1) * 4 > map->size * 3)                             \
+            pfx##_hashmap_resize(map, map->size ? map->size * 2             \
+                                                : HASHMAP_MIN_SIZE);        \
+        int mask = map->size - 1;                                           \
+        int i = h & mask;                                                   \
+        for (; map->hashes[i]; i = (i + 1) & mask)                          \
+            if (map->hashes[i] == h && cmp(&e, &map->tab[i]) == 0)          \
+                return; /* Already added, ignore */                         \
+        map->hashes[i] = h;                                                 \
+        map->tab[i] = e;                                                    \
+        map->len++;                                                         \
+    }                                                                       \
+    static inline type_t                                                    \
+    pfx##_hashmap_remove(pfx##_hashmap_t *map, type_t *e)                   \
+    {                                                                       \
+        int mask = map->size - 1;                                           \
+        int i = e - map->tab;                                               \
+        type_t res = *e;                                                    \
+        /* Move back the entries which would not be found past the hole */  \
+        for (int j = (i + 1) & mask; map->hashes[j]; j = (j + 1) & mask) {  \
+            int home = map->hashes[j] & mask;                               \
+            if (((j - home) & mask) >= ((j - i) & mask)) {                  \
+                map->hashes[i] = map->hashes[j];                            \
+                map->tab[i] = map->tab[j];                                  \
+                i = j;                                                      \
+            }                                                               \
+        }                                                                   \
+        map->hashes[i] = 0;                                                 \
+        p_clear(&map->tab[i], 1);                                           \
+        map->len--;                                                         \
+        return res;                                                         \
+    }
+
+#define DO_HASHMAP(type_t, pfx, dtor, hash, cmp)                            \
+    HASHMAP_TYPE(type_t, pfx) \
+    HASHMAP_FUNCS(type_t, pfx, dtor, hash, cmp)
+
 #endif
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -24,6 +24,9 @@
 
 #define CONNECTED_SUFFIX "::connected"
 
+/** Maximum number of names which are not properties in a property cache */
+#define PROPERTIES_CACHE_MAX_MISSES 256
+
 DO_ARRAY(lua_class_t *, lua_class, DO_NOTHING)
 
 static lua_class_array_t luaA_classes;
@@ -195,7 +198,7 @@ static int
 luaA_class_gc(lua_State *L)
 {
     lua_object_t *item = lua_touserdata(L, 1);
-    signal_array_wipe(&item->signals);
+    signal_hashmap_wipe(&item->signals);
     /* Get the object class */
     lua_class_t *class = luaA_class_get(L, 1);
     class->instances--;
@@ -283,6 +286,10 @@ luaA_class_setup(lua_State *L, lua_class_t *class,
     class->index_miss_handler = LUA_REFNIL;
     class->newindex_miss_handler = LUA_REFNIL;
 
+    lua_newtable(L);
+    class->properties_cache = luaL_ref(L, LUA_REGISTRYINDEX);
+    class->properties_cache_misses = 0;
+
     lua_class_array_append(&luaA_classes, class);
 }
 
@@ -380,18 +387,14 @@ lua_class_property_array_getbyname(lua_class_property_array_t *arr,
     return lua_class_property_array_lookup(arr, &lookup_prop);
 }
 
-/** Get a property of a object.
- * \param L The Lua VM state.
+/** Find a property of a class or of its parents.
  * \param lua_class The Lua class.
- * \param fieldidx The index of the field name.
- * \return The object property if found, NULL otherwise.
+ * \param attr The property name.
+ * \return The property if found, NULL otherwise.
  */
 static lua_class_property_t *
-luaA_class_property_get(lua_State *L, lua_class_t *lua_class, int fieldidx)
+luaA_class_property_lookup(lua_class_t *lua_class, const char *attr)
 {
-    /* Lookup the property using token */
-    const char *attr = luaL_checkstring(L, fieldidx);
-
     /* Look for the property in the class; if not found, go in the parent class. */
     for(; lua_class; lua_class = lua_class->parent)
     {
@@ -405,6 +408,76 @@ luaA_class_property_get(lua_State *L, lua_class_t *lua_class, int fieldidx)
     return NULL;
 }
 
+/** Get a property of a object.
+ * \param L The Lua VM state.
+ * \param lua_class The Lua class.
+ * \param fieldidx The index of the field name.
+ * \return The object property if found, NULL otherwise.
+ */
+static lua_class_property_t *
+luaA_class_property_get(lua_State *L, lua_class_t *lua_class, int fieldidx)
+{
+    /* Lookup the property using token */
+    return luaA_class_property_lookup(lua_class, luaL_checkstring(L, fieldidx));
+}
+
+/* Markers cached for the field names which are not properties */
+static char field_missing, field_valid, field_private, field_data;
+
+static inline bool
+luaA_class_field_is_property(const void *field)
+{
+    return field != &field_missing && field != &field_valid
+        && field != &field_private && field != &field_data;
+}
+
+/** Resolve a field name to a property or to one of the field markers.
+ * Since Lua strings are interned, looking the name up in the cache table of
+ * the class is much cheaper than searching the properties of the class and
+ * of its parents. The properties must not change once the cache is used.
+ * \param L The Lua VM state.
+ * \param lua_class The Lua class.
+ * \param fieldidx The index of the field name.
+ * \return The property, or one of the field markers.
+ */
+static const void *
+luaA_class_field_resolve(lua_State *L, lua_class_t *lua_class, int fieldidx)
+{
+    fieldidx = luaA_absindex(L, fieldidx);
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, lua_class->properties_cache);
+    lua_pushvalue(L, fieldidx);
+    lua_rawget(L, -2);
+    const void *field = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    if(!field)
+    {
+        const char *attr = luaL_checkstring(L, fieldidx);
+
+        if(A_STREQ(attr, "valid"))
+            field = &field_valid;
+        else if(A_STREQ(attr, "_private"))
+            field = &field_private;
+        else if(A_STREQ(attr, "data"))
+            field = &field_data;
+        else if(!(field = luaA_class_property_lookup(lua_class, attr)))
+            field = &field_missing;
+
+        /* Arbitrary names would make the cache grow forever */
+        if(field != &field_missing
+           || lua_class->properties_cache_misses++ < PROPERTIES_CACHE_MAX_MISSES)
+        {
+            lua_pushvalue(L, fieldidx);
+            lua_pushlightuserdata(L, (void *) field);
+            lua_rawset(L, -3);
+        }
+    }
+
+    lua_pop(L, 1);
+    return field;
+}
+
 /** Generic index meta function for objects.
  * \param L The Lua VM state.
  * \return The number of elements pushed on stack.
@@ -417,11 +490,11 @@ luaA_class_index(lua_State *L)
         return 1;
 
     lua_class_t *class = luaA_class_get(L, 1);
+    const void *field = luaA_class_field_resolve(L, class, 2);
 
     /* Is this the special 'valid' property? This is the only property
      * accessible for invalid objects and thus needs special handling. */
-    const char *attr = luaL_checkstring(L, 2);
-    if (A_STREQ(attr, "valid"))
+    if (field == &field_valid)
     {
         void *p = luaA_toudata(L, 1, class);
         if (class->checker)
@@ -431,18 +504,16 @@ luaA_class_index(lua_State *L)
         return 1;
     }
 
-    lua_class_property_t *prop = luaA_class_property_get(L, class, 2);
-
     /* This is the table storing the object private variables.
      */
-    if (A_STREQ(attr, "_private"))
+    if (field == &field_private)
     {
         luaA_checkudata(L, 1, class);
         luaA_getuservalue(L, 1);
         lua_getfield(L, -1, "data");
         return 1;
     }
-    else if (A_STREQ(attr, "data"))
+    else if (field == &field_data)
     {
         luaA_deprecate(L, "Use `._private` instead of `.data`");
         luaA_checkudata(L, 1, class);
@@ -452,8 +523,9 @@ luaA_class_index(lua_State *L)
     }
 
     /* Property does exist and has an index callback */
-    if(prop)
+    if(field != &field_missing)
     {
+        const lua_class_property_t *prop = field;
         if(prop->index)
             return prop->index(L, luaA_checkudata(L, 1, class));
     }
@@ -480,12 +552,12 @@ luaA_class_newindex(lua_State *L)
         return 1;
 
     lua_class_t *class = luaA_class_get(L, 1);
-
-    lua_class_property_t *prop = luaA_class_property_get(L, class, 2);
+    const void *field = luaA_class_field_resolve(L, class, 2);
 
     /* Property does exist and has a newindex callback */
-    if(prop)
+    if(luaA_class_field_is_property(field))
     {
+        const lua_class_property_t *prop = field;
         if(prop->newindex)
             return prop->newindex(L, luaA_checkudata(L, 1, class));
     }
@@ -500,6 +572,176 @@ luaA_class_newindex(lua_State *L)
     return 0;
 }
 
+/** Get several properties of an object at once.
+ *
+ * This is faster than indexing the object for each property.
+ *
+ * @tparam table names The names of the properties.
+ * @treturn table The values of the properties, indexed by their names.
+ * @method get_properties
+ */
+int
+luaA_class_get_properties(lua_State *L)
+{
+    lua_class_t *class = luaA_class_get(L, 1);
+    void *object = luaA_checkudata(L, 1, class);
+    luaA_checktable(L, 2);
+    lua_settop(L, 2);
+
+    int len = luaA_rawlen(L, 2);
+    lua_createtable(L, 0, len);
+
+    for(int i = 1; i <= len; i++)
+    {
+        lua_rawgeti(L, 2, i);
+        const void *field = luaA_class_field_resolve(L, class, -1);
+        const lua_class_property_t *prop = field;
+
+        if(luaA_class_field_is_property(field) && prop->index)
+        {
+            /* Getters expect the object and the key on the stack */
+            lua_pushvalue(L, 1);
+            lua_pushvalue(L, -2);
+            int nret = prop->index(L, object);
+            /* Only keep the first value */
+            if(nret == 0)
+                lua_pushnil(L);
+            else
+                lua_pop(L, nret - 1);
+            lua_replace(L, -3);
+            lua_pop(L, 1);
+        }
+        else
+        {
+            /* Methods, special fields and properties handled by Lua */
+            lua_pushcfunction(L, luaA_class_index);
+            lua_pushvalue(L, 1);
+            lua_pushvalue(L, -3);
+            lua_call(L, 2, 1);
+        }
+
+        lua_rawset(L, 3);
+    }
+
+    return 1;
+}
+
+static int
+luaA_class_property_name_cmp(const void *a, const void *b)
+{
+    return a_strcmp(*(const char * const *) a, *(const char * const *) b);
+}
+
+/** Apply the properties to an object, called protected by
+ * luaA_class_set_properties().
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_class_set_properties_protected(lua_State *L)
+{
+    cptr_array_t *names = lua_touserdata(L, 3);
+    lua_class_t *class = luaA_class_get(L, 1);
+    void *object = luaA_checkudata(L, 1, class);
+
+    foreach(name, *names)
+    {
+        lua_class_property_t *prop = luaA_class_property_lookup(class, *name);
+
+        if(prop && prop->newindex)
+        {
+            /* Setters expect the object, the key and the value on the stack */
+            lua_pushvalue(L, 1);
+            lua_pushstring(L, *name);
+            lua_getfield(L, 2, *name);
+            prop->newindex(L, object);
+        }
+        else
+        {
+            lua_pushcfunction(L, luaA_class_newindex);
+            lua_pushvalue(L, 1);
+            lua_pushstring(L, *name);
+            lua_getfield(L, 2, *name);
+            lua_call(L, 3, 0);
+        }
+
+        lua_settop(L, 3);
+    }
+
+    return 0;
+}
+
+/** Add a traceback to an error of a setter, since the error is raised again
+ * from luaA_class_set_properties() where its location would be lost.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_class_set_properties_traceback(lua_State *L)
+{
+    lua_getglobal(L, "debug");
+    lua_getfield(L, -1, "traceback");
+    lua_pushvalue(L, 1);
+    lua_pushinteger(L, 2);
+    lua_call(L, 2, 1);
+    return 1;
+}
+
+/** Set several properties of an object at once.
+ *
+ * The properties are applied in the alphabetical order of their names, not in
+ * the order of the table. So `{ width = 10, x = 5 }` sets `width` first. The
+ * property signals they cause are batched like with `awesome.batch`, so that
+ * each one is only emitted once, after all properties were set. Errors of the
+ * setters are raised again with a traceback.
+ *
+ * @tparam table properties The new values, indexed by property names.
+ * @noreturn
+ * @method set_properties
+ */
+int
+luaA_class_set_properties(lua_State *L)
+{
+    lua_class_t *class = luaA_class_get(L, 1);
+    luaA_checkudata(L, 1, class);
+    luaA_checktable(L, 2);
+    lua_settop(L, 2);
+
+    cptr_array_t names;
+    cptr_array_init(&names);
+
+    lua_pushnil(L);
+    while(lua_next(L, 2))
+    {
+        lua_pop(L, 1);
+        /* Do not use lua_isstring(), numbers would be converted and confuse
+         * lua_next() */
+        if(lua_type(L, -1) != LUA_TSTRING)
+        {
+            cptr_array_wipe(&names);
+            return luaL_error(L, "property names must be strings, got %s",
+                              luaL_typename(L, -1));
+        }
+        /* The string is kept alive by the table */
+        cptr_array_append(&names, lua_tostring(L, -1));
+    }
+    qsort(names.tab, names.len, sizeof(*names.tab), luaA_class_property_name_cmp);
+
+    luaA_object_batch_begin();
+    lua_pushcfunction(L, luaA_class_set_properties_traceback);
+    lua_pushcfunction(L, luaA_class_set_properties_protected);
+    lua_pushvalue(L, 1);
+    lua_pushvalue(L, 2);
+    lua_pushlightuserdata(L, &names);
+    int status = lua_pcall(L, 3, 0, 3);
+    luaA_object_batch_end(L);
+    cptr_array_wipe(&names);
+
+    if(status != 0)
+        return lua_error(L);
+    return 0;
+}
+
 /** Generic constructor function for objects.
  * \param L The Lua VM state.
  * \return The number of elements pushed on stack.
@@ -536,5 +778,6 @@ luaA_class_new(lua_State *L, lua_class_t *lua_class)
 }
 
 #undef CONNECTED_SUFFIX
+#undef PROPERTIES_CACHE_MAX_MISSES
 
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -28,7 +28,7 @@
 #include <lauxlib.h>
 
 #define LUA_OBJECT_HEADER \
-        signal_array_t signals;
+        signal_hashmap_t signals;
 
 /** Generic type for all objects.
  * All Lua objects can be casted to this type.
@@ -66,7 +66,7 @@ struct lua_class_t
     /** Class name */
     const char *name;
     /** Class signals */
-    signal_array_t signals;
+    signal_hashmap_t signals;
     /** Parent class */
     lua_class_t *parent;
     /** Allocator for creating new objects of that class */
@@ -75,6 +75,11 @@ struct lua_class_t
     lua_class_collector_t collector;
     /** Class properties */
     lua_class_property_array_t properties;
+    /** Registry reference of the table caching the resolution of field names
+     * to properties */
+    int properties_cache;
+    /** Number of names cached which are not properties */
+    int properties_cache_misses;
     /** Function to call when a indexing an unknown property */
     lua_class_propfunc_t index_miss_property;
     /** Function to call when a indexing an unknown property */
@@ -113,6 +118,8 @@ void luaA_class_add_properties(lua_class_t *, const lua_class_property_t[] , int
 int luaA_usemetatable(lua_State *, int, int);
 int luaA_class_index(lua_State *);
 int luaA_class_newindex(lua_State *);
+int luaA_class_get_properties(lua_State *);
+int luaA_class_set_properties(lua_State *);
 int luaA_class_new(lua_State *, lua_class_t *);
 
 void * luaA_checkudata(lua_State *, int, lua_class_t *);
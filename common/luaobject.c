@@ -30,23 +30,179 @@
 #include "common/luaobject.h"
 #include "common/backtrace.h"
 
+/** Only property signals without arguments are batched, as they can be merged */
+#define BATCH_PREFIX "property::"
+
+/** A signal queued while batching */
+typedef struct
+{
+    /** The object, referenced in the object registry */
+    const void *object;
+    /** The hash of the signal name */
+    unsigned long id;
+    /** The signal name */
+    char *name;
+    /** The order in which signals were first emitted */
+    int seq;
+} batch_signal_t;
+
+static int
+batch_signal_cmp(const void *a, const void *b)
+{
+    const batch_signal_t *x = a, *y = b;
+    if(x->object != y->object)
+        return x->object > y->object ? 1 : -1;
+    return x->id > y->id ? 1 : (x->id < y->id ? -1 : 0);
+}
+
+static int
+batch_signal_seq_cmp(const void *a, const void *b)
+{
+    const batch_signal_t *x = a, *y = b;
+    return x->seq - y->seq;
+}
+
+static void
+batch_signal_wipe(batch_signal_t *sig)
+{
+    p_delete(&sig->name);
+}
+
+DO_BARRAY(batch_signal_t, batch_signal, batch_signal_wipe, batch_signal_cmp)
+
+/** The number of batches being run */
+static int batch_depth;
+/** The signals queued by the running batches */
+static batch_signal_array_t batch_signals;
+
+/** An object referenced by C code */
+typedef struct
+{
+    /** The object pointer */
+    const void *pointer;
+    /** The registry slot holding the object */
+    int ref;
+    /** The number of references */
+    int count;
+} object_ref_t;
+
+static int
+object_ref_cmp(const void *a, const void *b)
+{
+    const object_ref_t *x = a, *y = b;
+    return x->pointer > y->pointer ? 1 : (x->pointer < y->pointer ? -1 : 0);
+}
+
+static unsigned long
+object_ref_hash(const void *a)
+{
+    return (uintptr_t) ((const object_ref_t *) a)->pointer;
+}
+
+DO_HASHMAP(object_ref_t, object_ref, DO_NOTHING, object_ref_hash, object_ref_cmp)
+
+/** The objects referenced by C code, by pointer */
+static object_ref_hashmap_t object_refs;
+
+static object_ref_t *
+object_ref_getbypointer(const void *pointer)
+{
+    object_ref_t lookup = { .pointer = pointer };
+    return object_ref_hashmap_lookup(&object_refs, &lookup);
+}
+
 /** Setup the object system at startup.
  * \param L The Lua VM state.
  */
 void
 luaA_object_setup(lua_State *L)
 {
-    /* Push identification string */
-    lua_pushliteral(L, LUAA_OBJECT_REGISTRY_KEY);
-    /* Create an empty table */
-    lua_newtable(L);
-    /* Create an empty metatable */
-    lua_newtable(L);
-    /* Set this empty table as the registry metatable.
-     * It's used to store the number of reference on stored objects. */
-    lua_setmetatable(L, -2);
-    /* Register table inside registry */
-    lua_rawset(L, LUA_REGISTRYINDEX);
+    /* References of a previous Lua VM are meaningless */
+    object_ref_hashmap_wipe(&object_refs);
+    object_ref_hashmap_init(&object_refs);
+}
+
+/** Reference an object and return a pointer to it.
+ * That only works with userdata, table, thread or function.
+ * The reference counts are kept in C and each object gets a single slot in
+ * the registry, so that pushing it back is cheap.
+ * \param L The Lua VM state.
+ * \param oud The object index on the stack, it is removed from the stack.
+ * \return The object reference, or NULL if not referenceable.
+ */
+void *
+luaA_object_ref(lua_State *L, int oud)
+{
+    void *pointer = (void *) lua_topointer(L, oud);
+
+    /* Not reference able. */
+    if(!pointer)
+    {
+        lua_remove(L, oud);
+        return NULL;
+    }
+
+    object_ref_t *ref = object_ref_getbypointer(pointer);
+    if(ref)
+    {
+        ref->count++;
+        lua_remove(L, oud);
+    }
+    else
+    {
+        lua_pushvalue(L, oud);
+        object_ref_hashmap_insert(&object_refs, (object_ref_t) {
+            .pointer = pointer,
+            .ref = luaL_ref(L, LUA_REGISTRYINDEX),
+            .count = 1
+        });
+        lua_remove(L, oud);
+    }
+
+    return pointer;
+}
+
+/** Unreference an object.
+ * \param L The Lua VM state.
+ * \param pointer The object reference.
+ */
+void
+luaA_object_unref(lua_State *L, const void *pointer)
+{
+    if(!pointer)
+        return;
+
+    object_ref_t *ref = object_ref_getbypointer(pointer);
+    if(!ref)
+    {
+        buffer_t buf;
+        backtrace_get(&buf);
+        warn("BUG: Reference not found: %p\n%s", pointer, buf.s);
+        buffer_wipe(&buf);
+        return;
+    }
+
+    if(--ref->count == 0)
+    {
+        luaL_unref(L, LUA_REGISTRYINDEX, ref->ref);
+        object_ref_hashmap_remove(&object_refs, ref);
+    }
+}
+
+/** Push a referenced object onto the stack.
+ * \param L The Lua VM state.
+ * \param pointer The object to push.
+ * \return The number of element pushed on stack.
+ */
+int
+luaA_object_push(lua_State *L, const void *pointer)
+{
+    object_ref_t *ref = object_ref_getbypointer(pointer);
+    if(ref)
+        lua_rawgeti(L, LUA_REGISTRYINDEX, ref->ref);
+    else
+        lua_pushnil(L);
+    return 1;
 }
 
 /** Increment a object reference in its store table.
@@ -228,9 +384,9 @@ luaA_object_disconnect_signal_from_stack(lua_State *L, int oud,
 }
 
 void
-signal_object_emit(lua_State *L, signal_array_t *arr, const char *name, int nargs)
+signal_object_emit(lua_State *L, signal_hashmap_t *map, const char *name, int nargs)
 {
-    signal_t *sigfound = signal_array_getbyname(arr, name);
+    signal_t *sigfound = signal_hashmap_getbyname(map, name);
 
     if(sigfound)
     {
@@ -258,14 +414,9 @@ signal_object_emit(lua_State *L, signal_array_t *arr, const char *name, int narg
     lua_pop(L, nargs);
 }
 
-/** Emit a signal.
- * @tparam string name A signal name.
- * @param[opt] ... Various arguments.
- * @function emit_signal
- */
-void
-luaA_object_emit_signal(lua_State *L, int oud,
-                        const char *name, int nargs)
+static void
+object_emit_signal(lua_State *L, int oud,
+                   const char *name, int nargs, bool batch)
 {
     int oud_abs = luaA_absindex(L, oud);
     lua_class_t *lua_class = luaA_class_get(L, oud);
@@ -278,7 +429,25 @@ luaA_object_emit_signal(lua_State *L, int oud,
         luaA_warn(L, "Trying to emit signal '%s' on invalid object", name);
         return;
     }
-    signal_t *sigfound = signal_array_getbyname(&obj->signals, name);
+    if(batch && batch_depth > 0 && nargs == 0
+       && !a_strncmp(name, BATCH_PREFIX, sizeof(BATCH_PREFIX) - 1))
+    {
+        batch_signal_t sig = {
+            .object = obj,
+            .id = a_strhash((const unsigned char *) name),
+        };
+        /* Already queued, it will only be emitted once */
+        if(batch_signal_array_lookup(&batch_signals, &sig))
+            return;
+        /* Keep the object alive until the signal is emitted */
+        lua_pushvalue(L, oud_abs);
+        luaA_object_ref(L, -1);
+        sig.name = a_strdup(name);
+        sig.seq = batch_signals.len;
+        batch_signal_array_insert(&batch_signals, sig);
+        return;
+    }
+    signal_t *sigfound = signal_hashmap_getbyname(&obj->signals, name);
     if(sigfound)
     {
         int nbfunc = sigfound->sigfuncs.len;
@@ -309,6 +478,57 @@ luaA_object_emit_signal(lua_State *L, int oud,
     luaA_class_emit_signal(L, luaA_class_get(L, - nargs - 1), name, nargs + 1);
 }
 
+/** Emit a signal.
+ * @tparam string name A signal name.
+ * @param[opt] ... Various arguments.
+ * @function emit_signal
+ */
+void
+luaA_object_emit_signal(lua_State *L, int oud,
+                        const char *name, int nargs)
+{
+    object_emit_signal(L, oud, name, nargs, true);
+}
+
+/** Start batching the property signals emitted on objects.
+ * Batches can be nested, the signals are emitted when the outermost ends.
+ */
+void
+luaA_object_batch_begin(void)
+{
+    batch_depth++;
+}
+
+/** End a batch, and emit its signals if it is the outermost one.
+ * Each signal is emitted once per object, in the order the signals were first
+ * emitted in. Objects which became invalid in the meantime are skipped.
+ * \param L The Lua VM state.
+ */
+void
+luaA_object_batch_end(lua_State *L)
+{
+    if(--batch_depth > 0)
+        return;
+
+    /* Signals emitted from now on do not go in this queue */
+    batch_signal_array_t queue = batch_signals;
+    batch_signal_array_init(&batch_signals);
+    qsort(queue.tab, queue.len, sizeof(*queue.tab), batch_signal_seq_cmp);
+
+    foreach(sig, queue)
+    {
+        luaA_object_push(L, sig->object);
+        lua_class_t *lua_class = luaA_class_get(L, -1);
+        lua_object_t *obj = luaA_toudata(L, -1, lua_class);
+        if(obj && (!lua_class->checker || lua_class->checker(obj)))
+            object_emit_signal(L, -1, sig->name, 0, false);
+        lua_pop(L, 1);
+        luaA_object_unref(L, sig->object);
+    }
+
+    batch_signal_array_wipe(&queue);
+}
+
 int
 luaA_object_connect_signal_simple(lua_State *L)
 {
@@ -326,7 +546,8 @@ luaA_object_disconnect_signal_simple(lua_State *L)
 int
 luaA_object_emit_signal_simple(lua_State *L)
 {
-    luaA_object_emit_signal(L, 1, luaL_checkstring(L, 2), lua_gettop(L) - 2);
+    /* Signals emitted from Lua are never batched */
+    object_emit_signal(L, 1, luaL_checkstring(L, 2), lua_gettop(L) - 2, false);
     return 0;
 }
 
@@ -25,12 +25,13 @@
 #include "common/luaclass.h"
 #include "luaa.h"
 
-#define LUAA_OBJECT_REGISTRY_KEY "awesome.object.registry"
-
 int luaA_settype(lua_State *, lua_class_t *);
 void luaA_object_setup(lua_State *);
 void * luaA_object_incref(lua_State *, int, int);
 void luaA_object_decref(lua_State *, int, const void *);
+void * luaA_object_ref(lua_State *, int);
+void luaA_object_unref(lua_State *, const void *);
+int luaA_object_push(lua_State *, const void *);
 
 /** Store an item in the environment table of an object.
  * \param L The Lua VM state.
@@ -85,28 +86,6 @@ luaA_object_push_item(lua_State *L, int ud, const void *pointer)
     return 1;
 }
 
-static inline void
-luaA_object_registry_push(lua_State *L)
-{
-    lua_pushliteral(L, LUAA_OBJECT_REGISTRY_KEY);
-    lua_rawget(L, LUA_REGISTRYINDEX);
-}
-
-/** Reference an object and return a pointer to it.
- * That only works with userdata, table, thread or function.
- * \param L The Lua VM state.
- * \param oud The object index on the stack.
- * \return The object reference, or NULL if not referenceable.
- */
-static inline void *
-luaA_object_ref(lua_State *L, int oud)
-{
-    luaA_object_registry_push(L);
-    void *p = luaA_object_incref(L, -1, oud < 0 ? oud - 1 : oud);
-    lua_pop(L, 1);
-    return p;
-}
-
 /** Reference an object and return a pointer to it checking its type.
  * That only works with userdata.
  * \param L The Lua VM state.
@@ -121,41 +100,15 @@ luaA_object_ref_class(lua_State *L, int oud, lua_class_t *class)
     return luaA_object_ref(L, oud);
 }
 
-/** Unreference an object and return a pointer to it.
- * That only works with userdata, table, thread or function.
- * \param L The Lua VM state.
- * \param oud The object index on the stack.
- */
-static inline void
-luaA_object_unref(lua_State *L, const void *pointer)
-{
-    luaA_object_registry_push(L);
-    luaA_object_decref(L, -1, pointer);
-    lua_pop(L, 1);
-}
-
-/** Push a referenced object onto the stack.
- * \param L The Lua VM state.
- * \param pointer The object to push.
- * \return The number of element pushed on stack.
- */
-static inline int
-luaA_object_push(lua_State *L, const void *pointer)
-{
-    luaA_object_registry_push(L);
-    lua_pushlightuserdata(L, (void *) pointer);
-    lua_rawget(L, -2);
-    lua_remove(L, -2);
-    return 1;
-}
-
-void signal_object_emit(lua_State *, signal_array_t *, const char *, int);
+void signal_object_emit(lua_State *, signal_hashmap_t *, const char *, int);
 
 void luaA_object_connect_signal(lua_State *, int, const char *, lua_CFunction);
 void luaA_object_disconnect_signal(lua_State *, int, const char *, lua_CFunction);
 void luaA_object_connect_signal_from_stack(lua_State *, int, const char *, int);
 void luaA_object_disconnect_signal_from_stack(lua_State *, int, const char *, int);
 void luaA_object_emit_signal(lua_State *, int, const char *, int);
+void luaA_object_batch_begin(void);
+void luaA_object_batch_end(lua_State *);
 
 int luaA_object_connect_signal_simple(lua_State *);
 int luaA_object_disconnect_signal_simple(lua_State *);
@@ -212,7 +165,9 @@ int luaA_object_tostring(lua_State *);
     { "__tostring", luaA_object_tostring }, \
     { "connect_signal", luaA_object_connect_signal_simple }, \
     { "disconnect_signal", luaA_object_disconnect_signal_simple }, \
-    { "emit_signal", luaA_object_emit_signal_simple },
+    { "emit_signal", luaA_object_emit_signal_simple }, \
+    { "get_properties", luaA_class_get_properties }, \
+    { "set_properties", luaA_class_set_properties },
 
 #endif
 
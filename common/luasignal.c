@@ -0,0 +1,480 @@
+/*
+ * luasignal.c - signals of Lua tables
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * This is the backend of the signals of gears.object, exported as
+ * awesome._object_signals. Each object holds a signal store in its _signals
+ * field, and the functions take the object as first argument, so that they
+ * can be used as its methods directly.
+ *
+ * A store keeps the strongly and the weakly connected functions in two signal
+ * maps. Strong functions are referenced in the environment table of the
+ * store, like the items of C objects. Weak functions are only in a table
+ * with weak values, also kept in the environment. Since a weak function can
+ * be collected and its address reused, its pointer stays in the signal map
+ * until it is found dead, and is removed from everywhere before the same
+ * address is connected weakly again.
+ */
+
+#include "common/luasignal.h"
+#include "common/luaobject.h"
+
+/** The name of the metatable of signal stores in the registry */
+#define SIGNAL_STORE_TYPE "awesome.signal_store"
+
+/** The key of the table of weak functions in the environment table */
+#define SIGNAL_STORE_WEAK "weak"
+
+typedef struct
+{
+    /** The strongly connected functions */
+    signal_hashmap_t strong;
+    /** The weakly connected functions */
+    signal_hashmap_t weak;
+    /** Incremented by disconnections, so that emissions notice them */
+    unsigned int disconnects;
+} signal_store_t;
+
+/** The metatable of signal stores, to recognize them */
+static const void *signal_store_metatable;
+
+/** Get the signal store of the object at index 1.
+ * The store is pushed on the stack.
+ * \param L The Lua VM state.
+ * \return The signal store.
+ */
+static signal_store_t *
+signal_store_check(lua_State *L)
+{
+    if(lua_type(L, 1) == LUA_TTABLE)
+    {
+        lua_getfield(L, 1, "_signals");
+        signal_store_t *store = lua_touserdata(L, -1);
+        if(store && lua_getmetatable(L, -1))
+        {
+            bool valid = lua_topointer(L, -1) == signal_store_metatable;
+            lua_pop(L, 1);
+            if(valid)
+                return store;
+        }
+    }
+    luaL_error(L, "called on non-object");
+    return NULL;
+}
+
+static const char *
+signal_store_checkname(lua_State *L, int idx)
+{
+    if(lua_type(L, idx) != LUA_TSTRING)
+        luaL_error(L, "name must be a string, got: %s", luaL_typename(L, idx));
+    return lua_tostring(L, idx);
+}
+
+/** Check whether a function is connected to a signal.
+ * \param map The signal map.
+ * \param name The signal name.
+ * \param ref The function.
+ * \return True if the function is connected.
+ */
+static bool
+signal_store_has(signal_hashmap_t *map, const char *name, const void *ref)
+{
+    signal_t *sig = signal_hashmap_getbyname(map, name);
+    if(sig)
+        foreach(func, sig->sigfuncs)
+            if(*func == ref)
+                return true;
+    return false;
+}
+
+/** Remove a function from every signal of a map.
+ * \param map The signal map.
+ * \param ref The function.
+ */
+static void
+signal_store_purge(signal_hashmap_t *map, const void *ref)
+{
+    bool removed;
+
+    /* Removing a signal moves the others, so start over after that */
+    do
+    {
+        removed = false;
+        hashmap_foreach(sig, *map)
+        {
+            foreach(func, sig->sigfuncs)
+                if(*func == ref)
+                {
+                    cptr_array_remove(&sig->sigfuncs, func);
+                    break;
+                }
+            if(sig->sigfuncs.len == 0)
+            {
+                signal_wipe(sig);
+                signal_hashmap_remove(map, sig);
+                removed = true;
+                break;
+            }
+        }
+    } while(removed);
+}
+
+/** Push the table of weak functions of a store.
+ * \param L The Lua VM state.
+ * \param env The absolute index of the environment table of the store.
+ */
+static void
+signal_store_push_weak(lua_State *L, int env)
+{
+    lua_getfield(L, env, SIGNAL_STORE_WEAK);
+    if(lua_isnil(L, -1))
+    {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_newtable(L);
+        lua_pushliteral(L, "v");
+        lua_setfield(L, -2, "__mode");
+        lua_setmetatable(L, -2);
+        lua_pushvalue(L, -1);
+        lua_setfield(L, env, SIGNAL_STORE_WEAK);
+    }
+}
+
+/** Push a weakly connected function.
+ * Nil is pushed if it was collected.
+ * \param L The Lua VM state.
+ * \param weak The index of the table of weak functions.
+ * \param ref The function.
+ */
+static void
+signal_store_push_weak_func(lua_State *L, int weak, const void *ref)
+{
+    lua_pushlightuserdata(L, (void *) ref);
+    lua_rawget(L, weak);
+    /* The proxy userdata of Lua 5.1 keeps the function in its environment */
+    if(lua_type(L, -1) == LUA_TUSERDATA)
+    {
+        luaA_getuservalue(L, -1);
+        lua_rawgeti(L, -1, 1);
+        lua_replace(L, -3);
+        lua_pop(L, 1);
+    }
+}
+
+/** Create a signal store.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lreturn A new signal store.
+ */
+static int
+luaA_signal_store_new(lua_State *L)
+{
+    signal_store_t *store = lua_newuserdata(L, sizeof(signal_store_t));
+    p_clear(store, 1);
+    luaL_getmetatable(L, SIGNAL_STORE_TYPE);
+    lua_setmetatable(L, -2);
+    /* The environment references the strong functions, and its metatable
+     * counts these references */
+    lua_newtable(L);
+    lua_newtable(L);
+    lua_setmetatable(L, -2);
+    luaA_setuservalue(L, -2);
+    return 1;
+}
+
+static int
+luaA_signal_store_gc(lua_State *L)
+{
+    signal_store_t *store = lua_touserdata(L, 1);
+    signal_hashmap_wipe(&store->strong);
+    signal_hashmap_wipe(&store->weak);
+    return 0;
+}
+
+/** Connect a function to a signal of an object.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam The object.
+ * \lparam The signal name.
+ * \lparam The function.
+ */
+static int
+luaA_signal_store_connect(lua_State *L)
+{
+    lua_settop(L, 3);
+    if(lua_type(L, 3) != LUA_TFUNCTION)
+        luaL_error(L, "callback must be a function, got: %s", luaL_typename(L, 3));
+    signal_store_t *store = signal_store_check(L);
+    int sud = lua_gettop(L);
+    const char *name = signal_store_checkname(L, 2);
+    const void *ref = lua_topointer(L, 3);
+
+    if(signal_store_has(&store->weak, name, ref))
+    {
+        luaA_getuservalue(L, sud);
+        signal_store_push_weak(L, lua_gettop(L));
+        signal_store_push_weak_func(L, lua_gettop(L), ref);
+        /* A dead function at the same address is not this one */
+        if(lua_rawequal(L, -1, 3))
+            luaL_error(L, "Trying to connect a strong callback which is already connected weakly");
+        lua_pop(L, 3);
+    }
+
+    if(!signal_store_has(&store->strong, name, ref))
+    {
+        lua_pushvalue(L, 3);
+        luaA_object_ref_item(L, sud, -1);
+        signal_connect(&store->strong, name, ref);
+    }
+
+    return 0;
+}
+
+/** Connect a function weakly to a signal of an object.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam The object.
+ * \lparam The signal name.
+ * \lparam The function.
+ * \lparam The value to keep in the weak table, a userdata bound to the
+ * function with Lua 5.1, or the function itself.
+ */
+static int
+luaA_signal_store_weak_connect(lua_State *L)
+{
+    if(lua_type(L, 3) != LUA_TFUNCTION)
+        luaL_error(L, "callback must be a function, got: %s", luaL_typename(L, 3));
+    lua_settop(L, 4);
+    signal_store_t *store = signal_store_check(L);
+    int sud = lua_gettop(L);
+    const char *name = signal_store_checkname(L, 2);
+    const void *ref = lua_topointer(L, 3);
+
+    if(signal_store_has(&store->strong, name, ref))
+        luaL_error(L, "Trying to connect a weak callback which is already connected strongly");
+
+    luaA_getuservalue(L, sud);
+    signal_store_push_weak(L, lua_gettop(L));
+    int weak = lua_gettop(L);
+
+    lua_pushlightuserdata(L, (void *) ref);
+    lua_rawget(L, weak);
+    /* Dead functions at this address are left in the signals */
+    if(lua_isnil(L, -1))
+        signal_store_purge(&store->weak, ref);
+    lua_pop(L, 1);
+
+    if(lua_type(L, 4) == LUA_TUSERDATA)
+    {
+        lua_createtable(L, 1, 0);
+        lua_pushvalue(L, 3);
+        lua_rawseti(L, -2, 1);
+        luaA_setuservalue(L, 4);
+    }
+    else
+    {
+        lua_pushvalue(L, 3);
+        lua_replace(L, 4);
+    }
+    lua_pushlightuserdata(L, (void *) ref);
+    lua_pushvalue(L, 4);
+    lua_rawset(L, weak);
+
+    if(!signal_store_has(&store->weak, name, ref))
+        signal_connect(&store->weak, name, ref);
+
+    return 0;
+}
+
+/** Disconnect a function from a signal of an object.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam The object.
+ * \lparam The signal name.
+ * \lparam The function.
+ */
+static int
+luaA_signal_store_disconnect(lua_State *L)
+{
+    lua_settop(L, 3);
+    signal_store_t *store = signal_store_check(L);
+    int sud = lua_gettop(L);
+    const char *name = signal_store_checkname(L, 2);
+    const void *ref = lua_topointer(L, 3);
+
+    if(!ref)
+        return 0;
+
+    if(signal_disconnect(&store->strong, name, ref))
+        luaA_object_unref_item(L, sud, (void *) ref);
+    signal_disconnect(&store->weak, name, ref);
+    store->disconnects++;
+
+    return 0;
+}
+
+/** Emit a signal on an object.
+ * The functions receive the object and the arguments. The strong functions
+ * are called first, then the weak ones, then the global receivers of the
+ * object. Functions disconnected by a previous one are not called.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam The object.
+ * \lparam The signal name.
+ * \lparam The arguments.
+ */
+static int
+luaA_signal_store_emit(lua_State *L)
+{
+    int top = lua_gettop(L);
+    signal_store_t *store = signal_store_check(L);
+    const char *name = signal_store_checkname(L, 2);
+    int nargs = top - 2;
+    int nstrong = 0, nweak = 0;
+
+    signal_t *strong = signal_hashmap_getbyname(&store->strong, name);
+    signal_t *weak = signal_hashmap_getbyname(&store->weak, name);
+
+    if(strong || weak)
+    {
+        luaA_getuservalue(L, top + 1);
+        int env = lua_gettop(L);
+        int base = env + 1;
+
+        luaL_checkstack(L, (strong ? strong->sigfuncs.len : 0)
+                        + (weak ? weak->sigfuncs.len : 0) + nargs + 3,
+                        "too much signal");
+
+        /* Push all functions and then execute, because this list can change
+         * while executing funcs. */
+        if(strong)
+            foreach(func, strong->sigfuncs)
+            {
+                lua_pushlightuserdata(L, (void *) *func);
+                lua_rawget(L, env);
+                nstrong++;
+            }
+
+        if(weak)
+        {
+            signal_store_push_weak(L, env);
+            int weakt = lua_gettop(L);
+            for(int i = 0; i < weak->sigfuncs.len;)
+            {
+                signal_store_push_weak_func(L, weakt, weak->sigfuncs.tab[i]);
+                if(lua_isnil(L, -1))
+                {
+                    /* Collected, forget it */
+                    lua_pop(L, 1);
+                    cptr_array_take(&weak->sigfuncs, i);
+                    continue;
+                }
+                /* Keep the functions after the strong ones */
+                lua_insert(L, weakt);
+                weakt++;
+                nweak++;
+                i++;
+            }
+            lua_pop(L, 1);
+            if(weak->sigfuncs.len == 0)
+            {
+                signal_wipe(weak);
+                signal_hashmap_remove(&store->weak, weak);
+            }
+        }
+
+        unsigned int disconnects = store->disconnects;
+        for(int i = 0; i < nstrong + nweak; i++)
+        {
+            int func = base + i;
+            if(store->disconnects != disconnects
+               && !signal_store_has(i < nstrong ? &store->strong : &store->weak,
+                                    name, lua_topointer(L, func)))
+                continue;
+            lua_pushvalue(L, func);
+            lua_pushvalue(L, 1);
+            for(int j = 3; j <= top; j++)
+                lua_pushvalue(L, j);
+            lua_call(L, nargs + 1, 0);
+        }
+
+        lua_settop(L, top + 1);
+    }
+
+    lua_getfield(L, 1, "_global_receivers");
+    if(lua_istable(L, -1))
+    {
+        int receivers = lua_gettop(L);
+        luaL_checkstack(L, nargs + 4, "too much signal");
+        for(int i = 1;; i++)
+        {
+            lua_rawgeti(L, receivers, i);
+            if(lua_isnil(L, -1))
+                break;
+            lua_pushvalue(L, 2);
+            lua_pushvalue(L, 1);
+            for(int j = 3; j <= top; j++)
+                lua_pushvalue(L, j);
+            lua_call(L, nargs + 2, 0);
+        }
+    }
+
+    return 0;
+}
+
+/** Setup the signal stores and export their functions.
+ * \param L The Lua VM state.
+ */
+void
+luaA_signal_store_setup(lua_State *L)
+{
+    static const struct luaL_Reg signal_store_lib[] =
+    {
+        { "new", luaA_signal_store_new },
+        { "connect", luaA_signal_store_connect },
+        { "weak_connect", luaA_signal_store_weak_connect },
+        { "disconnect", luaA_signal_store_disconnect },
+        { "emit", luaA_signal_store_emit },
+        { NULL, NULL }
+    };
+
+    luaL_newmetatable(L, SIGNAL_STORE_TYPE);
+    lua_pushcfunction(L, luaA_signal_store_gc);
+    lua_setfield(L, -2, "__gc");
+    /* The registry keeps it alive as long as the Lua VM */
+    signal_store_metatable = lua_topointer(L, -1);
+    lua_pop(L, 1);
+
+    /* awesome._object_signals, bypassing its __newindex */
+    lua_getglobal(L, "awesome");
+    lua_pushliteral(L, "_object_signals");
+    lua_newtable(L);
+    luaA_setfuncs(L, signal_store_lib);
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
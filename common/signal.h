@@ -45,53 +45,60 @@ signal_wipe(signal_t *sig)
     cptr_array_wipe(&sig->sigfuncs);
 }
 
-DO_BARRAY(signal_t, signal, signal_wipe, signal_cmp)
+static inline unsigned long
+signal_hash(const void *a)
+{
+    /* The id already is the hash of the signal name */
+    return ((const signal_t *) a)->id;
+}
+
+DO_HASHMAP(signal_t, signal, signal_wipe, signal_hash, signal_cmp)
 
 static inline signal_t *
-signal_array_getbyid(signal_array_t *arr, unsigned long id)
+signal_hashmap_getbyid(signal_hashmap_t *map, unsigned long id)
 {
     signal_t sig = { .id = id };
-    return signal_array_lookup(arr, &sig);
+    return signal_hashmap_lookup(map, &sig);
 }
 
 static inline signal_t *
-signal_array_getbyname(signal_array_t *arr, const char *name)
+signal_hashmap_getbyname(signal_hashmap_t *map, const char *name)
 {
     signal_t sig = { .id = a_strhash((const unsigned char *) NONULL(name)) };
-    return signal_array_lookup(arr, &sig);
+    return signal_hashmap_lookup(map, &sig);
 }
 
-/** Connect a signal inside a signal array.
+/** Connect a signal inside a signal map.
  * You are in charge of reference counting.
- * \param arr The signal array.
+ * \param map The signal map.
  * \param name The signal name.
  * \param ref The reference to add.
  */
 static inline void
-signal_connect(signal_array_t *arr, const char *name, const void *ref)
+signal_connect(signal_hashmap_t *map, const char *name, const void *ref)
 {
     unsigned long tok = a_strhash((const unsigned char *) name);
-    signal_t *sigfound = signal_array_getbyid(arr, tok);
+    signal_t *sigfound = signal_hashmap_getbyid(map, tok);
     if(sigfound)
         cptr_array_append(&sigfound->sigfuncs, ref);
     else
     {
         signal_t sig = { .id = tok };
         cptr_array_append(&sig.sigfuncs, ref);
-        signal_array_insert(arr, sig);
+        signal_hashmap_insert(map, sig);
     }
 }
 
-/** Disconnect a signal inside a signal array.
+/** Disconnect a signal inside a signal map.
  * You are in charge of reference counting.
- * \param arr The signal array.
+ * \param map The signal map.
  * \param name The signal name.
  * \param ref The reference to remove.
  */
 static inline bool
-signal_disconnect(signal_array_t *arr, const char *name, const void *ref)
+signal_disconnect(signal_hashmap_t *map, const char *name, const void *ref)
 {
-    signal_t *sigfound = signal_array_getbyname(arr, name);
+    signal_t *sigfound = signal_hashmap_getbyname(map, name);
     if(sigfound)
     {
         foreach(func, sigfound->sigfuncs)
@@ -102,7 +109,7 @@ signal_disconnect(signal_array_t *arr, const char *name, const void *ref)
                     if(sigfound->sigfuncs.tab) {
                         cptr_array_wipe(&sigfound->sigfuncs);
                     }
-                    signal_array_remove(arr, sigfound);
+                    signal_hashmap_remove(map, sigfound);
                 }
                 return true;
             }
@@ -65,6 +65,11 @@ eprint_version(void)
 #else
     const char *has_execinfo = "no";
 #endif
+#ifdef WITH_XCB_INTERPOSER
+    const char *has_xcb_interposer = "yes";
+#else
+    const char *has_xcb_interposer = "no";
+#endif
 
     printf("awesome %s (%s)\n"
            " • Compiled against %s (running with %s)\n"
@@ -72,6 +77,7 @@ eprint_version(void)
            " • D-Bus support: %s\n"
            " • xcb-errors support: %s\n"
            " • execinfo support: %s\n"
+           " • X request tracking: %s\n"
            " • xcb-randr version: %d.%d\n"
            " • LGI version: %s\n"
            " • Transparency enabled: %s\n"
@@ -84,6 +90,7 @@ eprint_version(void)
         /* DBus         */ has_dbus,
         /* XCB Error    */ has_xcb_errors,
         /* Execinfo     */ has_execinfo,
+        /* Interposer   */ has_xcb_interposer,
         /* XRandR major */ XCB_RANDR_MAJOR_VERSION,
         /* XRandR minor */ XCB_RANDR_MINOR_VERSION,
         /* LGI version  */ lua_tostring(L, -1),
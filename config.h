@@ -10,6 +10,8 @@
 #cmakedefine WITH_DBUS
 #cmakedefine WITH_XCB_ERRORS
 #cmakedefine HAS_EXECINFO
+#cmakedefine WITH_LUA_POOL_ALLOCATOR
+#cmakedefine WITH_XCB_INTERPOSER
 
 #endif //_CONFIG_H_
 
@@ -25,6 +25,7 @@
 #include "banning.h"
 #include "globalconf.h"
 #include "stack.h"
+#include "xrequest.h"
 
 #include <xcb/xcb.h>
 
@@ -34,6 +35,9 @@ void luaA_emit_refresh(void);
 /* objects/drawin.c */
 void drawin_refresh(void);
 
+/* ewmh.c */
+void ewmh_refresh(void);
+
 /* objects/client.c */
 void client_refresh(void);
 void client_focus_refresh(void);
@@ -42,12 +46,21 @@ void client_destroy_later(void);
 static inline int
 awesome_refresh(void)
 {
+    xrequest_phase_t phase = xrequest_phase_set(XREQUEST_PHASE_REFRESH);
     luaA_emit_refresh();
+    xrequest_phase_set(XREQUEST_PHASE_DRAWIN);
     drawin_refresh();
+    xrequest_phase_set(XREQUEST_PHASE_CLIENT);
     client_refresh();
+    xrequest_phase_set(XREQUEST_PHASE_BANNING);
     banning_refresh();
+    xrequest_phase_set(XREQUEST_PHASE_STACK);
     stack_refresh();
+    xrequest_phase_set(XREQUEST_PHASE_DESTROY);
     client_destroy_later();
+    xrequest_phase_set(XREQUEST_PHASE_EWMH);
+    ewmh_refresh();
+    xrequest_phase_set(phase);
     return xcb_flush(globalconf.connection);
 }
 
@@ -21,6 +21,7 @@
 
 #include "ewmh.h"
 #include "objects/client.h"
+#include "objects/screen.h"
 #include "objects/tag.h"
 #include "common/atoms.h"
 #include "xwindow.h"
@@ -37,6 +38,35 @@
 
 #define ALL_DESKTOPS 0xffffffff
 
+/** A window list on the root window, written at most once per main loop
+ * iteration.
+ */
+typedef struct
+{
+    /** Does the list need to be written again? */
+    bool dirty;
+    /** Was the property written by us since startup? */
+    bool written;
+    /** The content of the property as it was last written */
+    window_array_t windows;
+} ewmh_root_list_t;
+
+static ewmh_root_list_t client_list;
+static ewmh_root_list_t client_list_stacking;
+
+/** Root window list write counters */
+static struct
+{
+    /** Number of times a list was marked as changed */
+    unsigned int requested;
+    /** Number of lists rewritten with XCB_PROP_MODE_REPLACE */
+    unsigned int replaced;
+    /** Number of lists extended with XCB_PROP_MODE_APPEND */
+    unsigned int appended;
+    /** Number of refreshes which found the list unchanged */
+    unsigned int unchanged;
+} root_list_stats;
+
 /** Update client EWMH hints.
  * \param L The Lua VM state.
  */
@@ -94,16 +124,8 @@ ewmh_update_net_active_window(lua_State *L)
 static int
 ewmh_update_net_client_list(lua_State *L)
 {
-    xcb_window_t wins[globalconf.clients.len];
-
-    int n = 0;
-    foreach(client, globalconf.clients)
-        wins[n++] = (*client)->window;
-
-    xcb_change_property(globalconf.connection, XCB_PROP_MODE_REPLACE,
-                        globalconf.screen->root,
-                        _NET_CLIENT_LIST, XCB_ATOM_WINDOW, 32, n, wins);
-
+    client_list.dirty = true;
+    root_list_stats.requested++;
     return 0;
 }
 
@@ -265,20 +287,110 @@ ewmh_init_lua(void)
     luaA_class_connect_signal(L, &tag_class, "property::selected", ewmh_update_net_current_desktop);
 }
 
-/** Set the client list in stacking order, bottom to top.
+/** Mark the client list in stacking order as changed.
  */
 void
 ewmh_update_net_client_list_stacking(void)
 {
-    int n = 0;
-    xcb_window_t wins[globalconf.stack.len];
+    client_list_stacking.dirty = true;
+    root_list_stats.requested++;
+}
 
-    foreach(client, globalconf.stack)
-        wins[n++] = (*client)->window;
+/** Write a window list to a root window property, if it changed since it was
+ * last written. When windows were only added at the end, only those are sent.
+ * \param list The list state.
+ * \param atom The property to write.
+ * \param windows The new content of the list.
+ */
+static void
+ewmh_root_list_write(ewmh_root_list_t *list, xcb_atom_t atom, window_array_t *windows)
+{
+    int old_len = list->windows.len;
+    bool is_prefix = list->written && old_len <= windows->len
+        && (old_len == 0
+            || memcmp(list->windows.tab, windows->tab, old_len * sizeof(xcb_window_t)) == 0);
 
-    xcb_change_property(globalconf.connection, XCB_PROP_MODE_REPLACE,
-			globalconf.screen->root,
-			_NET_CLIENT_LIST_STACKING, XCB_ATOM_WINDOW, 32, n, wins);
+    list->dirty = false;
+
+    if(is_prefix && old_len == windows->len)
+    {
+        root_list_stats.unchanged++;
+        return;
+    }
+
+    if(is_prefix)
+    {
+        xcb_change_property(globalconf.connection, XCB_PROP_MODE_APPEND,
+                            globalconf.screen->root, atom, XCB_ATOM_WINDOW, 32,
+                            windows->len - old_len, windows->tab + old_len);
+        root_list_stats.appended++;
+    }
+    else
+    {
+        xcb_change_property(globalconf.connection, XCB_PROP_MODE_REPLACE,
+                            globalconf.screen->root, atom, XCB_ATOM_WINDOW, 32,
+                            windows->len, windows->tab);
+        root_list_stats.replaced++;
+    }
+
+    window_array_splice(&list->windows, 0, old_len, windows->tab, windows->len);
+    list->written = true;
+}
+
+/** Write the client lists which changed since the last main loop iteration.
+ */
+void
+ewmh_refresh(void)
+{
+    window_array_t windows;
+
+    if(!client_list.dirty && !client_list_stacking.dirty)
+        return;
+
+    window_array_init(&windows);
+
+    /* Initial mapping order, oldest first */
+    if(client_list.dirty)
+    {
+        foreach_reverse(client, globalconf.clients)
+            window_array_append(&windows, (*client)->window);
+        ewmh_root_list_write(&client_list, _NET_CLIENT_LIST, &windows);
+        windows.len = 0;
+    }
+
+    /* Stacking order, bottom to top */
+    if(client_list_stacking.dirty)
+    {
+        foreach(client, globalconf.stack)
+            window_array_append(&windows, (*client)->window);
+        ewmh_root_list_write(&client_list_stacking, _NET_CLIENT_LIST_STACKING, &windows);
+    }
+
+    window_array_wipe(&windows);
+}
+
+/** Get statistics about the _NET_CLIENT_LIST and _NET_CLIENT_LIST_STACKING
+ * root window properties.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+luaA_ewmh_root_list_stats(lua_State *L)
+{
+    unsigned int written = root_list_stats.replaced + root_list_stats.appended;
+
+    lua_createtable(L, 0, 5);
+    lua_pushinteger(L, root_list_stats.requested);
+    lua_setfield(L, -2, "requested");
+    lua_pushinteger(L, root_list_stats.replaced);
+    lua_setfield(L, -2, "replaced");
+    lua_pushinteger(L, root_list_stats.appended);
+    lua_setfield(L, -2, "appended");
+    lua_pushinteger(L, root_list_stats.unchanged);
+    lua_setfield(L, -2, "unchanged");
+    lua_pushinteger(L, root_list_stats.requested - MIN(written, root_list_stats.requested));
+    lua_setfield(L, -2, "saved");
+    return 1;
 }
 
 void
@@ -720,6 +832,10 @@ ewmh_process_client_strut(client_t *c)
             c->strut.bottom_start_x = strut[10];
             c->strut.bottom_end_x = strut[11];
 
+            screen_client_strut_changed(c);
+            if(c->screen)
+                screen_update_workarea(c->screen);
+
             lua_State *L = globalconf_get_lua_State();
             luaA_object_push(L, c);
             luaA_object_emit_signal(L, -1, "property::struts", 0);
@@ -42,6 +42,7 @@
 #include "common/xembed.h"
 #include "common/xcursor.h"
 #include "common/buffer.h"
+#include "luaalloc.h"
 
 #define ROOT_WINDOW_EVENT_MASK \
     (const uint32_t []) { \
@@ -133,6 +134,12 @@ typedef struct
     bool have_searchpaths;
     /** When --no-argb is used in the modeline or command line */
     bool had_overriden_depth;
+    /** Should the Lua VM use the pooled allocator? */
+    bool lua_pool_allocator;
+    /** The pool of the Lua VM, NULL with the system allocator */
+    luaA_pool_t *lua_pool;
+    /** When --no-cache is used, Lua files are always compiled from source */
+    bool no_lua_cache;
     uint8_t event_base_shape;
     uint8_t event_base_xkb;
     uint8_t event_base_randr;
@@ -62,7 +62,7 @@ end
 --
 -- This was a problem for the test backend. The new function takes both
 -- native surfaces and LGI-ified Cairo surfaces.
-function root.wallpaper(pattern)
+function root.wallpaper(pattern, ...)
     if not pattern then return root._wallpaper() end
 
     -- Checking for type will either potentially `error()` or always
@@ -73,9 +73,9 @@ function root.wallpaper(pattern)
     -- The presence of `root._write_string` means the test backend is
     -- used. Avoid passing the native surface.
     if err and not root._write_string then
-        return root._wallpaper(pattern._native)
+        return root._wallpaper(pattern._native, ...)
     else
-        return root._wallpaper(pattern)
+        return root._wallpaper(pattern, ...)
     end
 end
 
@@ -157,6 +157,61 @@ function focus.history.previous()
     end
 end
 
+-- The range of X11 coordinates.
+local min_coordinate, max_coordinate = -32768, 32767
+
+-- Get the visible clients of a screen which can be in the given direction of
+-- a geometry, in the same order as `awful.client.visible`. The spatial index
+-- avoids looking at the geometry of every client.
+local function get_candidates(s, stacked, dir, geo)
+    if not capi.client.intersecting then
+        return client.visible(s, stacked)
+    end
+
+    -- Clients outside of the screen geometry are candidates too, so the area
+    -- is only limited by the direction.
+    local x1, y1 = min_coordinate, min_coordinate
+    local x2, y2 = max_coordinate, max_coordinate
+
+    if dir == "up" then
+        y2 = geo.y
+    elseif dir == "down" then
+        y1 = geo.y + 1
+    elseif dir == "left" then
+        x2 = geo.x
+    elseif dir == "right" then
+        x1 = geo.x + 1
+    end
+
+    local ret = {}
+    if x2 <= x1 or y2 <= y1 then return ret end
+
+    -- The index returns the clients from top to bottom.
+    local area = { x = x1, y = y1, width = x2 - x1, height = y2 - y1 }
+    local found = {}
+    for _, c in ipairs(capi.client.intersecting(area)) do
+        if c.screen == s and c:isvisible() then
+            table.insert(ret, c)
+            found[c] = true
+        end
+    end
+
+    if stacked then
+        return ret
+    end
+
+    -- Otherwise keep the order of the client list, which breaks ties between
+    -- clients at the same distance.
+    ret = {}
+    for _, c in ipairs(capi.client.get(s)) do
+        if found[c] then
+            table.insert(ret, c)
+        end
+    end
+
+    return ret
+end
+
 --- Focus a client by the given direction.
 --
 -- @DOC_sequences_client_focus_bydirection1_EXAMPLE@
@@ -171,7 +226,7 @@ end
 function focus.bydirection(dir, c, stacked)
     local sel = c or capi.client.focus
     if sel then
-        local cltbl = client.visible(sel.screen, stacked)
+        local cltbl = get_candidates(sel.screen, stacked, dir, sel:geometry())
         local geomtbl = {}
         for i,cl in ipairs(cltbl) do
             if focus.filter(cl) then
@@ -210,7 +265,8 @@ function focus.global_bydirection(dir, c, stacked)
     if sel == capi.client.focus then
         screen.focus_bydirection(dir, scr)
         if scr ~= get_screen(screen.focused()) then
-            local cltbl = client.visible(screen.focused(), stacked)
+            local cltbl = get_candidates(get_screen(screen.focused()), stacked, dir,
+                                         scr.geometry)
             local geomtbl = {}
             for i,cl in ipairs(cltbl) do
                 if focus.filter(cl) then
@@ -973,7 +973,18 @@ function placement.no_overlap(c, args)
     local screen   = get_screen(c.screen or a_screen.getbycoord(geometry.x, geometry.y))
     local cls, curlay
     if client_on_selected_tags(c) then
-        cls = screen:get_clients(false)
+        if capi.client.intersecting then
+            -- Only the clients overlapping the workarea can take space away,
+            -- the spatial index finds them without going through every client.
+            cls = {}
+            for _, other_c in ipairs(capi.client.intersecting(screen.workarea)) do
+                if other_c.screen == screen then
+                    table.insert(cls, other_c)
+                end
+            end
+        else
+            cls = screen:get_clients(false)
+        end
         local t = screen.selected_tag
         curlay = t.layout or floating
     else
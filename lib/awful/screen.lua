@@ -77,7 +77,12 @@ end
 -- @tparam number y The y coordinate
 -- @treturn ?number The screen index
 function screen.getbycoord(x, y)
-    local s, sgeos = capi.screen.primary, {}
+    -- Positions inside of a screen are resolved by the C spatial index.
+    local s = capi.screen.at and capi.screen.at(math.floor(x), math.floor(y))
+    if s then return s.index end
+
+    local sgeos = {}
+    s = capi.screen.primary
     for scr in capi.screen do
         sgeos[scr] = scr.geometry
     end
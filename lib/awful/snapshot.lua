@@ -0,0 +1,368 @@
+---------------------------------------------------------------------------
+--- Keep the tags, layouts and focus history across `awesome.restart`.
+--
+-- Before restarting, the tags of each screen (with their layout, selection
+-- and layout parameters), the tags and floating state of each client and
+-- the focus history are written to an X property of the root window.
+--
+-- The new process reads it back while loading `rc.lua`. Once the
+-- configuration created its tags, they get their previous state back in one
+-- go. While the existing windows are scanned, the snapshot takes precedence
+-- over the other rule sources for the screen, the tags and the floating
+-- state of each client, and the placement is not computed again. Once the
+-- scan is done, the focus history is restored and the last focused client
+-- gets the focus back.
+--
+-- A screen of the snapshot is only restored when a screen with the same
+-- geometry still exists.
+--
+-- @author awesome developers
+-- @copyright 2026 awesome developers
+-- @module awful.snapshot
+---------------------------------------------------------------------------
+
+local capi = {
+    awesome = awesome,
+    client = client,
+    screen = screen,
+}
+
+local ruled_client = require("ruled.client")
+local alayout = require("awful.layout")
+local atag = require("awful.tag")
+local focus = require("awful.client.focus")
+local gdebug = require("gears.debug")
+
+local snapshot = {}
+
+local xproperty = "awful.snapshot"
+local version = "awful.snapshot 1"
+
+capi.awesome.register_xproperty(xproperty, "string")
+
+-- Tag properties kept in the snapshot, with their type.
+local tag_properties = {
+    { "master_width_factor", tonumber },
+    { "master_count", tonumber },
+    { "column_count", tonumber },
+    { "gap", tonumber },
+    { "master_fill_policy", tostring },
+}
+
+-- Fields are separated by spaces, "=" stands for an empty field.
+local function encode(s)
+    if s == nil or s == "" then return "=" end
+    return (tostring(s):gsub("[^%w%.%-_/]", function(c)
+        return string.format("%%%02X", c:byte())
+    end))
+end
+
+local function decode(s)
+    if s == "=" then return nil end
+    return (s:gsub("%%(%x%x)", function(h)
+        return string.char(tonumber(h, 16))
+    end))
+end
+
+local function split(line)
+    local ret = {}
+    for word in line:gmatch("%S+") do
+        table.insert(ret, decode(word))
+    end
+    return ret
+end
+
+--- Serialise the current state.
+--
+-- The format is line based. Each line starts with a keyword: `screen`,
+-- `tag`, `client` or `focus`.
+--
+-- @treturn string The snapshot.
+-- @staticfct awful.snapshot.serialize
+function snapshot.serialize()
+    local lines = { version }
+
+    for s in capi.screen do
+        local geo = s.geometry
+        table.insert(lines, table.concat({
+            "screen", s.index, geo.x, geo.y, geo.width, geo.height }, " "))
+
+        for i, t in ipairs(s.tags) do
+            local fields = {
+                "tag", s.index, i, t.selected and 1 or 0,
+                encode(alayout.getname(t.layout)), encode(t.name),
+            }
+            for _, prop in ipairs(tag_properties) do
+                table.insert(fields, encode(t[prop[1]]))
+            end
+            table.insert(lines, table.concat(fields, " "))
+        end
+    end
+
+    for _, c in ipairs(capi.client.get()) do
+        local tags = {}
+        for _, t in ipairs(c:tags()) do
+            if t.screen and t.index then
+                table.insert(tags, t.screen.index .. ":" .. t.index)
+            end
+        end
+        table.insert(lines, table.concat({
+            "client", c.window, c.screen and c.screen.index or 0,
+            c.floating and 1 or 0, encode(table.concat(tags, ",")) }, " "))
+    end
+
+    local history = { "focus" }
+    for _, c in ipairs(focus.history.list) do
+        if c.valid then
+            table.insert(history, c.window)
+        end
+    end
+    table.insert(lines, table.concat(history, " "))
+
+    return table.concat(lines, "\n")
+end
+
+--- Parse a snapshot.
+--
+-- @tparam string data The snapshot, as produced by `awful.snapshot.serialize`.
+-- @treturn table|nil The snapshot as a table, or nil if it is not valid.
+-- @staticfct awful.snapshot.parse
+function snapshot.parse(data)
+    if type(data) ~= "string" or data:sub(1, #version + 1) ~= version .. "\n" then
+        return nil
+    end
+
+    local ret = { screens = {}, tags = {}, clients = {}, focus = {} }
+
+    for line in data:gmatch("[^\n]+") do
+        local f = split(line)
+        if f[1] == "screen" then
+            ret.screens[tonumber(f[2])] = {
+                x = tonumber(f[3]), y = tonumber(f[4]),
+                width = tonumber(f[5]), height = tonumber(f[6]),
+            }
+            ret.tags[tonumber(f[2])] = {}
+        elseif f[1] == "tag" and ret.tags[tonumber(f[2])] then
+            local t = { selected = f[4] == "1", layout = f[5], name = f[6] }
+            for i, prop in ipairs(tag_properties) do
+                t[prop[1]] = f[6 + i] and prop[2](f[6 + i])
+            end
+            ret.tags[tonumber(f[2])][tonumber(f[3])] = t
+        elseif f[1] == "client" then
+            local tags = {}
+            for s, i in (f[5] or ""):gmatch("(%d+):(%d+)") do
+                table.insert(tags, { tonumber(s), tonumber(i) })
+            end
+            ret.clients[tonumber(f[2])] = {
+                screen = tonumber(f[3]), floating = f[4] == "1", tags = tags,
+            }
+        elseif f[1] == "focus" then
+            for i = 2, #f do
+                table.insert(ret.focus, tonumber(f[i]))
+            end
+        end
+    end
+
+    return ret
+end
+
+-- The snapshot being restored.
+local pending = nil
+
+-- Map the screens of the snapshot to the current ones, by geometry.
+local function map_screens(data)
+    data.screen_map = {}
+    for idx, geo in pairs(data.screens) do
+        for s in capi.screen do
+            local sgeo = s.geometry
+            if sgeo.x == geo.x and sgeo.y == geo.y
+              and sgeo.width == geo.width and sgeo.height == geo.height then
+                data.screen_map[idx] = s
+                break
+            end
+        end
+    end
+end
+
+local function find_layout(t, name)
+    for _, list in ipairs { t.layouts or {}, alayout.layouts } do
+        for _, l in ipairs(list) do
+            if alayout.getname(l) == name then
+                return l
+            end
+        end
+    end
+end
+
+--- Give the tags of the current screens the state they had in a snapshot.
+--
+-- Tags missing from the configuration are created.
+--
+-- @tparam table data A snapshot, as returned by `awful.snapshot.parse`.
+-- @noreturn
+-- @staticfct awful.snapshot.restore_tags
+function snapshot.restore_tags(data)
+    map_screens(data)
+
+    for idx, s in pairs(data.screen_map) do
+        local saved = data.tags[idx]
+        local tags = s.tags
+
+        local count = 0
+        for i in pairs(saved) do
+            count = math.max(count, i)
+        end
+
+        for i = 1, count do
+            local st, t = saved[i], tags[i]
+            if st then
+                if not t then
+                    t = atag.add(st.name or "", { screen = s })
+                end
+
+                t.layout = find_layout(t, st.layout) or t.layout
+                for _, prop in ipairs(tag_properties) do
+                    if st[prop[1]] ~= nil then
+                        t[prop[1]] = st[prop[1]]
+                    end
+                end
+            end
+        end
+
+        -- Change the selection last, so that it happens once per tag.
+        for i, t in ipairs(s.tags) do
+            if saved[i] then
+                t.selected = saved[i].selected
+            end
+        end
+    end
+end
+
+--- Get the rule properties of a client from a snapshot.
+--
+-- @tparam table data A snapshot, as returned by `awful.snapshot.parse`.
+-- @tparam client c The client.
+-- @treturn table|nil The `screen`, `tags` and `floating` properties, or nil
+--  when the client is not part of the snapshot.
+-- @staticfct awful.snapshot.client_properties
+function snapshot.client_properties(data, c)
+    local saved = data.clients[c.window]
+    if not (saved and data.screen_map) then return nil end
+
+    local s = data.screen_map[saved.screen]
+    if not s then return nil end
+
+    local tags = {}
+    for _, pos in ipairs(saved.tags) do
+        local ts = data.screen_map[pos[1]]
+        local t = ts and ts.tags[pos[2]]
+        -- A client only has tags of a single screen.
+        if t and ts == s then
+            table.insert(tags, t)
+        end
+    end
+
+    return { screen = s, tags = tags, floating = saved.floating }
+end
+
+--- Give the focus history the order it had in a snapshot.
+--
+-- @tparam table data A snapshot, as returned by `awful.snapshot.parse`.
+-- @treturn client|nil The client which was focused last.
+-- @staticfct awful.snapshot.restore_focus_history
+function snapshot.restore_focus_history(data)
+    local by_window = {}
+    for _, c in ipairs(capi.client.get()) do
+        by_window[c.window] = c
+    end
+
+    local list, seen = {}, {}
+    for _, window in ipairs(data.focus) do
+        local c = by_window[window]
+        if c and not seen[c] then
+            table.insert(list, c)
+            seen[c] = true
+        end
+    end
+    for _, c in ipairs(focus.history.list) do
+        if not seen[c] then
+            table.insert(list, c)
+        end
+    end
+
+    -- Other modules hold a reference to the list.
+    for i = #focus.history.list, 1, -1 do
+        focus.history.list[i] = nil
+    end
+    for i, c in ipairs(list) do
+        focus.history.list[i] = c
+    end
+
+    return by_window[data.focus[1]]
+end
+
+--- The rule source of clients found in the snapshot.
+--
+-- **Depends on:**
+--
+-- * `awful.rules`
+-- * `awful.spawn`
+-- * `awful.spawn_once`
+--
+-- @rulesources awful.snapshot
+ruled_client.add_rule_source("awful.snapshot", function(c, props)
+    if not (pending and capi.awesome.startup) then return end
+
+    local restored = snapshot.client_properties(pending, c)
+    if not restored then return end
+
+    -- The placement and the tags were already computed before the restart.
+    props.tag, props.new_tag, props.switch_to_tags, props.switchtotag = nil, nil, nil, nil
+    props.placement, props.focus = nil, nil
+
+    props.screen = restored.screen
+    props.floating = restored.floating
+    if #restored.tags > 0 then
+        props.tags = restored.tags
+    end
+end, {"awful.rules", "awful.spawn", "awful.spawn_once"}, {})
+
+capi.client.connect_signal("scanning", function()
+    if pending then
+        snapshot.restore_tags(pending)
+    end
+end)
+
+capi.client.connect_signal("scanned", function()
+    if not pending then return end
+
+    local c = snapshot.restore_focus_history(pending)
+    pending = nil
+
+    if c and c.valid and c:isvisible() then
+        c:emit_signal("request::activate", "snapshot", { raise = false })
+    end
+end)
+
+capi.awesome.connect_signal("exit", function(restarting)
+    if restarting then
+        capi.awesome.set_xproperty(xproperty, snapshot.serialize())
+    end
+end)
+
+-- Read the snapshot left by the previous process. It is only meant for the
+-- process started right after it, so remove it.
+if capi.awesome.startup and capi.awesome.get_xproperty then
+    local data = capi.awesome.get_xproperty(xproperty)
+    if data then
+        capi.awesome.set_xproperty(xproperty, nil)
+        pending = snapshot.parse(data)
+        if not pending then
+            gdebug.print_warning("awful.snapshot: ignoring an invalid snapshot")
+        end
+    end
+end
+
+return snapshot
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
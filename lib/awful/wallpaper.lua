@@ -250,21 +250,61 @@ function panning_modes.inner(self)
 end
 
 
+-- Get the smallest rectangle containing all screens of some wallpapers.
+local function get_bounding_area(walls)
+    local x1, y1, x2, y2 = math.huge, math.huge, -math.huge, -math.huge
+
+    for wall in pairs(walls) do
+        for _, s in ipairs(wall.screens) do
+            local geo = s.geometry
+            x1, y1 = math.min(x1, geo.x), math.min(y1, geo.y)
+            x2 = math.max(x2, geo.x + geo.width)
+            y2 = math.max(y2, geo.y + geo.height)
+        end
+    end
+
+    if x1 >= x2 or y1 >= y2 then return nil end
+
+    return { x = x1, y = y1, width = x2 - x1, height = y2 - y1 }
+end
+
 local function paint()
     if not next(pending_repaint) then return end
 
-    local root_width, root_height = capi.root.size()
+    -- Only the wallpapers of the screens which need a repaint are painted.
+    -- The rest of the native wallpaper is kept as-is.
+    local walls = {}
+
+    for s in pairs(pending_repaint) do
+        if s.valid and backgrounds[s] then
+            walls[backgrounds[s]] = true
+        end
+
+        pending_repaint[s] = nil
+    end
+
+    -- Not supposed to happen, but there is enough API surface for
+    -- it to be a side effect of some signals. Calling the panning
+    -- mode callback with zero screen is not supported.
+    if not next(walls) then
+        return
+    end
+
+    local area = get_bounding_area(walls)
+
+    if not area then return end
 
     -- Get the current wallpaper content.
     local source = surface(root.wallpaper())
 
     local target, cr
 
-    -- It's possible that a wallpaper for 1 screen is set using another tool, so make
+    -- The area can contain parts of screens which are not repainted, so make
     -- sure we copy the current content.
     if source then
-        target = source:create_similar(cairo.Content.COLOR, root_width, root_height)
+        target = source:create_similar(cairo.Content.COLOR, area.width, area.height)
         cr     = cairo.Context(target)
+        cr:translate(-area.x, -area.y)
 
         -- Copy the old wallpaper to the new one
         cr:save()
@@ -285,21 +325,9 @@ local function paint()
         cr:paint()
         cr:restore()
     else
-        target = cairo.ImageSurface(cairo.Format.RGB32, root_width, root_height)
+        target = cairo.ImageSurface(cairo.Format.RGB32, area.width, area.height)
         cr     = cairo.Context(target)
-    end
-
-    local walls = {}
-
-    for _, wall in pairs(backgrounds) do
-        walls[wall] = true
-    end
-
-    -- Not supposed to happen, but there is enough API surface for
-    -- it to be a side effect of some signals. Calling the panning
-    -- mode callback with zero screen is not supported.
-    if not next(walls) then
-        return
+        cr:translate(-area.x, -area.y)
     end
 
     for wall in pairs(walls) do
@@ -368,9 +396,9 @@ local function paint()
         end
     end
 
-    -- Set the wallpaper.
+    -- Set the wallpaper. Only this area of the native wallpaper is repainted.
     local pattern = cairo.Pattern.create_for_surface(target)
-    capi.root.wallpaper(pattern)
+    capi.root.wallpaper(pattern, area.x, area.y, area.width, area.height)
 
     -- Limit some potential GC induced increase in memory usage.
     -- But really, is someone is trying to apply wallpaper changes more
@@ -839,6 +867,39 @@ function module:remove_screen(s)
     return ret
 end
 
+--- Set an image file as the wallpaper of a screen without blocking.
+--
+-- The image is decoded and scaled on a worker thread and only the area of the
+-- screen is repainted, which makes this suitable for slideshows. The image is
+-- scaled to cover the whole screen while keeping its aspect ratio. If the
+-- screen has an `awful.wallpaper` object, it is detached from the screen.
+--
+--    gears.timer {
+--        timeout   = 30,
+--        autostart = true,
+--        callback  = function()
+--            awful.wallpaper.load_image_async(next_image(), screen.primary)
+--        end
+--    }
+--
+-- @staticfct awful.wallpaper.load_image_async
+-- @tparam string path The path of the image file.
+-- @tparam screen s The screen.
+-- @tparam[opt] function callback Called once the wallpaper is set.
+-- @tparam boolean callback.success If the wallpaper was set.
+-- @tparam[opt] string callback.err The error if the image could not be loaded.
+-- @noreturn
+function module.load_image_async(path, s, callback)
+    s = get_screen(s)
+
+    if backgrounds[s] then
+        backgrounds[s]:remove_screen(s)
+    end
+
+    local geo = s.geometry
+    capi.root._wallpaper_load(path, geo.x, geo.y, geo.width, geo.height, callback)
+end
+
 --- Create a wallpaper.
 --
 -- Note that all parameters are not required. Please refer to the
@@ -231,36 +231,7 @@ function beautiful.get_font_height(name)
     return load_font(name).height
 end
 
---- Function that initializes the theme settings. Should be run at the
--- beginning of the awesome configuration file (normally rc.lua).
---
--- Example usages:
---
---    -- Using a table
---    beautiful.init({font = 'Monospace Bold 10'})
---
---    -- From a config file
---    beautiful.init("<path>/theme.lua")
---
--- Example "<path>/theme.lua" (see `05-awesomerc.md:Variable_definitions`):
---
---    theme = {}
---        theme.font = 'Monospace Bold 10'
---    return theme
---
--- Example using the return value:
---
---    local beautiful = require("beautiful")
---    if not beautiful.init("<path>/theme.lua") then
---        beautiful.init("<path>/.last.theme.lua") -- a known good fallback
---    end
---
--- @tparam string|table config The theme to load. It can be either the path to
---   the theme file (which should return a table) or directly a table
---   containing all the theme values.
--- @treturn true|nil True if successful, nil in case of error.
--- @staticfct beautiful.init
-function beautiful.init(config)
+local function load_theme(config)
     if config then
         local state, t_theme = nil, nil
         local homedir = os.getenv("HOME")
@@ -307,6 +278,48 @@ function beautiful.init(config)
     end
 end
 
+--- Function that initializes the theme settings. Should be run at the
+-- beginning of the awesome configuration file (normally rc.lua).
+--
+-- Example usages:
+--
+--    -- Using a table
+--    beautiful.init({font = 'Monospace Bold 10'})
+--
+--    -- From a config file
+--    beautiful.init("<path>/theme.lua")
+--
+-- Example "<path>/theme.lua" (see `05-awesomerc.md:Variable_definitions`):
+--
+--    theme = {}
+--        theme.font = 'Monospace Bold 10'
+--    return theme
+--
+-- Example using the return value:
+--
+--    local beautiful = require("beautiful")
+--    if not beautiful.init("<path>/theme.lua") then
+--        beautiful.init("<path>/.last.theme.lua") -- a known good fallback
+--    end
+--
+-- @tparam string|table config The theme to load. It can be either the path to
+--   the theme file (which should return a table) or directly a table
+--   containing all the theme values.
+-- @treturn true|nil True if successful, nil in case of error.
+-- @staticfct beautiful.init
+function beautiful.init(config)
+    -- Show up in the timeline of `awesome --profile-startup`
+    local awesome = _G.awesome
+    if not (awesome and awesome._startup_profile_begin) then
+        return load_theme(config)
+    end
+
+    awesome._startup_profile_begin("beautiful.init")
+    local ret = load_theme(config)
+    awesome._startup_profile_end()
+    return ret
+end
+
 --- Get the current theme.
 --
 -- @treturn table The current theme table.
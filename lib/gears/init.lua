@@ -14,6 +14,7 @@ return
     wallpaper = require("gears.wallpaper");
     timer = require("gears.timer");
     cache = require("gears.cache");
+    lru_cache = require("gears.lru_cache");
     matrix = require("gears.matrix");
     shape = require("gears.shape");
     protected_call = require("gears.protected_call");
@@ -0,0 +1,214 @@
+---------------------------------------------------------------------------
+--- Cache object with a bounded number of entries.
+--
+-- Like `gears.cache`, this calls a creation callback for missing entries and
+-- remembers the result for the given arguments. Instead of relying on the
+-- garbage collector, it keeps at most `max_entries` entries and evicts the
+-- least recently used one when this limit is exceeded.
+--
+--    local c = gears.lru_cache(function(a, b) return a + b end, 2)
+--    c:get(1, 2) -- Calls the callback
+--    c:get(1, 2) -- Returns the cached result
+--    c:get(1, 3) -- Calls the callback
+--    c:get(1, 4) -- Calls the callback and evicts the entry for (1, 2)
+--
+-- @author awesome developers
+-- @copyright 2026 awesome developers
+-- @classmod gears.lru_cache
+---------------------------------------------------------------------------
+
+local select = select
+local pairs = pairs
+local setmetatable = setmetatable
+local unpack = unpack or table.unpack -- luacheck: globals unpack (compatibility with Lua 5.1)
+
+local lru_cache = {}
+
+-- Keys of the nodes of the argument tree. Each node maps an argument to the
+-- node of the next argument and the node for the last argument has the entry.
+local PARENT, ARG, COUNT, ENTRY = {}, {}, {}, {}
+
+local function new_node(parent, arg)
+    return { [PARENT] = parent, [ARG] = arg, [COUNT] = 0 }
+end
+
+local function unlink(entry)
+    entry.prev.next = entry.next
+    entry.next.prev = entry.prev
+end
+
+local function link_front(head, entry)
+    entry.next = head.next
+    entry.prev = head
+    head.next.prev = entry
+    head.next = entry
+end
+
+-- Remove nodes that have neither children nor an entry.
+local function prune(node)
+    while node[PARENT] and node[COUNT] == 0 and not node[ENTRY] do
+        local parent = node[PARENT]
+        parent[node[ARG]] = nil
+        parent[COUNT] = parent[COUNT] - 1
+        node = parent
+    end
+end
+
+local function remove_entry(self, entry)
+    unlink(entry)
+    entry.node[ENTRY] = nil
+    prune(entry.node)
+    self._count = self._count - 1
+end
+
+-- Unlink all entries below a node from the list of entries.
+local function remove_subtree(self, node)
+    local entry = node[ENTRY]
+    if entry then
+        unlink(entry)
+        self._count = self._count - 1
+    end
+    for k, child in pairs(node) do
+        if k ~= PARENT and k ~= ARG and k ~= COUNT and k ~= ENTRY then
+            remove_subtree(self, child)
+        end
+    end
+end
+
+local function store(self, entry, ...)
+    local node = self._root
+    for i = 1, select("#", ...) do
+        local arg = select(i, ...)
+        local child = node[arg]
+        if not child then
+            child = new_node(node, arg)
+            node[arg] = child
+            node[COUNT] = node[COUNT] + 1
+        end
+        node = child
+    end
+    entry.node = node
+    node[ENTRY] = entry
+    link_front(self._head, entry)
+    self._count = self._count + 1
+
+    if self._count > self.max_entries then
+        remove_entry(self, self._head.prev)
+        self.stats.evictions = self.stats.evictions + 1
+    end
+end
+
+local function pack(...)
+    return { n = select("#", ...), ... }
+end
+
+--- Get an entry from the cache, creating it if it's missing.
+-- @param ... Arguments for the creation callback. These are checked against the
+--   cache contents for equality.
+-- @return The entry from the cache
+-- @method get
+function lru_cache:get(...)
+    local node = self._root
+    for i = 1, select("#", ...) do
+        node = node[select(i, ...)]
+        if not node then
+            break
+        end
+    end
+
+    local entry = node and node[ENTRY]
+    if entry then
+        self.stats.hits = self.stats.hits + 1
+        local head = self._head
+        if head.next ~= entry then
+            unlink(entry)
+            link_front(head, entry)
+        end
+        return unpack(entry, 1, entry.n)
+    end
+
+    self.stats.misses = self.stats.misses + 1
+    local generation = self._generation
+    entry = pack(self._creation_cb(...))
+
+    -- Do not keep the result if the cache was cleared while it was computed
+    if generation == self._generation then
+        store(self, entry, ...)
+    end
+    return unpack(entry, 1, entry.n)
+end
+
+--- Remove the entries whose arguments start with the given ones.
+--
+-- Without arguments, this removes all entries.
+-- @param ... The first arguments of the entries to remove.
+-- @method invalidate
+-- @noreturn
+function lru_cache:invalidate(...)
+    local node = self._root
+    for i = 1, select("#", ...) do
+        node = node[select(i, ...)]
+        if not node then
+            return
+        end
+    end
+
+    self._generation = self._generation + 1
+    remove_subtree(self, node)
+    if node == self._root then
+        self._root = new_node(nil, nil)
+    else
+        local parent = node[PARENT]
+        parent[node[ARG]] = nil
+        parent[COUNT] = parent[COUNT] - 1
+        prune(parent)
+    end
+end
+
+--- Remove all entries from the cache.
+-- @method clear
+-- @noreturn
+function lru_cache:clear()
+    if self._count > 0 then
+        self:invalidate()
+    else
+        self._generation = self._generation + 1
+    end
+end
+
+--- Get the number of entries in the cache.
+-- @treturn number The number of entries.
+-- @method get_count
+function lru_cache:get_count()
+    return self._count
+end
+
+--- Create a new bounded cache object.
+-- @tparam function creation_cb Callback that is used for creating missing cache
+--   entries.
+-- @tparam[opt=128] number max_entries The maximal number of entries.
+-- @tparam[opt] table stats A table with the fields `hits`, `misses` and
+--   `evictions` that is used for counting. This allows several caches to share
+--   their statistics. By default, each cache has its own `stats` table.
+-- @return A new cache object.
+-- @constructorfct gears.lru_cache
+function lru_cache.new(creation_cb, max_entries, stats)
+    local head = {}
+    head.next, head.prev = head, head
+
+    return setmetatable({
+        max_entries  = max_entries or 128,
+        stats        = stats or { hits = 0, misses = 0, evictions = 0 },
+        _creation_cb = creation_cb,
+        _root        = new_node(nil, nil),
+        _head        = head,
+        _count       = 0,
+        _generation  = 0,
+    }, {
+        __index = lru_cache
+    })
+end
+
+return setmetatable(lru_cache, { __call = function(_, ...) return lru_cache.new(...) end })
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
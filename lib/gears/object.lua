@@ -14,9 +14,18 @@ local pairs = pairs
 local type = type
 local error = error
 local properties = require("gears.object.properties")
+local capi = { awesome = awesome }
 
 local object = { properties = properties, mt = {} }
 
+-- The C implementation of the signals, only available inside awesome.
+local backend = type(capi.awesome) == "table"
+    and rawget(capi.awesome, "_object_signals") or nil
+
+-- Whether new objects use the C implementation of the signals, "c" or "lua".
+-- LuaJIT compiles the Lua implementation, and calls into C stop that.
+object._signal_backend = (backend and not rawget(_G, "jit")) and "c" or "lua"
+
 --- Verify that obj is indeed a valid object as returned by new()
 local function check(obj)
     if type(obj) ~= "table" or type(obj._signals) ~= "table" then
@@ -146,6 +155,41 @@ function object:emit_signal(name, ...)
     end
 end
 
+-- The signal methods implemented in Lua, which keep the connected functions
+-- in tables.
+local lua_methods = {
+    connect_signal      = object.connect_signal,
+    weak_connect_signal = object.weak_connect_signal,
+    disconnect_signal   = object.disconnect_signal,
+    emit_signal         = object.emit_signal,
+}
+
+-- The signal methods implemented in C, which keep the connected functions in
+-- a signal store. They have the same behaviour.
+local c_methods = backend and {
+    connect_signal    = backend.connect,
+    disconnect_signal = backend.disconnect,
+    emit_signal       = backend.emit,
+    weak_connect_signal = function(self, name, func)
+        assert(type(func) == "function", "callback must be a function, got: " .. type(func))
+        backend.weak_connect(self, name, func, make_the_gc_obey(func))
+    end,
+}
+
+-- Objects get the methods of their implementation directly, but the ones of
+-- this module work with both.
+if backend then
+    for name, c_method in pairs(c_methods) do
+        local lua_method = lua_methods[name]
+        object[name] = function(self, ...)
+            if type(self) == "table" and type(self._signals) == "userdata" then
+                return c_method(self, ...)
+            end
+            return lua_method(self, ...)
+        end
+    end
+end
+
 function object._setup_class_signals(t, args)
     args = args or {}
     local conns = {}
@@ -260,7 +304,17 @@ local function new(args)
         end
     end
 
-    ret._signals = {}
+    if object._signal_backend == "c" and backend then
+        for k, v in pairs(c_methods) do
+            ret[k] = v
+        end
+        ret._signals = backend.new()
+    else
+        for k, v in pairs(lua_methods) do
+            ret[k] = v
+        end
+        ret._signals = {}
+    end
 
     ret._global_receivers = {}
 
@@ -26,6 +26,26 @@ local unpack = unpack or table.unpack -- luacheck: globals unpack (compatibility
 
 local visible_drawables = {}
 
+--- Rasterise the drawing of drawables on a worker thread.
+--
+-- When enabled, widgets draw into a cairo recording surface instead of the
+-- drawable's surface. The recorded operations are then replayed into an image
+-- on another thread and only the resulting image is painted to the drawable on
+-- the main thread. This keeps expensive drawings from delaying input handling.
+-- Widgets draw in the same way in both modes. However, image surfaces that
+-- widgets use as a source must not be changed after drawing, since they are
+-- read later by the other thread. Drawings that use other surfaces as a source,
+-- like the content of a client, or that use a mask are rasterised on the main
+-- thread. While a
+-- drawing waits for the other thread, a later drawing of the same area
+-- replaces it.
+--
+-- @tfield[opt=false] boolean wibox.drawable.rasterize_in_thread
+drawable.rasterize_in_thread = false
+
+-- Incremented when the wallpaper changes, see get_wallpaper().
+local wallpaper_generation = 0
+
 local systray_widget
 
 -- Get the widget context. This should always return the same table (if
@@ -63,6 +83,36 @@ local function get_widget_context(self)
     return context
 end
 
+-- Get the part of the wallpaper below the drawable for pseudo-transparency.
+-- This is copied into a surface that is similar to the drawable's surface (and
+-- thus a pixmap on the X server) and kept until the wallpaper changes or the
+-- drawable moves, so that redraws do not need to read the wallpaper again.
+local function get_wallpaper(self, surf, x, y, width, height)
+    local cached = self._wallpaper_cache
+    if cached and cached.generation == wallpaper_generation and
+            cached.x == x and cached.y == y and
+            cached.width == width and cached.height == height then
+        return cached.surface
+    end
+
+    local wallpaper = surface.load_silently(capi.root.wallpaper(), false)
+    local crop = nil
+    if wallpaper then
+        crop = surf:create_similar(cairo.Content.COLOR, width, height)
+        local cr = cairo.Context(crop)
+        cr.operator = cairo.Operator.SOURCE
+        cr:set_source_surface(wallpaper, -x, -y)
+        cr:paint()
+    end
+
+    self._wallpaper_cache = {
+        generation = wallpaper_generation,
+        x = x, y = y, width = width, height = height,
+        surface = crop,
+    }
+    return crop
+end
+
 local function do_redraw(self)
     if not self.drawable.valid then return end
     if self._forced_screen and not self._forced_screen.valid then return end
@@ -70,11 +120,17 @@ local function do_redraw(self)
     local surf = surface.load_silently(self.drawable.surface, false)
     -- The surface can be nil if the drawable's parent was already finalized
     if not surf then return end
-    local cr = cairo.Context(surf)
     local geom = self.drawable:geometry();
     local x, y, width, height = geom.x, geom.y, geom.width, geom.height
     local context = get_widget_context(self)
 
+    -- Switching between drawing modes needs a complete repaint
+    local record = drawable.rasterize_in_thread and true or false
+    if self._recorded ~= record then
+        self._recorded = record
+        self._need_complete_repaint = true
+    end
+
     -- Relayout
     if self._need_relayout or self._need_complete_repaint then
         self._need_relayout = false
@@ -111,9 +167,29 @@ local function do_redraw(self)
     if self._dirty_area:is_empty() then
         return
     end
+
+    -- When recording, the drawing is rasterised on another thread
+    local recording, rects, opaque, wallpaper
+    if record then
+        recording = cairo.Surface(self.drawable:_record(width, height), true)
+        rects = {}
+    end
+
+    local cr = cairo.Context(recording or surf)
+    if recording then
+        -- Lets the recording find out whether it can be rasterised on the
+        -- other thread, which can only read image surfaces.
+        self.drawable:_record_context(recording._native, cr._native)
+    end
     for i = 0, self._dirty_area:num_rectangles() - 1 do
         local rect = self._dirty_area:get_rectangle(i)
         cr:rectangle(rect.x, rect.y, rect.width, rect.height)
+        if rects then
+            table.insert(rects, rect.x)
+            table.insert(rects, rect.y)
+            table.insert(rects, rect.width)
+            table.insert(rects, rect.height)
+        end
     end
     self._dirty_area = cairo.Region.create()
     cr:clip()
@@ -123,17 +199,23 @@ local function do_redraw(self)
 
     if not capi.awesome.composite_manager_running then
         -- This is pseudo-transparency: We draw the wallpaper in the background
-        local wallpaper = surface.load_silently(capi.root.wallpaper(), false)
-        cr.operator = cairo.Operator.SOURCE
-        if wallpaper then
-            cr:set_source_surface(wallpaper, -x, -y)
+        wallpaper = get_wallpaper(self, surf, x, y, width, height)
+        if recording then
+            -- The wallpaper is painted below the rasterised drawing
+            opaque = true
         else
-            cr:set_source_rgb(0, 0, 0)
+            cr.operator = cairo.Operator.SOURCE
+            if wallpaper then
+                cr:set_source_surface(wallpaper, 0, 0)
+            else
+                cr:set_source_rgb(0, 0, 0)
+            end
+            cr:paint()
         end
-        cr:paint()
         cr.operator = cairo.Operator.OVER
     else
         -- This is true transparency: We draw a translucent background
+        self._wallpaper_cache = nil
         cr.operator = cairo.Operator.SOURCE
     end
 
@@ -161,7 +243,12 @@ local function do_redraw(self)
         self._widget_hierarchy:draw(context, cr)
     end
 
-    self.drawable:refresh()
+    if recording then
+        self.drawable:_replay(recording._native, rects, opaque,
+            wallpaper and wallpaper._native)
+    else
+        self.drawable:refresh()
+    end
 
     assert(cr.status == "SUCCESS", "Cairo context entered error state: " .. cr.status)
 end
@@ -311,6 +398,7 @@ function drawable:_inform_visible(visible)
         self:_do_complete_repaint()
     else
         visible_drawables[self] = nil
+        self._wallpaper_cache = nil
     end
 end
 
@@ -507,6 +595,7 @@ end
 
 -- Redraw all drawables when the wallpaper changes
 capi.awesome.connect_signal("wallpaper_changed", function()
+    wallpaper_generation = wallpaper_generation + 1
     for d in pairs(visible_drawables) do
         d:_do_complete_repaint()
     end
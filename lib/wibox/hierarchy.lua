@@ -12,7 +12,6 @@ local matrix = require("gears.matrix")
 local protected_call = require("gears.protected_call")
 local cairo = require("lgi").cairo
 local base = require("wibox.widget.base")
-local no_parent = base.no_parent_I_know_what_I_am_doing
 
 local hierarchy = {}
 
@@ -51,17 +50,23 @@ local function hierarchy_new(redraw_callback, layout_callback, callback_arg)
         _parent = nil,
         _children = {},
         _widget_counts = {},
+        _fit_record = nil,
+        _dirty_nodes = nil,
     }
 
     function result._redraw()
         redraw_callback(result, callback_arg)
     end
     function result._layout()
-        local h = result
-        while h do
-            h._need_update = true
-            h = h._parent
+        -- Only this node is marked. hierarchy:update() later finds out how far
+        -- up the change of this widget's size propagates.
+        result._need_update = true
+        local root = result
+        while root._parent do
+            root = root._parent
         end
+        root._dirty_nodes = root._dirty_nodes or {}
+        root._dirty_nodes[result] = true
         layout_callback(result, callback_arg)
     end
     function result._emit_recursive(widget, name, ...)
@@ -83,6 +88,55 @@ local function hierarchy_new(redraw_callback, layout_callback, callback_arg)
     return result
 end
 
+-- Recalculate the draw extents and the widget counts of a hierarchy from its
+-- children. Returns true if any of them changed.
+local function update_extents_and_counts(self)
+    local width, height = self._size.width, self._size.height
+    local x1, y1, x2, y2 = 0, 0, width, height
+    for _, h in ipairs(self._children) do
+        local px, py, pwidth, pheight = matrix.transform_rectangle(h._matrix, h:get_draw_extents())
+        x1 = math.min(x1, px)
+        y1 = math.min(y1, py)
+        x2 = math.max(x2, px + pwidth)
+        y2 = math.max(y2, py + pheight)
+    end
+    local old_extents = self._draw_extents
+    local changed = old_extents.x ~= x1 or old_extents.y ~= y1 or
+        old_extents.width ~= x2 - x1 or old_extents.height ~= y2 - y1
+    self._draw_extents = {
+        x = x1, y = y1,
+        width = x2 - x1,
+        height = y2 - y1
+    }
+
+    local old_counts = self._widget_counts
+    local counts = {}
+    local widget = self._widget
+    if widgets_to_count[widget] and width > 0 and height > 0 then
+        counts[widget] = 1
+    end
+    for _, h in ipairs(self._children) do
+        for w, count in pairs(h._widget_counts) do
+            counts[w] = (counts[w] or 0) + count
+        end
+    end
+    self._widget_counts = counts
+
+    if not changed then
+        for w, count in pairs(counts) do
+            if old_counts[w] ~= count then
+                return true
+            end
+        end
+        for w in pairs(old_counts) do
+            if not counts[w] then
+                return true
+            end
+        end
+    end
+    return changed
+end
+
 local hierarchy_update
 function hierarchy_update(self, context, widget, width, height, region, matrix_to_parent, matrix_to_device)
     if (not self._need_update) and self._widget == widget and
@@ -130,7 +184,15 @@ function hierarchy_update(self, context, widget, width, height, region, matrix_t
 
     -- Update children
     local old_children = self._children
-    local layout_result = base.layout_widget(no_parent, context, widget, width, height)
+    local layout_result, record = base._layout_widget_recorded(context, widget, width, height)
+    local old_record = self._fit_record
+    if record then
+        self._fit_record = record
+    elseif not (old_record and old_record.widget == widget and old_record.context == context and
+            old_record.width == width and old_record.height == height) then
+        -- The layout came from a cache and we do not know how it was computed
+        self._fit_record = nil
+    end
     self._children = {}
     for _, w in ipairs(layout_result or {}) do
         local r = table.remove(old_children, 1)
@@ -142,31 +204,7 @@ function hierarchy_update(self, context, widget, width, height, region, matrix_t
         table.insert(self._children, r)
     end
 
-    -- Calculate the draw extents
-    local x1, y1, x2, y2 = 0, 0, width, height
-    for _, h in ipairs(self._children) do
-        local px, py, pwidth, pheight = matrix.transform_rectangle(h._matrix, h:get_draw_extents())
-        x1 = math.min(x1, px)
-        y1 = math.min(y1, py)
-        x2 = math.max(x2, px + pwidth)
-        y2 = math.max(y2, py + pheight)
-    end
-    self._draw_extents = {
-        x = x1, y = y1,
-        width = x2 - x1,
-        height = y2 - y1
-    }
-
-    -- Update widget counts
-    self._widget_counts = {}
-    if widgets_to_count[widget] and width > 0 and height > 0 then
-        self._widget_counts[widget] = 1
-    end
-    for _, h in ipairs(self._children) do
-        for w, count in pairs(h._widget_counts) do
-            self._widget_counts[w] = (self._widget_counts[w] or 0) + count
-        end
-    end
+    update_extents_and_counts(self)
 
     -- Check which part needs to be redrawn
 
@@ -198,6 +236,62 @@ function hierarchy_update(self, context, widget, width, height, region, matrix_t
     end
 end
 
+-- Check if the size of the widget of a hierarchy, as seen by the layout of its
+-- parent, changed since the parent was last laid out.
+local function size_in_parent_changed(self)
+    local parent = self._parent
+    local record = parent._fit_record
+    if not record or record.opaque then
+        return true
+    end
+
+    -- Without any queries, the parent's layout does not depend on our size
+    local queries = record.children[self._widget]
+    if not queries then
+        return false
+    end
+
+    for i = 1, #queries, 4 do
+        local w, h = base.fit_widget(parent._widget, parent._context, self._widget,
+            queries[i], queries[i + 1])
+        if w ~= queries[i + 2] or h ~= queries[i + 3] then
+            return true
+        end
+    end
+    return false
+end
+
+-- Update the hierarchy of a widget that emitted widget::layout_changed. This
+-- re-lays out the highest ancestor whose layout is affected by the change.
+local function update_dirty_node(self, region)
+    -- A parent's layout might not depend on our size while its own size does
+    -- (e.g. a margin), so all ancestors have to be checked.
+    local top = self
+    local node = self
+    while node._parent do
+        if size_in_parent_changed(node) then
+            top = node._parent
+        end
+        node = node._parent
+    end
+
+    node = self
+    while node ~= top do
+        node = node._parent
+        node._need_update = true
+    end
+
+    hierarchy_update(top, top._context, top._widget, top._size.width, top._size.height,
+        region, top._matrix, top._matrix_to_device)
+
+    -- The draw extents and widget counts of the ancestors are derived from
+    -- their children.
+    node = top._parent
+    while node and update_extents_and_counts(node) do
+        node = node._parent
+    end
+end
+
 --- Create a new widget hierarchy that has no parent.
 -- @param context The context in which we are laid out.
 -- @param widget The widget that is at the base of the hierarchy.
@@ -228,6 +322,20 @@ end
 function hierarchy:update(context, widget, width, height, region)
     region = region or cairo.Region.create()
     hierarchy_update(self, context, widget, width, height, region, self._matrix, self._matrix_to_device)
+
+    local dirty_nodes = self._dirty_nodes
+    self._dirty_nodes = nil
+    for node in pairs(dirty_nodes or {}) do
+        -- The node might have been updated already or be gone from this hierarchy
+        local root = node
+        while root._parent do
+            root = root._parent
+        end
+        if node._need_update and root == self then
+            update_dirty_node(node, region)
+        end
+    end
+
     return region
 end
 
@@ -8,7 +8,7 @@
 ---------------------------------------------------------------------------
 
 local object = require("gears.object")
-local cache = require("gears.cache")
+local lru_cache = require("gears.lru_cache")
 local matrix = require("gears.matrix")
 local gdebug = require("gears.debug")
 local protected_call = require("gears.protected_call")
@@ -474,15 +474,51 @@ end
 -- Indexes are widgets, allow them to be garbage-collected.
 local widget_dependencies = setmetatable({}, { __mode = "kv" })
 
--- Get the cache of the given kind for this widget. This returns a gears.cache
--- that calls the callback of kind `kind` on the widget.
-local function get_cache(widget, kind)
-    if not widget._private.widget_caches[kind] then
-        widget._private.widget_caches[kind] = cache.new(function(...)
-            return protected_call(widget[kind], widget, ...)
-        end)
+-- While wibox.hierarchy lays out a widget, this records the fit queries that
+-- the widget's layout makes on its children, see base._layout_widget_recorded().
+local fit_recorder = nil
+
+-- The number of results that the fit and layout caches of a widget keep for
+-- each context. Only the most recently used ones are kept, so resizing does not
+-- make them grow.
+local cache_size = 32
+
+-- Statistics of the fit and layout caches of all widgets.
+local cache_stats = {
+    fit    = { hits = 0, misses = 0, evictions = 0 },
+    layout = { hits = 0, misses = 0, evictions = 0 },
+}
+
+-- Used instead of a missing context as a key.
+local no_context = {}
+
+-- Get the cache of the given kind for this widget and context. This returns a
+-- gears.lru_cache that calls the callback of kind `kind` on the widget.
+--
+-- The context contains the screen and the drawable. A widget can be shown in
+-- several drawables, so the caches are indexed weakly by context. This way, the
+-- caches do not keep removed screens and their wiboxes alive.
+local function get_cache(widget, kind, context)
+    local caches = widget._private.widget_caches[kind]
+    if not caches then
+        caches = setmetatable({}, { __mode = "k" })
+        widget._private.widget_caches[kind] = caches
     end
-    return widget._private.widget_caches[kind]
+
+    local cache = caches[context or no_context]
+    if not cache then
+        -- The value of a weak key must not reference it, so the callback only
+        -- gets a weak reference to the context.
+        local ref = setmetatable({ context }, { __mode = "v" })
+        cache = lru_cache.new(function(...)
+            if fit_recorder and fit_recorder.widget == widget and kind == "layout" then
+                fit_recorder.ran = true
+            end
+            return protected_call(widget[kind], widget, ref[1], ...)
+        end, cache_size, cache_stats[kind])
+        caches[context or no_context] = cache
+    end
+    return cache
 end
 
 -- Special value to skip the dependency recording that is normally done by
@@ -511,7 +547,15 @@ local clear_caches
 function clear_caches(widget)
     local deps = widget_dependencies[widget] or {}
     widget_dependencies[widget] = {}
-    widget._private.widget_caches = {}
+    if widget._private.widget_caches then
+        for _, caches in pairs(widget._private.widget_caches) do
+            for _, c in pairs(caches) do
+                c:clear()
+            end
+        end
+    else
+        widget._private.widget_caches = {}
+    end
     for w in pairs(deps) do
         clear_caches(w)
     end
@@ -519,6 +563,27 @@ end
 
 -- }}}
 
+--- Get the statistics of the fit and layout caches of all widgets.
+--
+-- Each widget keeps the most recent results of its `:fit` and `:layout`
+-- callbacks. The returned counters show how often these caches had a result
+-- (`hits`), how often the callback had to be called (`misses`) and how often
+-- a result was dropped to make room for a newer one (`evictions`).
+-- @staticfct wibox.widget.base.get_cache_stats
+-- @treturn table A table with the fields `fit` and `layout`, each with the
+--   fields `hits`, `misses` and `evictions`.
+function base.get_cache_stats()
+    local result = {}
+    for kind, stats in pairs(cache_stats) do
+        result[kind] = {
+            hits      = stats.hits,
+            misses    = stats.misses,
+            evictions = stats.evictions,
+        }
+    end
+    return result
+end
+
 --- Figure out the geometry in the device coordinate space.
 --
 -- This gives only tight bounds if no rotations by non-multiples of 90° are
@@ -537,6 +602,33 @@ function base.rect_to_device_geometry(cr, x, y, width, height)
     return matrix.transform_rectangle(cr.matrix, x, y, width, height)
 end
 
+-- Lay out a widget without telling the fit recorder about it.
+local function layout_widget(parent, context, widget, width, height)
+    record_dependency(parent, widget)
+
+    if not widget._private.visible then
+        return
+    end
+
+    -- Sanitize the input. This also filters out e.g. NaN.
+    width = math.max(0, width)
+    height = math.max(0, height)
+
+    if widget.layout then
+        return get_cache(widget, "layout", context):get(width, height)
+    end
+end
+
+-- Remember the result of fitting a child for the fit recorder.
+local function record_fit(parent, widget, width, height, w, h)
+    if fit_recorder and parent == fit_recorder.widget then
+        local queries = fit_recorder.children[widget] or {}
+        local n = #queries
+        fit_recorder.children[widget] = queries
+        queries[n + 1], queries[n + 2], queries[n + 3], queries[n + 4] = width, height, w, h
+    end
+end
+
 --- Fit a widget for the given available width and height.
 --
 -- This calls the widget's `:fit` callback and caches the result for later use.
@@ -554,6 +646,7 @@ function base.fit_widget(parent, context, widget, width, height)
     record_dependency(parent, widget)
 
     if not widget._private.visible then
+        record_fit(parent, widget, width, height, 0, 0)
         return 0, 0
     end
 
@@ -563,10 +656,10 @@ function base.fit_widget(parent, context, widget, width, height)
 
     local w, h = 0, 0
     if widget.fit then
-        w, h = get_cache(widget, "fit"):get(context, width, height)
+        w, h = get_cache(widget, "fit", context):get(width, height)
     else
         -- If it has no fit method, calculate based on the size of children
-        local children = base.layout_widget(parent, context, widget, width, height)
+        local children = layout_widget(parent, context, widget, width, height)
         for _, info in ipairs(children or {}) do
             local x, y, w2, h2 = matrix.transform_rectangle(info._matrix,
                 0, 0, info._width, info._height)
@@ -581,6 +674,8 @@ function base.fit_widget(parent, context, widget, width, height)
     -- Also sanitize the output.
     w = math.max(0, math.min(w, width))
     h = math.max(0, math.min(h, height))
+
+    record_fit(parent, widget, width, height, w, h)
     return w, h
 end
 
@@ -599,19 +694,45 @@ end
 -- @treturn[opt] table The result from the widget's `:layout` callback.
 -- @staticfct wibox.widget.base.layout_widget
 function base.layout_widget(parent, context, widget, width, height)
-    record_dependency(parent, widget)
-
-    if not widget._private.visible then
-        return
+    if fit_recorder and parent == fit_recorder.widget then
+        -- The layout depends on more than the size of its children.
+        fit_recorder.opaque = true
     end
+    return layout_widget(parent, context, widget, width, height)
+end
 
-    -- Sanitize the input. This also filters out e.g. NaN.
-    width = math.max(0, width)
-    height = math.max(0, height)
-
-    if widget.layout then
-        return get_cache(widget, "layout"):get(context, width, height)
-    end
+--- Lay out a widget and record the fit queries that its layout makes on its
+-- children.
+--
+-- This is used internally by `wibox.hierarchy` to find out if a change in the
+-- size of a child affects the layout of its parent.
+-- @param context The context in which we are laid out.
+-- @param widget The widget to layout.
+-- @tparam number width The available width for the widget.
+-- @tparam number height The available height for the widget.
+-- @return The result of `layout_widget`.
+-- @return A table with the fields `widget`, `context`, `width` and `height` of
+--   the call and `children`, which maps each child to a list of `width, height,
+--   fit width, fit height` quadruples. If the layout depends on more than
+--   the size of the children, the field `opaque` is true. This is `nil` if the
+--   layout came from the cache.
+-- @hidden
+function base._layout_widget_recorded(context, widget, width, height)
+    local recorder = {
+        widget   = widget,
+        context  = context,
+        width    = width,
+        height   = height,
+        children = {},
+        ran      = false,
+        opaque   = false,
+    }
+    local old_recorder = fit_recorder
+    fit_recorder = recorder
+    local result = layout_widget(base.no_parent_I_know_what_I_am_doing,
+        context, widget, width, height)
+    fit_recorder = old_recorder
+    return result, recorder.ran and recorder or nil
 end
 
 --- Handle a button event on a widget.
@@ -15,56 +15,175 @@ local gdebug = require("gears.debug")
 local beautiful = require("beautiful")
 local lgi = require("lgi")
 local gtable = require("gears.table")
+local lru_cache = require("gears.lru_cache")
 local Pango = lgi.Pango
 local PangoCairo = lgi.PangoCairo
+local cairo = lgi.cairo
 local setmetatable = setmetatable
 
 local textbox = { mt = {} }
 
---- Set the DPI of a Pango layout
-local function setup_dpi(box, dpi)
+-- Pango layouts are shared between all textboxes. They are kept in a cache that
+-- is keyed by the properties of the textbox, the size, the DPI and the state of
+-- the cairo context drawing them. This way, identical strings (e.g. in taglists
+-- and tasklists) are only measured once.
+local text_cache
+
+-- Pango contexts for the layouts in the text cache, indexed by DPI and cairo
+-- state. Drawing gives the Pango context the font options of the target surface
+-- and the transformation of the cairo context, so each combination needs its own
+-- Pango context. They go away with the last layout using them.
+local contexts = setmetatable({}, { __mode = "v" })
+
+-- A function that creates a Pango layout in the given context for the text
+-- cache, and the cairo context being drawn to, if any. They are set while the
+-- cache is queried.
+local make_layout, current_cr
+
+local default_options_hash = cairo.FontOptions.create():hash()
+
+-- Receives the font options of the surfaces that are drawn to.
+local target_options = cairo.FontOptions.create()
+
+-- Describe the state of a cairo context that matters to Pango. Contexts with
+-- no transformation besides a translation and the default font options share
+-- the Pango context used for measuring.
+local function get_cairo_state(cr)
+    if not cr then return "" end
+
+    cr:get_target():get_font_options(target_options)
+    local hash = target_options:hash()
+    local m = cr:get_matrix()
+    if m.xx == 1 and m.yx == 0 and m.xy == 0 and m.yy == 1 and hash == default_options_hash then
+        return ""
+    end
+    return table.concat({ m.xx, m.yx, m.xy, m.yy, hash }, " ")
+end
+
+local function get_context(dpi, state)
     assert(dpi, "No DPI provided")
-    if box._private.dpi ~= dpi then
-        box._private.dpi = dpi
-        box._private.ctx:set_resolution(dpi)
-        box._private.layout:context_changed()
+    local key = dpi .. " " .. state
+    local ctx = contexts[key]
+    if not ctx then
+        ctx = PangoCairo.font_map_get_default():create_context()
+        ctx:set_resolution(dpi)
+        if current_cr then
+            PangoCairo.update_context(current_cr, ctx)
+        end
+        contexts[key] = ctx
     end
+    return ctx
 end
 
---- Setup a pango layout for the given textbox and dpi
-local function setup_layout(box, width, height, dpi)
-    box._private.layout.width = Pango.units_from_double(width)
-    box._private.layout.height = Pango.units_from_double(height)
-    setup_dpi(box, dpi)
+text_cache = lru_cache.new(function(_, width, height, dpi, state)
+    local ctx = get_context(dpi, state)
+    local layout = make_layout(ctx)
+    layout.width = width
+    layout.height = height
+    local _, logical = layout:get_pixel_extents()
+    return {
+        layout  = layout,
+        context = ctx,
+        serial  = ctx:get_serial(),
+        width   = logical.width,
+        height  = logical.height,
+    }
+end, 256)
+
+-- Get a laid out Pango layout and its logical size from the text cache. The
+-- width and height are in Pango units. When a cairo context is given, the
+-- layout is ready to be drawn to it.
+local function get_cached_layout(key, creator, width, height, dpi, cr)
+    make_layout, current_cr = creator, cr
+    local entry = text_cache:get(key, width, height, dpi, get_cairo_state(cr))
+    make_layout, current_cr = nil, nil
+
+    -- Surfaces with the same font options can still differ in other ways that
+    -- matter to Pango, so the context is updated anyway. The size of the text
+    -- changes with it.
+    if cr then
+        PangoCairo.update_context(cr, entry.context)
+    end
+    local serial = entry.context:get_serial()
+    if serial ~= entry.serial then
+        local _, logical = entry.layout:get_pixel_extents()
+        entry.serial, entry.width, entry.height = serial, logical.width, logical.height
+    end
+    return entry
+end
+
+-- Get the key of a textbox in the text cache. It describes all properties of
+-- the textbox's Pango layout. The setters of these properties clear the key
+-- before they emit any signal, since handlers may fit the textbox right away.
+local function get_key(box)
+    local priv = box._private
+    local key = priv.cache_key
+    if not key then
+        key = table.concat({
+            priv.font_desc:to_string(),
+            tostring(priv.ellipsize),
+            tostring(priv.wrap),
+            tostring(priv.alignment),
+            tostring(priv.justify),
+            tostring(priv.indent),
+            tostring(priv.line_spacing),
+            priv.markup and "m" .. priv.markup or "t" .. priv.text,
+        }, "\0")
+        priv.cache_key = key
+    end
+    return key
+end
+
+-- Create the Pango layout of a textbox in the given context.
+local function create_layout(box, ctx)
+    local priv = box._private
+    local layout = Pango.Layout.new(ctx)
+    layout:set_font_description(priv.font_desc)
+    layout.text = priv.text
+    layout.attributes = priv.attributes
+    layout:set_ellipsize(priv.ellipsize)
+    layout:set_wrap(priv.wrap)
+    layout:set_alignment(priv.alignment)
+    layout:set_justify(priv.justify)
+    layout:set_indent(priv.indent)
+    if priv.line_spacing then
+        layout:set_line_spacing(priv.line_spacing)
+    end
+    return layout
+end
+
+-- Get the layout of a textbox for the given size in Pango units and DPI.
+local function get_layout(box, width, height, dpi, cr)
+    return get_cached_layout(get_key(box), function(ctx)
+        return create_layout(box, ctx)
+    end, width, height, dpi, cr)
 end
 
 -- Draw the given textbox on the given cairo context in the given geometry
 function textbox:draw(context, cr, width, height)
-    setup_layout(self, width, height, context.dpi)
-    cr:update_layout(self._private.layout)
-    local _, logical = self._private.layout:get_pixel_extents()
+    local entry = get_layout(self, Pango.units_from_double(width),
+        Pango.units_from_double(height), context.dpi, cr)
     local offset = 0
     if self._private.valign == "center" then
-        offset = (height - logical.height) / 2
+        offset = (height - entry.height) / 2
     elseif self._private.valign == "bottom" then
-        offset = height - logical.height
+        offset = height - entry.height
     end
     cr:move_to(0, offset)
-    cr:show_layout(self._private.layout)
+    cr:show_layout(entry.layout)
 end
 
-local function do_fit_return(self)
-    local _, logical = self._private.layout:get_pixel_extents()
-    if logical.width == 0 or logical.height == 0 then
+local function do_fit_return(entry)
+    if entry.width == 0 or entry.height == 0 then
         return 0, 0
     end
-    return logical.width, logical.height
+    return entry.width, entry.height
 end
 
 -- Fit the given textbox
 function textbox:fit(context, width, height)
-    setup_layout(self, width, height, context.dpi)
-    return do_fit_return(self)
+    return do_fit_return(get_layout(self, Pango.units_from_double(width),
+        Pango.units_from_double(height), context.dpi))
 end
 
 --- Get the preferred size of a textbox.
@@ -119,10 +238,8 @@ end
 -- @treturn number The preferred height.
 function textbox:get_preferred_size_at_dpi(dpi)
     local max_lines = 2^20
-    setup_dpi(self, dpi)
-    self._private.layout.width = -1 -- no width set
-    self._private.layout.height = -max_lines -- show this many lines per paragraph
-    return do_fit_return(self)
+    -- No width set and show this many lines per paragraph
+    return do_fit_return(get_layout(self, -1, -max_lines, dpi))
 end
 
 --- Get the preferred height of a textbox at a given width.
@@ -136,10 +253,8 @@ end
 -- @treturn number The needed height.
 function textbox:get_height_for_width_at_dpi(width, dpi)
     local max_lines = 2^20
-    setup_dpi(self, dpi)
-    self._private.layout.width = Pango.units_from_double(width)
-    self._private.layout.height = -max_lines -- show this many lines per paragraph
-    local _, h = do_fit_return(self)
+    -- Show this many lines per paragraph
+    local _, h = do_fit_return(get_layout(self, Pango.units_from_double(width), -max_lines, dpi))
     return h
 end
 
@@ -165,8 +280,9 @@ function textbox:set_markup_silently(text)
     end
 
     self._private.markup = text
-    self._private.layout.text = parsed
-    self._private.layout.attributes = attr
+    self._private.text = parsed
+    self._private.attributes = attr
+    self._private.cache_key = nil
     self:emit_signal("widget::redraw_needed")
     self:emit_signal("widget::layout_changed")
     self:emit_signal("property::markup", text)
@@ -223,19 +339,20 @@ end
 -- @see markup
 
 function textbox:set_text(text)
-    if self._private.layout.text == text and self._private.layout.attributes == nil then
+    if self._private.text == text and self._private.attributes == nil then
         return
     end
     self._private.markup = nil
-    self._private.layout.text = text
-    self._private.layout.attributes = nil
+    self._private.text = text
+    self._private.attributes = nil
+    self._private.cache_key = nil
     self:emit_signal("widget::redraw_needed")
     self:emit_signal("widget::layout_changed")
     self:emit_signal("property::text", text)
 end
 
 function textbox:get_text()
-    return self._private.layout.text
+    return self._private.text
 end
 
 --- Set the text ellipsize mode.
@@ -256,10 +373,11 @@ end
 function textbox:set_ellipsize(mode)
     local allowed = { none = "NONE", start = "START", middle = "MIDDLE", ["end"] = "END" }
     if allowed[mode] then
-        if self._private.layout:get_ellipsize() == allowed[mode] then
+        if self._private.ellipsize == allowed[mode] then
             return
         end
-        self._private.layout:set_ellipsize(allowed[mode])
+        self._private.ellipsize = allowed[mode]
+        self._private.cache_key = nil
         self:emit_signal("widget::redraw_needed")
         self:emit_signal("widget::layout_changed")
         self:emit_signal("property::ellipsize", mode)
@@ -280,10 +398,11 @@ end
 function textbox:set_wrap(mode)
     local allowed = { word = "WORD", char = "CHAR", word_char = "WORD_CHAR" }
     if allowed[mode] then
-        if self._private.layout:get_wrap() == allowed[mode] then
+        if self._private.wrap == allowed[mode] then
             return
         end
-        self._private.layout:set_wrap(allowed[mode])
+        self._private.wrap = allowed[mode]
+        self._private.cache_key = nil
         self:emit_signal("widget::redraw_needed")
         self:emit_signal("widget::layout_changed")
         self:emit_signal("property::wrap", mode)
@@ -311,6 +430,7 @@ function textbox:set_valign(mode)
             return
         end
         self._private.valign = mode
+        self._private.cache_key = nil
         self:emit_signal("widget::redraw_needed")
         self:emit_signal("widget::layout_changed")
         self:emit_signal("property::valign", mode)
@@ -342,10 +462,11 @@ end
 function textbox:set_halign(mode)
     local allowed = { left = "LEFT", center = "CENTER", right = "RIGHT" }
     if allowed[mode] then
-        if self._private.layout:get_alignment() == allowed[mode] then
+        if self._private.alignment == allowed[mode] then
             return
         end
-        self._private.layout:set_alignment(allowed[mode])
+        self._private.alignment = allowed[mode]
+        self._private.cache_key = nil
         self:emit_signal("widget::redraw_needed")
         self:emit_signal("widget::layout_changed")
         self:emit_signal("property::align", mode)
@@ -412,7 +533,8 @@ function textbox:set_font(font)
 
     self._private.font = font
 
-    self._private.layout:set_font_description(beautiful.get_font(font))
+    self._private.font_desc = beautiful.get_font(font)
+    self._private.cache_key = nil
     self:emit_signal("widget::redraw_needed")
     self:emit_signal("widget::layout_changed")
     self:emit_signal("property::font", font)
@@ -439,21 +561,22 @@ end
 -- @propemits true false
 
 function textbox:set_line_spacing_factor(spacing)
-    if not pcall(function() return self._private.layout.set_line_spacing ~= nil end) then
+    if not pcall(function() return Pango.Layout.set_line_spacing ~= nil end) then
         gdebug.print_error(debug.traceback(
             "Error your version of Pango is too old to support line_spacing"
         ))
     end
 
     spacing = spacing or 0
-    self._private.layout:set_line_spacing(spacing)
+    self._private.line_spacing = spacing
+    self._private.cache_key = nil
     self:emit_signal("widget::redraw_needed")
     self:emit_signal("widget::layout_changed")
     self:emit_signal("property::line_spacing", spacing)
 end
 
 function textbox:get_line_spacing_factor()
-    return self._private.layout:get_line_spacing()
+    return self._private.line_spacing or 0
 end
 
 --- Justify the text when there is more space.
@@ -465,14 +588,15 @@ end
 -- @propemits true false
 
 function textbox:set_justify(justify)
-    self._private.layout:set_justify(justify)
+    self._private.justify = justify and true or false
+    self._private.cache_key = nil
     self:emit_signal("widget::redraw_needed")
     self:emit_signal("widget::layout_changed")
     self:emit_signal("property::justify", justify)
 end
 
 function textbox:get_justify()
-    return self._private.layout:get_justify()
+    return self._private.justify
 end
 
 --- How to indent text with multiple lines.
@@ -488,14 +612,15 @@ end
 -- @propemits true false
 
 function textbox:set_indent(indent)
-    self._private.layout:set_indent(Pango.units_from_double(indent))
+    self._private.indent = Pango.units_from_double(indent)
+    self._private.cache_key = nil
     self:emit_signal("widget::redraw_needed")
     self:emit_signal("widget::layout_changed")
     self:emit_signal("property::indent", indent)
 end
 
 function textbox:get_indent()
-    return self._private.layout:get_indent()
+    return self._private.indent
 end
 
 --- Create a new textbox.
@@ -509,10 +634,11 @@ local function new(text, ignore_markup)
 
     gtable.crush(ret, textbox, true)
 
-    ret._private.dpi = -1
-    ret._private.ctx = PangoCairo.font_map_get_default():create_context()
-    ret._private.layout = Pango.Layout.new(ret._private.ctx)
-    ret._private.layout:set_font_description(beautiful.get_font(beautiful.font))
+    -- The properties of the Pango layout, which is created when needed
+    ret._private.text = ""
+    ret._private.font_desc = beautiful.get_font(beautiful.font)
+    ret._private.justify = false
+    ret._private.indent = 0
 
     ret:set_ellipsize("end")
     ret:set_wrap("word_char")
@@ -543,18 +669,35 @@ end
 -- @staticfct wibox.widget.textbox.get_markup_geometry
 function textbox.get_markup_geometry(text, s, font)
     font = font or beautiful.font
-    local pctx = PangoCairo.font_map_get_default():create_context()
-    local playout = Pango.Layout.new(pctx)
-    playout:set_font_description(beautiful.get_font(font))
-    local dpi_scale = beautiful.xresources.get_dpi(s)
-    pctx:set_resolution(dpi_scale)
-    playout:context_changed()
-    local attr, parsed = Pango.parse_markup(text, -1, 0)
-    playout.attributes, playout.text = attr, parsed
-    local _, logical = playout:get_pixel_extents()
+    local font_desc = beautiful.get_font(font)
+    local key = table.concat({ "geometry", font_desc:to_string(), text }, "\0")
+    local entry = get_cached_layout(key, function(ctx)
+        local playout = Pango.Layout.new(ctx)
+        playout:set_font_description(font_desc)
+        local attr, parsed = Pango.parse_markup(text, -1, 0)
+        playout.attributes, playout.text = attr, parsed
+        return playout
+    end, -1, -1, beautiful.xresources.get_dpi(s))
+    local _, logical = entry.layout:get_pixel_extents()
     return logical
 end
 
+--- Get the statistics of the cache of Pango layouts that all textboxes share.
+--
+-- The fields are `hits`, `misses` and `evictions` of the cache, as well as
+-- `count`, the number of layouts in the cache, and `max_count`, its limit.
+-- @treturn table The statistics.
+-- @staticfct wibox.widget.textbox.get_cache_stats
+function textbox.get_cache_stats()
+    return {
+        hits      = text_cache.stats.hits,
+        misses    = text_cache.stats.misses,
+        evictions = text_cache.stats.evictions,
+        count     = text_cache:get_count(),
+        max_count = text_cache.max_entries,
+    }
+end
+
 return setmetatable(textbox, textbox.mt)
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -40,15 +40,152 @@
  * @staticfct register_xproperty
  */
 
+/** Get statistics about the garbage collection done while idle.
+ *
+ * Before going to sleep, awesome runs the Lua garbage collector for at most
+ * `awesome.gc_budget()` microseconds, so that less collection work happens
+ * while handling input.
+ *
+ * @treturn table A table with the `cycles` count of collection cycles
+ *  finished while idle, the `steps` count of collection steps, the `time`
+ *  spent in microseconds, the `exhausted` count of iterations which used the
+ *  whole budget, the current `heap` size in bytes, and the current `budget`,
+ *  `step_size`, `pause` and `stepmul` settings.
+ * @staticfct gc_stats
+ * @see gc_budget
+ */
+
+/** Get or set the time spent collecting garbage before going to sleep.
+ *
+ * @tparam[opt] integer budget The new budget per main loop iteration, in
+ *  microseconds. Use 0 to only rely on the automatic collector.
+ * @treturn integer The budget, in microseconds.
+ * @staticfct gc_budget
+ * @see gc_stats
+ */
+
+/** Get statistics about the memory allocator of the Lua VM.
+ *
+ * The pooled allocator is enabled with `--lua-allocator pool`. It serves
+ * small blocks from slabs of fixed size classes and larger ones from malloc.
+ *
+ * @treturn table|nil A table with a `classes` array, where each entry has the
+ *  block `size` of the class, the `objects` count and requested `bytes` of
+ *  the blocks in use, the total `allocations` count and the `slabs` count;
+ *  a `large` table with the `objects`, `bytes` and `allocations` of the
+ *  blocks allocated with malloc; and the `reserved` bytes of all slabs. `nil`
+ *  when the system allocator is used.
+ * @staticfct alloc_stats
+ */
+
+/** Start the Lua sampling profiler.
+ *
+ * The Lua stack is sampled, either at a fixed rate of CPU time or every given
+ * number of Lua VM instructions, until `awesome.profiler_stop` is called.
+ * Sending SIGUSR2 to awesome also starts the profiler, and sending it again
+ * writes the profile to `$XDG_CACHE_HOME/awesome/`.
+ *
+ * @tparam[opt] table args
+ * @tparam[opt=1000] integer args.frequency The number of samples per second
+ *  of CPU time.
+ * @tparam[opt] integer args.instructions Sample every this many Lua VM
+ *  instructions instead.
+ * @noreturn
+ * @staticfct profiler_start
+ * @see profiler_stop
+ */
+
+/** Stop the Lua sampling profiler.
+ *
+ * The profile is made of collapsed stacks, as used by `flamegraph.pl`: one
+ * line per stack, with the frames separated by semicolons from the outermost
+ * one, followed by its number of samples.
+ *
+ * @tparam[opt] string path Where to write the profile.
+ * @treturn integer The number of samples.
+ * @treturn[opt] string The profile, when no path is given.
+ * @staticfct profiler_stop
+ * @see profiler_start
+ */
+
+/** Enable or disable the tracking of synchronous X round-trips.
+ *
+ * While tracking is enabled, each wait for a reply of the X server is timed
+ * and attributed to the current Lua traceback. Enabling it clears the data
+ * collected so far. Tracking can also be enabled from the start with the
+ * `--track-roundtrips` command line option.
+ *
+ * Only available when awesome is built with `WITH_XCB_INTERPOSER`, the
+ * default for debug builds.
+ *
+ * @tparam boolean enable
+ * @treturn boolean Whether tracking was enabled before.
+ * @staticfct track_roundtrips
+ * @see roundtrip_report
+ */
+
+/** Get the places which waited the longest for the X server.
+ *
+ * @tparam[opt=20] integer limit The maximum number of entries.
+ * @treturn table|nil The entries, sorted by the time spent waiting, or `nil`
+ *  when tracking is disabled. Each entry has the name of the `request` whose
+ *  reply was awaited (`"EXTENSION:minor"` for extensions), the Lua
+ *  `traceback`, the `count` of waits, their total `time` and
+ *  the longest one, `max`, in microseconds. The table also has the total
+ *  `count` and `time` of all the waits.
+ * @staticfct roundtrip_report
+ * @see track_roundtrips
+ */
+
+/** Enable or disable the accounting of X requests.
+ *
+ * While accounting is enabled, every request sent to the X server is counted
+ * by opcode and by the phase of the main loop iteration which sent it.
+ * Enabling it clears the counters. It is enabled from the start when
+ * `--profile-startup` is used.
+ *
+ * Only available when awesome is built with `WITH_XCB_INTERPOSER`, the
+ * default for debug builds.
+ *
+ * @tparam boolean enable
+ * @treturn boolean Whether accounting was enabled before.
+ * @staticfct track_xrequests
+ * @see xrequest_report
+ */
+
+/** Get the number of X requests sent since the accounting was enabled.
+ *
+ * Each counter is a table with the number of `requests` and the `bytes` of
+ * their data.
+ *
+ * @treturn table|nil `nil` when accounting is disabled. Otherwise a table
+ *  with the total `requests` and `bytes`, the number of main loop
+ *  `iterations`, the `max_iteration` counter of the iteration which sent the
+ *  most, a `phases` table of counters by phase (`events`, `refresh`,
+ *  `drawin`, `client_geometry`, `client`, `banning`, `stack`, `destroy`,
+ *  `ewmh` and `grabs`), an `opcodes` table of counters by request name
+ *  (`"EXTENSION:minor"` for extensions) and a `histogram` array. Each entry
+ *  of the histogram counts the `iterations` which sent at most `max`
+ *  requests and more than the previous entry.
+ * @staticfct xrequest_report
+ * @see track_xrequests
+ */
+
 #define _GNU_SOURCE
 
 #include "luaa.h"
 #include "globalconf.h"
 #include "awesome.h"
 #include "common/backtrace.h"
+#include "common/luasignal.h"
 #include "common/version.h"
 #include "config.h"
 #include "event.h"
+#include "ewmh.h"
+#include "luaalloc.h"
+#include "luacache.h"
+#include "luagc.h"
+#include "luaprof.h"
 #include "objects/client.h"
 #include "objects/drawable.h"
 #include "objects/drawin.h"
@@ -59,11 +196,14 @@
 #include "objects/selection_watcher.h"
 #include "objects/tag.h"
 #include "property.h"
+#include "roundtrip.h"
 #include "selection.h"
 #include "spawn.h"
+#include "startup.h"
 #include "systray.h"
 #include "xkb.h"
 #include "xrdb.h"
+#include "xrequest.h"
 
 #include <lua.h>
 #include <lauxlib.h>
@@ -92,7 +232,7 @@ extern const struct luaL_Reg awesome_mouse_meta[];
 extern const struct luaL_Reg awesome_root_methods[];
 extern const struct luaL_Reg awesome_root_meta[];
 
-signal_array_t global_signals;
+signal_hashmap_t global_signals;
 
 /** A call into the Lua code aborted with an error.
  *
@@ -303,6 +443,37 @@ luaA_sync(lua_State *L)
     return 0;
 }
 
+/** Call a function while batching the property signals of objects.
+ *
+ * While the function runs, the `property::` signals without arguments which
+ * awesome emits on its objects (clients, tags, screens, ...) are queued
+ * instead of being emitted. A signal is queued once per object, however often
+ * it is emitted, and the queue is emitted when the function returns, in the
+ * order the signals were first emitted. This is useful when updating many
+ * objects at once, so that e.g. the layouts and widgets which depend on them
+ * are only updated once. Signals emitted from Lua with `emit_signal` are not
+ * batched. Nested batches are emitted when the outermost one ends.
+ *
+ * @tparam function fn The function to call.
+ * @param ... Arguments for the function.
+ * @return The values returned by the function.
+ * @staticfct batch
+ */
+static int
+luaA_batch(lua_State *L)
+{
+    luaA_checkfunction(L, 1);
+
+    luaA_object_batch_begin();
+    int status = lua_pcall(L, lua_gettop(L) - 1, LUA_MULTRET, 0);
+    /* The signals are emitted even when the function failed */
+    luaA_object_batch_end(L);
+
+    if(status != 0)
+        return lua_error(L);
+    return lua_gettop(L);
+}
+
 /** Translate a GdkPixbuf to a cairo image surface..
  *
  * @param pixbuf The pixbuf as a light user datum.
@@ -1081,6 +1252,42 @@ add_to_search_path(lua_State *L, string_array_t *searchpath, bool for_lua)
     }
 }
 
+/** Get statistics about the memory allocator of the Lua VM.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_alloc_stats(lua_State *L)
+{
+    if(!globalconf.lua_pool)
+        return 0;
+    return luaA_pool_push_stats(L, globalconf.lua_pool);
+}
+
+/** Create the Lua VM state, with the pooled allocator when enabled.
+ * \return The new Lua VM state.
+ */
+static lua_State *
+luaA_newstate(void)
+{
+    lua_State *L;
+
+    if(!globalconf.lua_pool_allocator)
+        return luaL_newstate();
+
+    globalconf.lua_pool = luaA_pool_new();
+    L = globalconf.lua_pool ? lua_newstate(luaA_pool_alloc, globalconf.lua_pool) : NULL;
+    if(!L)
+    {
+        /* LuaJIT on 64 bits platforms does not support custom allocators */
+        warn("Cannot use the pooled Lua allocator, using the system one");
+        luaA_pool_delete(&globalconf.lua_pool);
+        return luaL_newstate();
+    }
+
+    return L;
+}
+
 /** Initialize the Lua VM
  * \param xdg An xdg handle to use to get XDG basedir.
  */
@@ -1112,11 +1319,27 @@ luaA_init(xdgHandle* xdg, string_array_t *searchpath)
         { "xrdb_get_value", luaA_xrdb_get_value},
         { "kill", luaA_kill},
         { "sync", luaA_sync},
+        { "batch", luaA_batch},
         { "_get_key_name", luaA_get_key_name},
+        { "_ewmh_stats", luaA_ewmh_root_list_stats},
+        { "_bytecode_cache_stats", luaA_cache_stats},
+        { "_startup_profile_begin", luaA_startup_profile_begin},
+        { "_startup_profile_end", luaA_startup_profile_end},
+        { "gc_stats", luaA_gc_stats},
+        { "gc_budget", luaA_gc_budget},
+        { "alloc_stats", luaA_alloc_stats},
+        { "profiler_start", luaA_profiler_start},
+        { "profiler_stop", luaA_profiler_stop},
+#ifdef WITH_XCB_INTERPOSER
+        { "track_roundtrips", luaA_track_roundtrips},
+        { "roundtrip_report", luaA_roundtrip_report},
+        { "track_xrequests", luaA_track_xrequests},
+        { "xrequest_report", luaA_xrequest_report},
+#endif
         { NULL, NULL }
     };
 
-    L = globalconf.L.real_L_dont_use_directly = luaL_newstate();
+    L = globalconf.L.real_L_dont_use_directly = luaA_newstate();
 
     /* Set panic function */
     lua_atpanic(L, luaA_panic);
@@ -1133,6 +1356,7 @@ luaA_init(xdgHandle* xdg, string_array_t *searchpath)
     /* Export awesome lib */
     luaA_openlib(L, "awesome", awesome_lib, awesome_lib);
     setup_awesome_signals(L);
+    luaA_signal_store_setup(L);
 
     /* Export root lib */
     luaA_openlib(L, "root", awesome_root_methods, awesome_root_meta);
@@ -1209,6 +1433,12 @@ luaA_init(xdgHandle* xdg, string_array_t *searchpath)
     lua_setfield(L, 1, "cpath"); /* package.cpath = "concatenated string" */
 
     lua_pop(L, 1); /* pop "package" */
+
+    /* Load Lua files from the bytecode cache when possible */
+    luaA_cache_init(L, xdg);
+
+    /* Record the modules loaded during startup with --profile-startup */
+    startup_profile_setup(L);
 }
 
 static void
@@ -1223,7 +1453,7 @@ static bool
 luaA_loadrc(const char *confpath)
 {
     lua_State *L = globalconf_get_lua_State();
-    if(luaL_loadfile(L, confpath))
+    if(luaA_cache_loadfile(L, confpath))
     {
         const char *err = lua_tostring(L, -1);
         luaA_startup_error(err);
@@ -0,0 +1,444 @@
+/*
+ * luaalloc.c - pooled memory allocator for the Lua VM
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* Most of what Lua allocates are small tables, closures, upvalues and
+ * strings. Blocks up to POOL_MAX_SMALL bytes are taken from slabs: aligned
+ * chunks of POOL_SLAB_SIZE bytes, each holding blocks of a single size class.
+ * Lua tells the allocator the size of the block it frees, so blocks need no
+ * header. The slab of a block is found by masking its address.
+ *
+ * Keeping blocks of the same size together avoids the fragmentation that
+ * malloc shows with long running sessions. Slabs which become empty are given
+ * back, except for the last one of each size class.
+ *
+ * Larger blocks go to malloc.
+ */
+
+#include "luaalloc.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+/** Size and alignment of a slab */
+#define POOL_SLAB_SIZE (64 * 1024)
+/** Largest block size served from slabs */
+#define POOL_MAX_SMALL 256
+/** Granularity of the size classes, also the alignment of blocks */
+#define POOL_GRANULARITY 16
+
+typedef struct pool_slab pool_slab_t;
+
+/** A slab, followed by its blocks */
+struct pool_slab
+{
+    /** Neighbours in the list of slabs of the class with free blocks */
+    pool_slab_t *prev, *next;
+    /** Neighbours in the list of all slabs of the pool */
+    pool_slab_t *all_prev, *all_next;
+    /** Freed blocks, linked through their first word */
+    void *free;
+    /** Part of the slab which was never handed out */
+    char *unused, *end;
+    /** Index of the size class */
+    int class;
+    /** Number of blocks in use */
+    unsigned int used;
+};
+
+/** Offset of the first block in a slab */
+#define POOL_HEADER_SIZE \
+    ((sizeof(pool_slab_t) + POOL_GRANULARITY - 1) & ~(size_t) (POOL_GRANULARITY - 1))
+
+/** The size classes */
+static const size_t pool_class_sizes[] =
+{
+    16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256
+};
+
+#define POOL_CLASS_COUNT (sizeof(pool_class_sizes) / sizeof(pool_class_sizes[0]))
+
+typedef struct
+{
+    /** Slabs with free blocks */
+    pool_slab_t *partial;
+    /** Number of slabs */
+    size_t slabs;
+    /** Number of blocks in use */
+    size_t objects;
+    /** Number of bytes requested by Lua for these blocks */
+    size_t bytes;
+    /** Total number of allocations */
+    size_t allocations;
+} pool_class_t;
+
+struct luaA_pool
+{
+    pool_class_t classes[POOL_CLASS_COUNT];
+    /** All slabs, to free them with the pool */
+    pool_slab_t *slabs;
+    /** Size class for each multiple of POOL_GRANULARITY */
+    int class_of[POOL_MAX_SMALL / POOL_GRANULARITY + 1];
+    /** Blocks allocated with malloc */
+    size_t large_objects, large_bytes, large_allocations;
+    /** Blocks allocated with malloc that were shrunk to a small size, see
+     * luaA_pool_alloc() */
+    size_t strays;
+};
+
+/** Get the size class of a block size.
+ * \param pool The pool.
+ * \param size The block size.
+ * \return The class index, or -1 for blocks not served from slabs.
+ */
+static inline int
+pool_class(luaA_pool_t *pool, size_t size)
+{
+    if(size > POOL_MAX_SMALL)
+        return -1;
+    return pool->class_of[(size + POOL_GRANULARITY - 1) / POOL_GRANULARITY];
+}
+
+static inline bool
+pool_slab_is_full(pool_slab_t *slab, size_t size)
+{
+    return !slab->free && slab->unused + size > slab->end;
+}
+
+static void
+pool_partial_unlink(pool_class_t *cls, pool_slab_t *slab)
+{
+    if(slab->prev)
+        slab->prev->next = slab->next;
+    else
+        cls->partial = slab->next;
+    if(slab->next)
+        slab->next->prev = slab->prev;
+    slab->prev = slab->next = NULL;
+}
+
+static void
+pool_partial_push(pool_class_t *cls, pool_slab_t *slab)
+{
+    slab->prev = NULL;
+    slab->next = cls->partial;
+    if(cls->partial)
+        cls->partial->prev = slab;
+    cls->partial = slab;
+}
+
+static void *
+pool_small_alloc(luaA_pool_t *pool, int class, size_t nsize)
+{
+    pool_class_t *cls = &pool->classes[class];
+    size_t size = pool_class_sizes[class];
+    pool_slab_t *slab = cls->partial;
+    void *block;
+
+    if(!slab)
+    {
+        void *mem;
+        if(posix_memalign(&mem, POOL_SLAB_SIZE, POOL_SLAB_SIZE) != 0)
+            return NULL;
+        slab = mem;
+        slab->free = NULL;
+        slab->unused = (char *) mem + POOL_HEADER_SIZE;
+        slab->end = (char *) mem + POOL_SLAB_SIZE;
+        slab->class = class;
+        slab->used = 0;
+        pool_partial_push(cls, slab);
+        cls->slabs++;
+
+        slab->all_prev = NULL;
+        slab->all_next = pool->slabs;
+        if(pool->slabs)
+            pool->slabs->all_prev = slab;
+        pool->slabs = slab;
+    }
+
+    if(slab->free)
+    {
+        block = slab->free;
+        slab->free = *(void **) block;
+    }
+    else
+    {
+        block = slab->unused;
+        slab->unused += size;
+    }
+
+    slab->used++;
+    if(pool_slab_is_full(slab, size))
+        pool_partial_unlink(cls, slab);
+
+    cls->objects++;
+    cls->bytes += nsize;
+    cls->allocations++;
+
+    return block;
+}
+
+static void
+pool_small_free(luaA_pool_t *pool, void *ptr, size_t osize)
+{
+    pool_slab_t *slab = (pool_slab_t *) ((uintptr_t) ptr & ~(uintptr_t) (POOL_SLAB_SIZE - 1));
+    pool_class_t *cls = &pool->classes[slab->class];
+    size_t size = pool_class_sizes[slab->class];
+    bool was_full = pool_slab_is_full(slab, size);
+
+    *(void **) ptr = slab->free;
+    slab->free = ptr;
+    slab->used--;
+
+    cls->objects--;
+    cls->bytes -= osize;
+
+    if(was_full)
+        pool_partial_push(cls, slab);
+
+    /* Give empty slabs back, but keep one around to avoid thrashing */
+    if(slab->used == 0 && (slab->prev || slab->next))
+    {
+        pool_partial_unlink(cls, slab);
+        cls->slabs--;
+
+        if(slab->all_prev)
+            slab->all_prev->all_next = slab->all_next;
+        else
+            pool->slabs = slab->all_next;
+        if(slab->all_next)
+            slab->all_next->all_prev = slab->all_prev;
+        free(slab);
+    }
+}
+
+static void *
+pool_malloc(luaA_pool_t *pool, size_t nsize)
+{
+    int class = pool_class(pool, nsize);
+
+    if(class >= 0)
+        return pool_small_alloc(pool, class, nsize);
+
+    void *block = malloc(nsize);
+    if(block)
+    {
+        pool->large_objects++;
+        pool->large_bytes += nsize;
+        pool->large_allocations++;
+    }
+    return block;
+}
+
+/** Check whether a block of a small size was allocated with malloc.
+ * \param pool The pool.
+ * \param ptr The block.
+ * \return True if the block is not part of a slab.
+ */
+static bool
+pool_is_stray(luaA_pool_t *pool, void *ptr)
+{
+    pool_slab_t *slab = (pool_slab_t *) ((uintptr_t) ptr & ~(uintptr_t) (POOL_SLAB_SIZE - 1));
+
+    for(pool_slab_t *s = pool->slabs; s; s = s->all_next)
+        if(s == slab)
+            return false;
+    return true;
+}
+
+static void
+pool_free(luaA_pool_t *pool, void *ptr, size_t osize)
+{
+    bool small = pool_class(pool, osize) >= 0;
+
+    /* Only look for strays if there are any, this is slow */
+    if(small && pool->strays > 0 && pool_is_stray(pool, ptr))
+    {
+        pool->strays--;
+        small = false;
+    }
+
+    if(small)
+        pool_small_free(pool, ptr, osize);
+    else
+    {
+        pool->large_objects--;
+        pool->large_bytes -= osize;
+        free(ptr);
+    }
+}
+
+/** Create a new pool.
+ * \return The new pool, to be given to lua_newstate() with luaA_pool_alloc().
+ */
+luaA_pool_t *
+luaA_pool_new(void)
+{
+    luaA_pool_t *pool = calloc(1, sizeof(*pool));
+    if(!pool)
+        return NULL;
+
+    int class = 0;
+    for(size_t i = 0; i <= POOL_MAX_SMALL / POOL_GRANULARITY; i++)
+    {
+        while(pool_class_sizes[class] < i * POOL_GRANULARITY)
+            class++;
+        pool->class_of[i] = class;
+    }
+
+    return pool;
+}
+
+/** Delete a pool. The Lua state using it must already be closed.
+ * \param pool A pointer to the pool.
+ */
+void
+luaA_pool_delete(luaA_pool_t **pool)
+{
+    if(!*pool)
+        return;
+
+    while((*pool)->slabs)
+    {
+        pool_slab_t *slab = (*pool)->slabs;
+        (*pool)->slabs = slab->all_next;
+        free(slab);
+    }
+
+    free(*pool);
+    *pool = NULL;
+}
+
+/** The lua_Alloc function of the pool.
+ * \param ud The pool.
+ * \param ptr The block to resize, or NULL.
+ * \param osize The current size of the block.
+ * \param nsize The new size of the block, 0 to free it.
+ * \return The resized block.
+ */
+void *
+luaA_pool_alloc(void *ud, void *ptr, size_t osize, size_t nsize)
+{
+    luaA_pool_t *pool = ud;
+
+    if(nsize == 0)
+    {
+        if(ptr)
+            pool_free(pool, ptr, osize);
+        return NULL;
+    }
+
+    if(!ptr)
+        return pool_malloc(pool, nsize);
+
+    int oclass = pool_class(pool, osize);
+    int nclass = pool_class(pool, nsize);
+
+    if(oclass >= 0 && oclass == nclass)
+    {
+        /* Still fits in the same block */
+        pool->classes[oclass].bytes += nsize - osize;
+        return ptr;
+    }
+
+    if(oclass < 0 && nclass < 0)
+    {
+        void *block = realloc(ptr, nsize);
+        if(block)
+            pool->large_bytes += nsize - osize;
+        return block;
+    }
+
+    void *block = pool_malloc(pool, nsize);
+    if(!block)
+    {
+        if(nsize > osize)
+            return NULL;
+
+        /* Lua assumes that shrinking never fails, so keep the old block. A
+         * block in a slab is found by its address when it is freed. A block
+         * from malloc now has a small size and has to be told apart from the
+         * blocks in slabs. */
+        if(oclass >= 0)
+            pool->classes[oclass].bytes -= osize - nsize;
+        else
+        {
+            pool->large_bytes -= osize - nsize;
+            pool->strays++;
+        }
+        return ptr;
+    }
+    memcpy(block, ptr, osize < nsize ? osize : nsize);
+    pool_free(pool, ptr, osize);
+    return block;
+}
+
+/** Push a table with the pool statistics.
+ * \param L The Lua VM state.
+ * \param pool The pool.
+ * \return The number of elements pushed on stack.
+ */
+int
+luaA_pool_push_stats(lua_State *L, luaA_pool_t *pool)
+{
+    size_t reserved = 0;
+
+    lua_createtable(L, 0, 3);
+
+    lua_createtable(L, POOL_CLASS_COUNT, 0);
+    for(size_t i = 0; i < POOL_CLASS_COUNT; i++)
+    {
+        pool_class_t *cls = &pool->classes[i];
+
+        lua_createtable(L, 0, 5);
+        lua_pushinteger(L, pool_class_sizes[i]);
+        lua_setfield(L, -2, "size");
+        lua_pushinteger(L, cls->objects);
+        lua_setfield(L, -2, "objects");
+        lua_pushinteger(L, cls->bytes);
+        lua_setfield(L, -2, "bytes");
+        lua_pushinteger(L, cls->allocations);
+        lua_setfield(L, -2, "allocations");
+        lua_pushinteger(L, cls->slabs);
+        lua_setfield(L, -2, "slabs");
+        lua_rawseti(L, -2, i + 1);
+
+        reserved += cls->slabs * POOL_SLAB_SIZE;
+    }
+    lua_setfield(L, -2, "classes");
+
+    lua_createtable(L, 0, 3);
+    lua_pushinteger(L, pool->large_objects);
+    lua_setfield(L, -2, "objects");
+    lua_pushinteger(L, pool->large_bytes);
+    lua_setfield(L, -2, "bytes");
+    lua_pushinteger(L, pool->large_allocations);
+    lua_setfield(L, -2, "allocations");
+    lua_setfield(L, -2, "large");
+
+    lua_pushinteger(L, reserved);
+    lua_setfield(L, -2, "reserved");
+
+    return 1;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
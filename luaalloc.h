@@ -0,0 +1,36 @@
+/*
+ * luaalloc.h - pooled memory allocator for the Lua VM header
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_LUAALLOC_H
+#define AWESOME_LUAALLOC_H
+
+#include <stddef.h>
+#include <lua.h>
+
+typedef struct luaA_pool luaA_pool_t;
+
+luaA_pool_t *luaA_pool_new(void);
+void luaA_pool_delete(luaA_pool_t **);
+void *luaA_pool_alloc(void *, void *, size_t, size_t);
+int luaA_pool_push_stats(lua_State *, luaA_pool_t *);
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,320 @@
+/*
+ * luacache.c - Lua bytecode cache
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* rc.lua and the modules found through package.path are compiled once and
+ * their bytecode is kept in $XDG_CACHE_HOME/awesome/bytecode. Each cache file
+ * starts with a header made of the Lua version, the modification time and
+ * size of the source file and its path. A cache file is only used when its
+ * header is the one expected for the source file as it is now, anything else
+ * means compiling the source again and replacing the cache file.
+ *
+ * The bytecode keeps its debug information, so error messages and tracebacks
+ * look the same as with the source.
+ */
+
+#define _GNU_SOURCE
+
+#include "luacache.h"
+#include "globalconf.h"
+#include "luaa.h"
+
+#include <lauxlib.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CACHE_MAGIC "awesome-bytecode-1\n"
+
+static struct
+{
+    /** Directory of the cache files, NULL when the cache is disabled */
+    char *dir;
+    /** Version of the Lua VM which produced the bytecode */
+    char *version;
+    /** Number of files loaded from the cache */
+    unsigned int hits;
+    /** Number of files compiled from source */
+    unsigned int misses;
+    /** Number of cache files written */
+    unsigned int writes;
+    /** Number of cache files which could not be written */
+    unsigned int errors;
+    /** Time spent loading files, in microseconds */
+    gint64 hit_time, miss_time;
+} cache;
+
+/** Build the header expected at the start of the cache file of a source file.
+ * \param path The path of the source file.
+ * \param st The status of the source file.
+ * \return The header, to be freed with g_string_free().
+ */
+static GString *
+cache_header(const char *path, const struct stat *st)
+{
+    GString *header = g_string_new(CACHE_MAGIC);
+
+    g_string_append_printf(header, "%s\n%" PRId64 ".%09ld %" PRId64 "\n%s\n",
+                           cache.version,
+                           (int64_t) st->st_mtim.tv_sec, (long) st->st_mtim.tv_nsec,
+                           (int64_t) st->st_size, path);
+    return header;
+}
+
+/** Get the path of the cache file of a source file.
+ * \param path The path of the source file.
+ * \return The path of the cache file, to be freed with g_free().
+ */
+static char *
+cache_file(const char *path)
+{
+    /* FNV-1a, collisions are caught by the path in the header */
+    uint64_t hash = UINT64_C(14695981039346656037);
+    for(const char *c = path; *c; c++)
+        hash = (hash ^ (unsigned char) *c) * UINT64_C(1099511628211);
+
+    char name[sizeof("0123456789abcdef.luac")];
+    snprintf(name, sizeof(name), "%016" PRIx64 ".luac", hash);
+    return g_build_filename(cache.dir, name, NULL);
+}
+
+static int
+cache_writer(lua_State *L, const void *p, size_t sz, void *ud)
+{
+    g_string_append_len(ud, p, sz);
+    return 0;
+}
+
+/** Load a Lua file, using its cached bytecode when it is up to date.
+ * This behaves like luaL_loadfile().
+ * \param L The Lua VM state.
+ * \param path The path of the file.
+ * \return 0 on success, an error code of luaL_loadfile() otherwise.
+ */
+int
+luaA_cache_loadfile(lua_State *L, const char *path)
+{
+    struct stat st;
+
+    if(!cache.dir || stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+        return luaL_loadfile(L, path);
+
+    gint64 start = g_get_monotonic_time();
+    GString *header = cache_header(path, &st);
+    char *file = cache_file(path);
+    char *contents;
+    gsize length;
+
+    if(g_file_get_contents(file, &contents, &length, NULL))
+    {
+        bool loaded = false;
+
+        if(length > header->len && memcmp(contents, header->str, header->len) == 0)
+        {
+            char *chunkname = g_strdup_printf("@%s", path);
+            loaded = luaL_loadbuffer(L, contents + header->len, length - header->len, chunkname) == 0;
+            g_free(chunkname);
+            /* Bytecode of another build of the same Lua version */
+            if(!loaded)
+                lua_pop(L, 1);
+        }
+        g_free(contents);
+
+        if(loaded)
+        {
+            cache.hits++;
+            cache.hit_time += g_get_monotonic_time() - start;
+            g_string_free(header, TRUE);
+            g_free(file);
+            return 0;
+        }
+    }
+
+    int ret = luaL_loadfile(L, path);
+    if(ret == 0)
+    {
+        cache.misses++;
+        cache.miss_time += g_get_monotonic_time() - start;
+
+        /* The header is followed by the bytecode */
+#if LUA_VERSION_NUM >= 503
+        lua_dump(L, cache_writer, header, 0);
+#else
+        lua_dump(L, cache_writer, header);
+#endif
+        /* Written to a temporary file first, then renamed */
+        if(g_file_set_contents(file, header->str, header->len, NULL))
+            cache.writes++;
+        else
+            cache.errors++;
+    }
+
+    g_string_free(header, TRUE);
+    g_free(file);
+    return ret;
+}
+
+/** Find a module in package.path and load it through the cache.
+ * This is a package searcher, replacing the default one for Lua files.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_cache_searcher(lua_State *L)
+{
+    const char *name = luaL_checkstring(L, 1);
+
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "path");
+    const char *path = lua_tostring(L, -1);
+    if(!path)
+        return 0;
+
+    char *module = g_strdup(name);
+    for(char *c = module; *c; c++)
+        if(*c == '.')
+            *c = G_DIR_SEPARATOR;
+
+    char **templates = g_strsplit(path, ";", -1);
+    char *filename = NULL;
+
+    for(char **template = templates; *template && !filename; template++)
+    {
+        if(!**template)
+            continue;
+
+        char **parts = g_strsplit(*template, "?", -1);
+        char *candidate = g_strjoinv(module, parts);
+        g_strfreev(parts);
+
+        if(access(candidate, R_OK) == 0)
+            filename = candidate;
+        else
+            g_free(candidate);
+    }
+
+    g_strfreev(templates);
+    g_free(module);
+
+    /* Let the default searcher report where it looked */
+    if(!filename)
+        return 0;
+
+    if(luaA_cache_loadfile(L, filename) != 0)
+    {
+        const char *err = lua_tostring(L, -1);
+        lua_pushfstring(L, "error loading module '%s' from file '%s':\n\t%s",
+                        name, filename, err);
+        g_free(filename);
+        return lua_error(L);
+    }
+
+    lua_pushstring(L, filename);
+    g_free(filename);
+    return 2;
+}
+
+/** Enable the bytecode cache, unless it was disabled with --no-cache.
+ * This must be called once package.path is set up.
+ * \param L The Lua VM state.
+ * \param xdg An xdg handle to use to get XDG basedir.
+ */
+void
+luaA_cache_init(lua_State *L, xdgHandle *xdg)
+{
+    if(globalconf.no_lua_cache)
+        return;
+
+    char *dir = g_build_filename(xdgCacheHome(xdg), "awesome", "bytecode", NULL);
+    if(g_mkdir_with_parents(dir, 0700) != 0)
+    {
+        warn("Cannot create %s, Lua bytecode will not be cached", dir);
+        g_free(dir);
+        return;
+    }
+    cache.dir = dir;
+
+    /* LuaJIT and PUC Lua share version numbers but not their bytecode */
+    lua_getglobal(L, "jit");
+    if(lua_istable(L, -1))
+        lua_getfield(L, -1, "version");
+    else
+        lua_pushnil(L);
+    cache.version = g_strdup_printf("%s %s %zu", LUA_VERSION,
+                                    lua_isstring(L, -1) ? lua_tostring(L, -1) : "",
+                                    sizeof(void *) * 8);
+    lua_pop(L, 2);
+
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "searchers");
+    if(!lua_istable(L, -1))
+    {
+        lua_pop(L, 1);
+        lua_getfield(L, -1, "loaders");
+    }
+    if(!lua_istable(L, -1))
+    {
+        lua_pop(L, 2);
+        return;
+    }
+
+    /* Insert it after package.preload */
+    for(int i = luaA_rawlen(L, -1); i >= 2; i--)
+    {
+        lua_rawgeti(L, -1, i);
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_pushcfunction(L, luaA_cache_searcher);
+    lua_rawseti(L, -2, 2);
+
+    lua_pop(L, 2);
+}
+
+/** Push statistics about the bytecode cache.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+luaA_cache_stats(lua_State *L)
+{
+    lua_createtable(L, 0, 8);
+    lua_pushboolean(L, cache.dir != NULL);
+    lua_setfield(L, -2, "enabled");
+    lua_pushstring(L, cache.dir);
+    lua_setfield(L, -2, "directory");
+    lua_pushinteger(L, cache.hits);
+    lua_setfield(L, -2, "hits");
+    lua_pushinteger(L, cache.misses);
+    lua_setfield(L, -2, "misses");
+    lua_pushinteger(L, cache.writes);
+    lua_setfield(L, -2, "writes");
+    lua_pushinteger(L, cache.errors);
+    lua_setfield(L, -2, "errors");
+    lua_pushinteger(L, cache.hit_time);
+    lua_setfield(L, -2, "hit_time");
+    lua_pushinteger(L, cache.miss_time);
+    lua_setfield(L, -2, "miss_time");
+    return 1;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,226 @@
+/*
+ * luagc.c - Lua garbage collection scheduling
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* Lua collects garbage in small steps whenever it allocates memory, which
+ * means in the middle of event handling. Here, the collector is also stepped
+ * right before the main loop goes to sleep, for at most a fixed time budget.
+ *
+ * As long as those idle steps keep up with the allocations, the automatic
+ * collector is made lazier (higher pause, lower step multiplier) so that less
+ * collection work happens while handling events. When the idle steps fall
+ * behind, the automatic collector is given its defaults back.
+ */
+
+#include "luagc.h"
+#include "luaa.h"
+
+#include <glib.h>
+
+/** Default budget per main loop iteration, in microseconds */
+#define GC_DEFAULT_BUDGET 1000
+/** Bounds of the work done by one idle step, in kilobytes */
+#define GC_STEP_MIN 1
+#define GC_STEP_MAX 1024
+
+static struct
+{
+    /** Time budget per main loop iteration, in microseconds, 0 to disable */
+    gint64 budget;
+    /** Amount of work per lua_gc() call, in kilobytes */
+    int step_size;
+    /** Pause and step multiplier the Lua VM started with, 0 until read */
+    int default_pause, default_stepmul;
+    /** Current pause and step multiplier of the automatic collector */
+    int pause, stepmul;
+    /** Number of lua_gc() steps done while idle */
+    unsigned int steps;
+    /** Number of collection cycles finished while idle */
+    unsigned int cycles;
+    /** Number of iterations which used up the whole budget */
+    unsigned int exhausted;
+    /** Total time spent collecting while idle, in microseconds */
+    gint64 time;
+    /** Is an idle collection cycle in progress? */
+    bool in_cycle;
+    /** Heap size when the last idle cycle finished, in kilobytes */
+    int heap_after_cycle;
+} gc = {
+    .budget = GC_DEFAULT_BUDGET,
+    .step_size = 16,
+};
+
+/** Read the tuning parameters the automatic collector started with.
+ * They depend on the Lua version (e.g. a step multiplier of 200 in Lua 5.1
+ * to 5.3 and 100 in Lua 5.4) and can only be read by setting them.
+ * \param L The Lua VM state.
+ */
+static void
+luaA_gc_read_defaults(lua_State *L)
+{
+    if(gc.default_pause > 0)
+        return;
+
+    gc.default_pause = lua_gc(L, LUA_GCSETPAUSE, 100);
+    lua_gc(L, LUA_GCSETPAUSE, gc.default_pause);
+    gc.default_stepmul = lua_gc(L, LUA_GCSETSTEPMUL, 100);
+    lua_gc(L, LUA_GCSETSTEPMUL, gc.default_stepmul);
+
+    gc.pause = gc.default_pause;
+    gc.stepmul = gc.default_stepmul;
+}
+
+/** Set the tuning parameters of the automatic collector. The pause is kept
+ * between the default and twice the default, the step multiplier between half
+ * the default and the default.
+ * \param L The Lua VM state.
+ * \param pause The new pause.
+ * \param stepmul The new step multiplier.
+ */
+static void
+luaA_gc_tune(lua_State *L, int pause, int stepmul)
+{
+    luaA_gc_read_defaults(L);
+    pause = MAX(gc.default_pause, MIN(pause, gc.default_pause * 2));
+    stepmul = MAX(gc.default_stepmul / 2, MIN(stepmul, gc.default_stepmul));
+    if(pause != gc.pause)
+        lua_gc(L, LUA_GCSETPAUSE, pause);
+    if(stepmul != gc.stepmul)
+        lua_gc(L, LUA_GCSETSTEPMUL, stepmul);
+    gc.pause = pause;
+    gc.stepmul = stepmul;
+}
+
+/** Step the garbage collector for at most the configured time budget.
+ * This is called before the main loop goes to sleep.
+ * \param L The Lua VM state.
+ * \return The time spent collecting, in microseconds.
+ */
+gint64
+luaA_gc_idle(lua_State *L)
+{
+    if(gc.budget <= 0)
+        return 0;
+
+    /* Do not start a new cycle before there is some new garbage */
+    int heap = lua_gc(L, LUA_GCCOUNT, 0);
+    if(!gc.in_cycle && heap < gc.heap_after_cycle + gc.heap_after_cycle / 10)
+        return 0;
+
+    gint64 start = g_get_monotonic_time();
+    gint64 now = start;
+    bool finished = false;
+
+    while(!finished && now - start < gc.budget)
+    {
+        gint64 step_start = now;
+        finished = lua_gc(L, LUA_GCSTEP, gc.step_size);
+        now = g_get_monotonic_time();
+        gc.steps++;
+
+        /* Keep single steps well below the budget, but big enough to not
+         * spend the budget in call overhead. */
+        if(now - step_start > gc.budget / 4)
+            gc.step_size = MAX(gc.step_size / 2, GC_STEP_MIN);
+        else if(now - step_start < gc.budget / 16)
+            gc.step_size = MIN(gc.step_size * 2, GC_STEP_MAX);
+    }
+
+    gc.time += now - start;
+
+    gc.in_cycle = !finished;
+
+    luaA_gc_read_defaults(L);
+    if(finished)
+    {
+        gc.cycles++;
+        gc.heap_after_cycle = lua_gc(L, LUA_GCCOUNT, 0);
+        /* Idle collection keeps up, let the automatic collector back off */
+        luaA_gc_tune(L, gc.pause + gc.default_pause / 20,
+                     gc.stepmul - gc.default_stepmul / 20);
+    }
+    else
+    {
+        gc.exhausted++;
+        /* Idle collection is behind, give some work back to the allocator */
+        luaA_gc_tune(L, gc.pause - gc.default_pause / 10,
+                     gc.stepmul + gc.default_stepmul / 10);
+    }
+
+    return now - start;
+}
+
+/** Push statistics about the garbage collection done while idle.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+luaA_gc_stats(lua_State *L)
+{
+    lua_Integer heap = (lua_Integer) lua_gc(L, LUA_GCCOUNT, 0) * 1024
+        + lua_gc(L, LUA_GCCOUNTB, 0);
+
+    luaA_gc_read_defaults(L);
+
+    lua_createtable(L, 0, 9);
+    lua_pushinteger(L, gc.cycles);
+    lua_setfield(L, -2, "cycles");
+    lua_pushinteger(L, gc.steps);
+    lua_setfield(L, -2, "steps");
+    lua_pushinteger(L, gc.time);
+    lua_setfield(L, -2, "time");
+    lua_pushinteger(L, gc.exhausted);
+    lua_setfield(L, -2, "exhausted");
+    lua_pushinteger(L, heap);
+    lua_setfield(L, -2, "heap");
+    lua_pushinteger(L, gc.budget);
+    lua_setfield(L, -2, "budget");
+    lua_pushinteger(L, gc.step_size);
+    lua_setfield(L, -2, "step_size");
+    lua_pushinteger(L, gc.pause);
+    lua_setfield(L, -2, "pause");
+    lua_pushinteger(L, gc.stepmul);
+    lua_setfield(L, -2, "stepmul");
+    return 1;
+}
+
+/** Get or set the idle garbage collection budget.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+luaA_gc_budget(lua_State *L)
+{
+    if(!lua_isnoneornil(L, 1))
+    {
+        gc.budget = luaA_checkinteger_range(L, 1, 0, G_USEC_PER_SEC);
+        /* Without idle collection, the automatic collector does it all */
+        if(gc.budget == 0)
+        {
+            luaA_gc_read_defaults(L);
+            luaA_gc_tune(L, gc.default_pause, gc.default_stepmul);
+        }
+    }
+
+    lua_pushinteger(L, gc.budget);
+    return 1;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
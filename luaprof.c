@@ -0,0 +1,360 @@
+/*
+ * luaprof.c - Lua sampling profiler
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* The profiler samples the Lua stack either every N VM instructions, with a
+ * count hook, or at a fixed rate of CPU time. In the latter case, a SIGPROF
+ * timer installs a count hook which fires on the next instruction, takes the
+ * sample and removes itself, so nothing runs between samples.
+ *
+ * Samples are aggregated into a table of collapsed stacks, the format used by
+ * flamegraph.pl and most flame graph viewers: one line per stack, with the
+ * frames from the outermost to the innermost separated by semicolons, followed
+ * by the number of samples.
+ *
+ * Only the main Lua thread is hooked. Time spent in C code called from Lua is
+ * attributed to the calling Lua function. A hook set before the profiler
+ * started (e.g. by a debugger) is put back when it stops, and between the
+ * samples taken with the timer.
+ */
+
+#include "luaprof.h"
+#include "globalconf.h"
+
+#include <lauxlib.h>
+
+#include <errno.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define PROFILER_DEFAULT_FREQUENCY 1000
+#define PROFILER_MAX_FREQUENCY 10000
+#define PROFILER_MAX_DEPTH 256
+
+static struct
+{
+    /** Is the profiler running? */
+    bool running;
+    /** Number of instructions between samples, 0 for the timer */
+    int instructions;
+    /** Collapsed stacks, mapped to their number of samples */
+    GHashTable *stacks;
+    /** Number of samples taken */
+    unsigned int samples;
+    /** Number of profiles written on SIGUSR2 */
+    unsigned int dumps;
+    /** The hook which was set before the profiler started */
+    lua_Hook saved_hook;
+    int saved_mask, saved_count;
+} profiler;
+
+/** Append a frame of the Lua stack to a collapsed stack.
+ * \param buf The collapsed stack.
+ * \param ar The frame.
+ */
+static void
+profiler_append_frame(GString *buf, lua_Debug *ar)
+{
+    gsize start = buf->len;
+
+    if(ar->what[0] == 'C')
+        g_string_append_printf(buf, "%s [C]", ar->name ? ar->name : "?");
+    else if(ar->what[0] == 'm')
+        g_string_append(buf, ar->short_src);
+    else
+        g_string_append_printf(buf, "%s (%s:%d)", ar->name ? ar->name : "?",
+                               ar->short_src, ar->linedefined);
+
+    /* Semicolons separate frames */
+    for(gsize i = start; i < buf->len; i++)
+        if(buf->str[i] == ';' || buf->str[i] == '\n')
+            buf->str[i] = ':';
+}
+
+/** Take a sample of the Lua stack.
+ * \param L The Lua VM state.
+ */
+static void
+profiler_sample(lua_State *L)
+{
+    lua_Debug frames[PROFILER_MAX_DEPTH];
+    int depth = 0;
+
+    while(depth < PROFILER_MAX_DEPTH && lua_getstack(L, depth, &frames[depth]))
+    {
+        lua_getinfo(L, "Sn", &frames[depth]);
+        depth++;
+    }
+
+    if(!depth)
+        return;
+
+    GString *buf = g_string_sized_new(256);
+    for(int i = depth - 1; i >= 0; i--)
+    {
+        profiler_append_frame(buf, &frames[i]);
+        if(i)
+            g_string_append_c(buf, ';');
+    }
+
+    char *stack = g_string_free(buf, FALSE);
+    gpointer count = g_hash_table_lookup(profiler.stacks, stack);
+    g_hash_table_replace(profiler.stacks, stack, GUINT_TO_POINTER(GPOINTER_TO_UINT(count) + 1));
+    profiler.samples++;
+}
+
+static void
+profiler_hook(lua_State *L, lua_Debug *ar)
+{
+    /* With the timer, the hook is only installed for one sample */
+    if(!profiler.instructions)
+        lua_sethook(L, profiler.saved_hook, profiler.saved_mask, profiler.saved_count);
+    if(profiler.running)
+        profiler_sample(L);
+}
+
+static void
+profiler_signal(int signum)
+{
+    /* lua_sethook() is safe to call from a signal handler */
+    lua_sethook(globalconf_get_lua_State(), profiler_hook, LUA_MASKCOUNT, 1);
+}
+
+/** Start sampling.
+ * \param frequency The number of samples per second of CPU time, when
+ * instructions is 0.
+ * \param instructions The number of Lua VM instructions between samples.
+ * \return True on success, false with errno set if the timer failed.
+ */
+static bool
+profiler_enable(int frequency, int instructions)
+{
+    lua_State *L = globalconf_get_lua_State();
+
+    profiler.saved_hook = lua_gethook(L);
+    profiler.saved_mask = lua_gethookmask(L);
+    profiler.saved_count = lua_gethookcount(L);
+
+    profiler.stacks = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    profiler.samples = 0;
+    profiler.instructions = instructions;
+    profiler.running = true;
+
+    if(instructions)
+    {
+        lua_sethook(L, profiler_hook, LUA_MASKCOUNT, instructions);
+        return true;
+    }
+
+    struct sigaction sa = { .sa_handler = profiler_signal, .sa_flags = SA_RESTART };
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGPROF, &sa, NULL);
+
+    long interval = G_USEC_PER_SEC / frequency;
+    struct itimerval timer = { { 0, 0 }, { 0, 0 } };
+    timer.it_interval.tv_sec = interval / G_USEC_PER_SEC;
+    timer.it_interval.tv_usec = interval % G_USEC_PER_SEC;
+    timer.it_value = timer.it_interval;
+    if(setitimer(ITIMER_PROF, &timer, NULL) == 0)
+        return true;
+
+    int saved_errno = errno;
+    signal(SIGPROF, SIG_IGN);
+    g_hash_table_unref(profiler.stacks);
+    profiler.stacks = NULL;
+    profiler.running = false;
+    errno = saved_errno;
+    return false;
+}
+
+/** Stop sampling.
+ * \return The collapsed stacks, to be freed with g_hash_table_unref().
+ */
+static GHashTable *
+profiler_disable(void)
+{
+    struct itimerval timer = { { 0, 0 }, { 0, 0 } };
+    GHashTable *stacks = profiler.stacks;
+
+    /* The timer outlives execve(), but not the handler */
+    if(!profiler.instructions)
+    {
+        setitimer(ITIMER_PROF, &timer, NULL);
+        signal(SIGPROF, SIG_IGN);
+    }
+    lua_sethook(globalconf_get_lua_State(), profiler.saved_hook,
+                profiler.saved_mask, profiler.saved_count);
+
+    profiler.running = false;
+    profiler.stacks = NULL;
+    return stacks;
+}
+
+/** Write collapsed stacks in the format of flamegraph.pl.
+ * \param stacks The collapsed stacks.
+ * \return The text, to be freed with g_string_free().
+ */
+static GString *
+profiler_format(GHashTable *stacks)
+{
+    GString *out = g_string_new(NULL);
+    GHashTableIter iter;
+    gpointer stack, count;
+
+    g_hash_table_iter_init(&iter, stacks);
+    while(g_hash_table_iter_next(&iter, &stack, &count))
+        g_string_append_printf(out, "%s %u\n", (char *) stack, GPOINTER_TO_UINT(count));
+
+    return out;
+}
+
+/** Start the Lua sampling profiler.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam An optional table with either the frequency of samples or the number
+ * of instructions between them.
+ */
+int
+luaA_profiler_start(lua_State *L)
+{
+    int frequency = PROFILER_DEFAULT_FREQUENCY;
+    int instructions = 0;
+
+    if(profiler.running)
+        return luaL_error(L, "The profiler is already running");
+
+    if(!lua_isnoneornil(L, 1))
+    {
+        luaL_checktype(L, 1, LUA_TTABLE);
+        lua_getfield(L, 1, "frequency");
+        if(!lua_isnil(L, -1))
+            frequency = luaL_checkinteger(L, -1);
+        lua_getfield(L, 1, "instructions");
+        if(!lua_isnil(L, -1))
+            instructions = luaL_checkinteger(L, -1);
+        lua_pop(L, 2);
+    }
+
+    if(frequency < 1 || frequency > PROFILER_MAX_FREQUENCY)
+        return luaL_error(L, "The frequency must be between 1 and %d", PROFILER_MAX_FREQUENCY);
+    if(instructions < 0)
+        return luaL_error(L, "The number of instructions cannot be negative");
+
+    if(!profiler_enable(frequency, instructions))
+        return luaL_error(L, "Cannot start the profiler timer: %s", g_strerror(errno));
+    return 0;
+}
+
+/** Stop the Lua sampling profiler.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam An optional path where to write the collapsed stacks.
+ * \lreturn The number of samples and, without a path, the collapsed stacks.
+ */
+int
+luaA_profiler_stop(lua_State *L)
+{
+    const char *path = luaL_optstring(L, 1, NULL);
+
+    if(!profiler.running)
+        return luaL_error(L, "The profiler is not running");
+
+    unsigned int samples = profiler.samples;
+    GHashTable *stacks = profiler_disable();
+    GString *out = profiler_format(stacks);
+    g_hash_table_unref(stacks);
+
+    GError *error = NULL;
+    if(path && !g_file_set_contents(path, out->str, out->len, &error))
+    {
+        g_string_free(out, TRUE);
+        lua_pushfstring(L, "Cannot write the profile: %s", error->message);
+        g_error_free(error);
+        return lua_error(L);
+    }
+
+    lua_pushinteger(L, samples);
+    if(path)
+    {
+        g_string_free(out, TRUE);
+        return 1;
+    }
+    lua_pushlstring(L, out->str, out->len);
+    g_string_free(out, TRUE);
+    return 2;
+}
+
+/** Start the profiler, or stop it and write the profile to the cache
+ * directory. This is the handler of SIGUSR2.
+ * \param data Unused.
+ * \return G_SOURCE_CONTINUE.
+ */
+gboolean
+luaA_profiler_toggle(gpointer data)
+{
+    if(!profiler.running)
+    {
+        if(profiler_enable(PROFILER_DEFAULT_FREQUENCY, 0))
+            warn("Lua profiler started, send SIGUSR2 again to stop it");
+        else
+            warn("Cannot start the Lua profiler timer: %s", g_strerror(errno));
+        return G_SOURCE_CONTINUE;
+    }
+
+    unsigned int samples = profiler.samples;
+    GHashTable *stacks = profiler_disable();
+    GString *out = profiler_format(stacks);
+    g_hash_table_unref(stacks);
+
+    char *dir = g_build_filename(g_get_user_cache_dir(), "awesome", NULL);
+    char *name = g_strdup_printf("profile-%d-%u.folded", (int) getpid(), ++profiler.dumps);
+    char *path = g_build_filename(dir, name, NULL);
+    GError *error = NULL;
+
+    if(g_mkdir_with_parents(dir, 0700) == 0
+       && g_file_set_contents(path, out->str, out->len, &error))
+        warn("Lua profile with %u samples written to %s", samples, path);
+    else
+        warn("Cannot write the Lua profile to %s: %s", path,
+             error ? error->message : g_strerror(errno));
+
+    if(error)
+        g_error_free(error);
+    g_free(path);
+    g_free(name);
+    g_free(dir);
+    g_string_free(out, TRUE);
+    return G_SOURCE_CONTINUE;
+}
+
+/** Stop the profiler without writing anything. This must be called before
+ * closing the Lua VM state.
+ */
+void
+luaA_profiler_shutdown(void)
+{
+    if(profiler.running)
+        g_hash_table_unref(profiler_disable());
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
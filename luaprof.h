@@ -0,0 +1,34 @@
+/*
+ * luaprof.h - Lua sampling profiler header
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_LUAPROF_H
+#define AWESOME_LUAPROF_H
+
+#include <glib.h>
+#include <lua.h>
+
+int luaA_profiler_start(lua_State *);
+int luaA_profiler_stop(lua_State *);
+gboolean luaA_profiler_toggle(gpointer);
+void luaA_profiler_shutdown(void);
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
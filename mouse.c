@@ -66,6 +66,7 @@
 #include "common/xutil.h"
 #include "common/luaclass.h"
 #include "globalconf.h"
+#include "spatial.h"
 #include "objects/client.h"
 #include "objects/drawin.h"
 #include "objects/screen.h"
@@ -299,7 +300,14 @@ luaA_mouse_object_under_pointer(lua_State *L)
     if((drawin = drawin_getbywin(child)))
         return luaA_object_push(L, drawin);
 
-    if((client = client_getbyframewin(child)))
+    /* The pointer is almost always over the topmost client at its position,
+     * so ask the spatial index first and only scan all clients if the frame
+     * window does not match (e.g. during a stacking change). */
+    client = spatial_client_at(mouse_x, mouse_y);
+    if(!client || client->frame_window != child)
+        client = client_getbyframewin(child);
+
+    if(client)
         return luaA_object_push(L, client);
 
     return 0;
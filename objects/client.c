@@ -2024,7 +2024,9 @@ client_geometry_refresh(void)
 void
 client_refresh(void)
 {
+    xrequest_phase_t phase = xrequest_phase_set(XREQUEST_PHASE_CLIENT_GEOMETRY);
     client_geometry_refresh();
+    xrequest_phase_set(phase);
     client_border_refresh();
     client_focus_refresh();
 }
@@ -2061,6 +2063,7 @@ border_width_callback(client_t *c, uint16_t old_width, uint16_t new_width)
         /* inform client about changes */
         client_resize_do(c, geometry);
     }
+    spatial_client_update(c);
 }
 
 static void
@@ -2211,6 +2214,7 @@ client_manage(xcb_window_t w, xcb_get_geometry_reply_t *wgeom, xcb_get_window_at
     c->geometry.y = wgeom->y;
     c->geometry.width = wgeom->width;
     c->geometry.height = wgeom->height;
+    spatial_client_update(c);
 
     luaA_object_emit_signal(L, -1, "property::x", 0);
     luaA_object_emit_signal(L, -1, "property::y", 0);
@@ -2465,6 +2469,7 @@ client_resize_do(client_t *c, area_t geometry)
     /* Also store geometry including border */
     area_t old_geometry = c->geometry;
     c->geometry = geometry;
+    spatial_client_update(c);
 
     luaA_object_push(L, c);
     if (!AREA_EQUAL(old_geometry, geometry))
@@ -2936,6 +2941,7 @@ client_unmanage(client_t *c, client_unmanage_t reason)
         client_unfocus(c);
 
     /* remove client from global list and everywhere else */
+    spatial_client_remove(c);
     foreach(elem, globalconf.clients)
         if(*elem == c)
         {
@@ -2974,6 +2980,7 @@ client_unmanage(client_t *c, client_unmanage_t reason)
 
     luaA_class_emit_signal(L, &client_class, "list", 0);
 
+    screen_client_strut_remove(c);
     if(strut_has_value(&c->strut))
         screen_update_workarea(c->screen);
 
@@ -3116,6 +3123,72 @@ luaA_client_get(lua_State *L)
     return 1;
 }
 
+/** Get the topmost visible client at a position.
+ *
+ * The lookup uses a spatial index of the client geometries, so it does not
+ * have to go through every client. The client border is part of the client.
+ *
+ * @tparam integer x The X coordinate.
+ * @tparam integer y The Y coordinate.
+ * @treturn client|nil The topmost visible client at this position, if any.
+ * @staticfct at
+ * @see intersecting
+ * @see mouse.object_under_pointer
+ */
+static int
+luaA_client_at(lua_State *L)
+{
+    int x = round(luaA_checknumber_range(L, 1, MIN_X11_COORDINATE, MAX_X11_COORDINATE));
+    int y = round(luaA_checknumber_range(L, 2, MIN_X11_COORDINATE, MAX_X11_COORDINATE));
+    client_t *c = spatial_client_at(x, y);
+
+    if(c)
+        luaA_object_push(L, c);
+    else
+        lua_pushnil(L);
+
+    return 1;
+}
+
+/** Get all visible clients intersecting a geometry.
+ *
+ * The lookup uses a spatial index of the client geometries, so it does not
+ * have to go through every client. The client border is part of the client.
+ *
+ * @tparam table geometry The geometry, with `x`, `y`, `width` and `height`
+ *   keys.
+ * @treturn table The visible clients overlapping the geometry, ordered from
+ *   top to bottom.
+ * @staticfct intersecting
+ * @see at
+ */
+static int
+luaA_client_intersecting(lua_State *L)
+{
+    area_t geometry;
+    client_array_t clients;
+
+    luaA_checktable(L, 1);
+    geometry.x = round(luaA_getopt_number_range(L, 1, "x", 0, MIN_X11_COORDINATE, MAX_X11_COORDINATE));
+    geometry.y = round(luaA_getopt_number_range(L, 1, "y", 0, MIN_X11_COORDINATE, MAX_X11_COORDINATE));
+    geometry.width = ceil(luaA_getopt_number_range(L, 1, "width", MIN_X11_SIZE, MIN_X11_SIZE, MAX_X11_SIZE));
+    geometry.height = ceil(luaA_getopt_number_range(L, 1, "height", MIN_X11_SIZE, MIN_X11_SIZE, MAX_X11_SIZE));
+
+    client_array_init(&clients);
+    spatial_clients_intersecting(geometry, &clients);
+
+    lua_createtable(L, clients.len, 0);
+    for(int i = 0; i < clients.len; i++)
+    {
+        luaA_object_push(L, clients.tab[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+
+    client_array_wipe(&clients);
+
+    return 1;
+}
+
 /** Check if a client is visible on its screen.
  *
  * @treturn boolean A boolean value, true if the client is visible, false otherwise.
@@ -4488,6 +4561,8 @@ client_class_setup(lua_State *L)
     {
         LUA_CLASS_METHODS(client)
         { "get", luaA_client_get },
+        { "at", luaA_client_at },
+        { "intersecting", luaA_client_intersecting },
         { "__index", luaA_client_module_index },
         { "__newindex", luaA_client_module_newindex },
         { NULL, NULL }
@@ -23,6 +23,7 @@
 #define AWESOME_OBJECTS_CLIENT_H
 
 #include "stack.h"
+#include "spatial.h"
 #include "objects/window.h"
 
 #define CLIENT_SELECT_INPUT_EVENT_MASK (XCB_EVENT_MASK_STRUCTURE_NOTIFY \
@@ -195,6 +196,10 @@ struct client_t
     } titlebar[CLIENT_TITLEBAR_COUNT];
     /** Motif WM hints, with an additional MWM_HINTS_AWESOME_SET bit */
     motif_wm_hints_t motif_wm_hints;
+    /** Position in the stacking order last sent to X, higher is above */
+    uint32_t stack_position;
+    /** Cells of the spatial index containing this client */
+    spatial_cells_t spatial;
 };
 
 ARRAY_FUNCS(client_t *, client, DO_NOTHING)
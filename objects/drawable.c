@@ -30,6 +30,7 @@
 #include "drawable.h"
 #include "common/luaobject.h"
 #include "globalconf.h"
+#include "startup.h"
 
 #include <cairo-xcb.h>
 
@@ -104,6 +105,50 @@ static lua_class_t drawable_class;
 
 LUA_OBJECT_FUNCS(drawable_class, drawable_t, drawable)
 
+/** A recording surface together with what is known about its sources. It is
+ * attached as user data to the observer surface that Lua draws to.
+ */
+typedef struct
+{
+    /** The recorded drawing operations */
+    cairo_surface_t *recording;
+    /** The context which draws to the observer, or NULL */
+    cairo_t *cr;
+    /** Whether something else than an image surface was used as a source */
+    bool foreign_source;
+} drawable_recording_t;
+
+static const cairo_user_data_key_t recording_key;
+
+/** Recorded drawing operations which are rasterised on the worker thread */
+struct drawable_replay_t
+{
+    /** The drawable, referenced until the replay is done */
+    drawable_t *drawable;
+    /** The generation of the drawable when the drawing was recorded */
+    unsigned int generation;
+    /** The recorded drawing operations */
+    cairo_surface_t *recording;
+    /** Whether the recording has to be replayed on the main thread */
+    bool main_thread;
+    /** Set when a later replay of the drawable covers this one. Only read by
+     * the worker thread before it rasterises the recording.
+     */
+    gint superseded;
+    /** The part of the drawable that was drawn */
+    cairo_region_t *region;
+    /** Whether to paint the drawing over the background */
+    bool opaque;
+    /** The background for opaque drawings, or NULL for black */
+    cairo_surface_t *background;
+    /** The rasterised drawing, created by the worker thread */
+    cairo_surface_t *image;
+};
+typedef struct drawable_replay_t drawable_replay_t;
+
+/** The queue of drawable_replay_t for the worker thread */
+static GAsyncQueue *replay_queue;
+
 drawable_t *
 drawable_allocator(lua_State *L, drawable_refresh_callback *callback, void *data)
 {
@@ -126,6 +171,7 @@ drawable_unset_surface(drawable_t *d)
     d->refreshed = false;
     d->surface = NULL;
     d->pixmap = XCB_NONE;
+    d->generation++;
 }
 
 static void
@@ -183,6 +229,17 @@ luaA_drawable_get_surface(lua_State *L, drawable_t *drawable)
     return 1;
 }
 
+static void
+drawable_refresh(drawable_t *drawable)
+{
+    if(!drawable->refreshed)
+        startup_profile_mark("first paint %dx%d+%d+%d",
+                             drawable->geometry.width, drawable->geometry.height,
+                             drawable->geometry.x, drawable->geometry.y);
+    drawable->refreshed = true;
+    (*drawable->refresh_callback)(drawable->refresh_data);
+}
+
 /** Refresh a drawable's content. This has to be called whenever some drawing to
  * the drawable's surface has been done and should become visible.
  *
@@ -193,8 +250,310 @@ static int
 luaA_drawable_refresh(lua_State *L)
 {
     drawable_t *drawable = luaA_checkudata(L, 1, &drawable_class);
-    drawable->refreshed = true;
-    (*drawable->refresh_callback)(drawable->refresh_data);
+
+    /* Replays which are still pending would overwrite this drawing */
+    if(drawable->pending_replays > 0)
+        drawable->generation++;
+
+    drawable_refresh(drawable);
+
+    return 0;
+}
+
+/** Paint a rasterised drawing to its drawable. This runs on the main thread. */
+static gboolean
+drawable_replay_finish(gpointer data)
+{
+    lua_State *L = globalconf_get_lua_State();
+    drawable_replay_t *job = data;
+    drawable_t *d = job->drawable;
+
+    d->pending_replays--;
+    if(d->last_replay == job)
+        d->last_replay = NULL;
+
+    /* Drop the drawing if the surface changed in the meantime or if a later
+     * drawing replaces it completely.
+     */
+    if(d->surface && d->generation == job->generation
+            && (job->image || (job->main_thread && !g_atomic_int_get(&job->superseded))))
+    {
+        cairo_t *cr = cairo_create(d->surface);
+
+        for(int i = 0; i < cairo_region_num_rectangles(job->region); i++)
+        {
+            cairo_rectangle_int_t rect;
+            cairo_region_get_rectangle(job->region, i, &rect);
+            cairo_rectangle(cr, rect.x, rect.y, rect.width, rect.height);
+        }
+        cairo_clip(cr);
+
+        cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+        if(job->opaque)
+        {
+            if(job->background)
+                cairo_set_source_surface(cr, job->background, 0, 0);
+            else
+                cairo_set_source_rgb(cr, 0, 0, 0);
+            cairo_paint(cr);
+            cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+        }
+        /* Recordings with X11 sources are only rasterised here */
+        cairo_set_source_surface(cr, job->image ? job->image : job->recording, 0, 0);
+        cairo_paint(cr);
+        cairo_destroy(cr);
+        cairo_surface_flush(d->surface);
+
+        drawable_refresh(d);
+    }
+
+    cairo_surface_destroy(job->image);
+    cairo_surface_destroy(job->recording);
+    cairo_surface_destroy(job->background);
+    cairo_region_destroy(job->region);
+    luaA_object_unref(L, d);
+    p_delete(&job);
+
+    return G_SOURCE_REMOVE;
+}
+
+/** The worker thread. It rasterises the recorded drawings into image surfaces
+ * in the order in which they were made.
+ */
+static gpointer
+drawable_replay_worker(gpointer data)
+{
+    GAsyncQueue *queue = data;
+
+    while(true)
+    {
+        drawable_replay_t *job = g_async_queue_pop(queue);
+        cairo_rectangle_int_t extents;
+        cairo_t *cr;
+
+        if(job->main_thread || g_atomic_int_get(&job->superseded))
+        {
+            g_idle_add_full(G_PRIORITY_DEFAULT, drawable_replay_finish, job, NULL);
+            continue;
+        }
+
+        cairo_region_get_extents(job->region, &extents);
+        job->image = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+                                                extents.width, extents.height);
+        cairo_surface_set_device_offset(job->image, -extents.x, -extents.y);
+
+        cr = cairo_create(job->image);
+        cairo_set_source_surface(cr, job->recording, 0, 0);
+        cairo_paint(cr);
+        cairo_destroy(cr);
+        cairo_surface_flush(job->image);
+
+        g_idle_add_full(G_PRIORITY_DEFAULT, drawable_replay_finish, job, NULL);
+    }
+
+    return NULL;
+}
+
+/** Called by the observer after each drawing operation. Only image surfaces
+ * can be read from another thread, so anything else means that the recording
+ * has to be replayed on the main thread.
+ */
+static void
+drawable_recording_check_source(cairo_surface_t *observer, cairo_surface_t *target, void *data)
+{
+    drawable_recording_t *rec = data;
+    cairo_surface_t *source;
+
+    if(!rec->cr || rec->foreign_source)
+        return;
+
+    if(cairo_pattern_get_surface(cairo_get_source(rec->cr), &source) == CAIRO_STATUS_SUCCESS
+            && cairo_surface_get_type(source) != CAIRO_SURFACE_TYPE_IMAGE)
+        rec->foreign_source = true;
+}
+
+/** Called by the observer after each mask operation. Cairo does not tell which
+ * mask was used, so it could be an X11 surface. To be safe, such recordings are
+ * always replayed on the main thread.
+ */
+static void
+drawable_recording_mask(cairo_surface_t *observer, cairo_surface_t *target, void *data)
+{
+    drawable_recording_t *rec = data;
+    rec->foreign_source = true;
+}
+
+static void
+drawable_recording_destroy(void *data)
+{
+    drawable_recording_t *rec = data;
+    cairo_surface_destroy(rec->recording);
+    p_delete(&rec);
+}
+
+static drawable_recording_t *
+drawable_recording_get(cairo_surface_t *observer)
+{
+    if(!observer || cairo_surface_get_type(observer) != CAIRO_SURFACE_TYPE_OBSERVER)
+        return NULL;
+    return cairo_surface_get_user_data(observer, &recording_key);
+}
+
+/** Create a surface which records drawing operations for `_replay`.
+ *
+ * The surface has to be passed to `_record_context` together with the context
+ * that draws to it.
+ *
+ * @tparam integer width The width of the drawing.
+ * @tparam integer height The height of the drawing.
+ * @treturn lightuserdata A cairo surface.
+ * @method _record
+ * @see _replay
+ */
+static int
+luaA_drawable_record(lua_State *L)
+{
+    cairo_rectangle_t extents = {
+        .x = 0,
+        .y = 0,
+        .width = luaL_checknumber(L, 2),
+        .height = luaL_checknumber(L, 3),
+    };
+    drawable_recording_t *rec;
+    cairo_surface_t *observer;
+
+    luaA_checkudata(L, 1, &drawable_class);
+    rec = p_new(drawable_recording_t, 1);
+    rec->recording = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, &extents);
+    observer = cairo_surface_create_observer(rec->recording, CAIRO_SURFACE_OBSERVER_NORMAL);
+    cairo_surface_set_user_data(observer, &recording_key, rec, drawable_recording_destroy);
+    cairo_surface_observer_add_paint_callback(observer, drawable_recording_check_source, rec);
+    cairo_surface_observer_add_mask_callback(observer, drawable_recording_mask, rec);
+    cairo_surface_observer_add_fill_callback(observer, drawable_recording_check_source, rec);
+    cairo_surface_observer_add_stroke_callback(observer, drawable_recording_check_source, rec);
+    cairo_surface_observer_add_glyphs_callback(observer, drawable_recording_check_source, rec);
+
+    /* Lua gets its own reference which it will have to destroy */
+    lua_pushlightuserdata(L, observer);
+    return 1;
+}
+
+/** Set the context that draws to a surface created by `_record`. Its sources
+ * are checked after each drawing operation.
+ *
+ * @tparam lightuserdata recording The surface created by `_record`.
+ * @tparam lightuserdata cr The cairo context drawing to it.
+ * @method _record_context
+ * @noreturn
+ * @see _record
+ */
+static int
+luaA_drawable_record_context(lua_State *L)
+{
+    drawable_recording_t *rec = drawable_recording_get(lua_touserdata(L, 2));
+    cairo_t *cr = lua_touserdata(L, 3);
+
+    luaA_checkudata(L, 1, &drawable_class);
+    if(!rec)
+        return luaL_argerror(L, 2, "expected a surface created by _record");
+    if(!cr || cairo_get_target(cr) != lua_touserdata(L, 2))
+        return luaL_argerror(L, 3, "expected a cairo context drawing to the recording");
+
+    rec->cr = cr;
+    return 0;
+}
+
+/** Rasterise recorded drawing operations on another thread and show the
+ * result once this is done.
+ *
+ * This is used instead of `refresh` when the drawing was done to a surface
+ * created by `_record` instead of the drawable's surface. If the drawing used
+ * another surface than an image as a source or used a mask, the recording is
+ * rasterised on the main thread instead, but still in order with the other
+ * replays.
+ *
+ * A replay that is still waiting for the worker thread is dropped when a later
+ * replay of the same drawable covers its area.
+ *
+ * @tparam lightuserdata recording The surface created by `_record`.
+ * @tparam table rectangles The area that was drawn, as a list of x, y, width
+ *  and height values for each rectangle.
+ * @tparam boolean opaque Whether the drawing is painted over a background or
+ *  replaces the content of the drawable.
+ * @tparam[opt] lightuserdata background The cairo surface to paint below the
+ *  drawing if it is opaque. Black is used by default.
+ * @method _replay
+ * @noreturn
+ * @see refresh
+ */
+static int
+luaA_drawable_replay(lua_State *L)
+{
+    drawable_t *drawable = luaA_checkudata(L, 1, &drawable_class);
+    drawable_recording_t *rec = drawable_recording_get(lua_touserdata(L, 2));
+    drawable_replay_t *job;
+    cairo_region_t *region;
+    size_t len;
+
+    if(!rec)
+        return luaL_argerror(L, 2, "expected a surface created by _record");
+
+    /* The context is done drawing */
+    rec->cr = NULL;
+
+    luaA_checktable(L, 3);
+    len = luaA_rawlen(L, 3);
+    region = cairo_region_create();
+    for(size_t i = 1; i + 3 <= len; i += 4)
+    {
+        cairo_rectangle_int_t rect;
+        lua_rawgeti(L, 3, i);
+        lua_rawgeti(L, 3, i + 1);
+        lua_rawgeti(L, 3, i + 2);
+        lua_rawgeti(L, 3, i + 3);
+        rect.x = lua_tointeger(L, -4);
+        rect.y = lua_tointeger(L, -3);
+        rect.width = lua_tointeger(L, -2);
+        rect.height = lua_tointeger(L, -1);
+        lua_pop(L, 4);
+        cairo_region_union_rectangle(region, &rect);
+    }
+
+    if(cairo_region_is_empty(region))
+    {
+        cairo_region_destroy(region);
+        return 0;
+    }
+
+    job = p_new(drawable_replay_t, 1);
+    job->recording = cairo_surface_reference(rec->recording);
+    job->main_thread = rec->foreign_source;
+    job->region = region;
+    job->opaque = lua_toboolean(L, 4);
+    if(lua_islightuserdata(L, 5))
+        job->background = cairo_surface_reference(lua_touserdata(L, 5));
+    job->generation = drawable->generation;
+    lua_pushvalue(L, 1);
+    job->drawable = luaA_object_ref(L, -1);
+    drawable->pending_replays++;
+
+    /* A previous replay that is completely painted over is not needed anymore */
+    if(drawable->last_replay && drawable->last_replay->generation == job->generation)
+    {
+        cairo_region_t *uncovered = cairo_region_copy(drawable->last_replay->region);
+        cairo_region_subtract(uncovered, region);
+        if(cairo_region_is_empty(uncovered))
+            g_atomic_int_set(&drawable->last_replay->superseded, TRUE);
+        cairo_region_destroy(uncovered);
+    }
+    drawable->last_replay = job;
+
+    if(!replay_queue)
+    {
+        replay_queue = g_async_queue_new();
+        g_thread_unref(g_thread_new("drawable", drawable_replay_worker, replay_queue));
+    }
+    g_async_queue_push(replay_queue, job);
 
     return 0;
 }
@@ -225,6 +584,9 @@ drawable_class_setup(lua_State *L)
         LUA_OBJECT_META(drawable)
         LUA_CLASS_META
         { "refresh", luaA_drawable_refresh },
+        { "_record", luaA_drawable_record },
+        { "_record_context", luaA_drawable_record_context },
+        { "_replay", luaA_drawable_replay },
         { "geometry", luaA_drawable_geometry },
         { NULL, NULL },
     };
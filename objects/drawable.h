@@ -44,6 +44,12 @@ struct drawable_t
     drawable_refresh_callback *refresh_callback;
     /** Data for refresh callback. */
     void *refresh_data;
+    /** Incremented when the surface changes, to drop pending replays. */
+    unsigned int generation;
+    /** Number of replays still being rasterised. */
+    int pending_replays;
+    /** The replay that was queued last, until it is done. */
+    struct drawable_replay_t *last_replay;
 };
 typedef struct drawable_t drawable_t;
 
@@ -188,6 +188,7 @@ drawin_wipe(drawin_t *w)
     }
     /* No unref needed because we are being garbage collected */
     w->drawable = NULL;
+    screen_drawin_strut_remove(w);
 }
 
 static void
@@ -48,8 +48,10 @@
 #include "banning.h"
 #include "objects/client.h"
 #include "objects/drawin.h"
+#include "common/xutil.h"
 #include "event.h"
 
+#include <math.h>
 #include <stdio.h>
 
 #include <xcb/xcb.h>
@@ -959,6 +961,7 @@ screen_added(lua_State *L, screen_t *screen)
 {
     screen->workarea = screen->geometry;
     screen->valid = true;
+    spatial_screen_update(screen);
     luaA_object_push(L, screen);
     luaA_object_emit_signal(L, -1, "_added", 0);
     lua_pop(L, 1);
@@ -1031,6 +1034,8 @@ screen_removed(lua_State *L, int sidx)
 {
     screen_t *screen = luaA_checkudata(L, sidx, &screen_class);
 
+    spatial_screen_remove(screen);
+
     luaA_object_emit_signal(L, sidx, "removed", 0);
 
     if (globalconf.primary_screen == screen)
@@ -1046,7 +1051,7 @@ screen_removed(lua_State *L, int sidx)
 void screen_cleanup(void)
 {
     while(globalconf.screens.len)
-        screen_array_take(&globalconf.screens, 0);
+        spatial_screen_remove(screen_array_take(&globalconf.screens, 0));
 
     monitor_unmark();
     viewport_purge();
@@ -1060,6 +1065,7 @@ screen_modified(screen_t *existing_screen, screen_t *other_screen)
     if(!AREA_EQUAL(existing_screen->geometry, other_screen->geometry)) {
         area_t old_geometry = existing_screen->geometry;
         existing_screen->geometry = other_screen->geometry;
+        spatial_screen_update(existing_screen);
         luaA_object_push(L, existing_screen);
         luaA_pusharea(L, old_geometry);
         luaA_object_emit_signal(L, -2, "property::geometry", 1);
@@ -1237,8 +1243,13 @@ screen_get_distance_squared(screen_t *s, int x, int y)
 screen_t *
 screen_getbycoord(int x, int y)
 {
+    screen_t *screen = spatial_screen_at(x, y);
+    if(screen)
+        return screen;
+
+    /* Screens which were not added yet are not in the spatial index */
     foreach(s, globalconf.screens)
-        if(screen_coord_in_screen(*s, x, y))
+        if(!(*s)->spatial.indexed && screen_coord_in_screen(*s, x, y))
             return *s;
 
     /* No screen found, find nearest screen. */
@@ -1283,11 +1294,93 @@ screen_area_in_screen(screen_t *s, area_t geom)
             && (geom.y + geom.height > s->geometry.y);
 }
 
+/** Clients and drawins with struts. Only those can shrink a workarea, so
+ * recomputing one does not need to look at every window.
+ */
+static client_array_t strut_clients;
+static drawin_array_t strut_drawins;
+
+/** Workarea computation counters */
+static struct
+{
+    /** Number of workarea computations */
+    unsigned int updates;
+    /** Number of strut windows looked at by these computations */
+    unsigned int visited;
+    /** Number of computations which changed the workarea */
+    unsigned int changes;
+} workarea_stats;
+
+/** Add or remove a client from the strut windows after its struts changed.
+ * \param c The client.
+ */
+void
+screen_client_strut_changed(client_t *c)
+{
+    foreach(elem, strut_clients)
+        if(*elem == c)
+        {
+            if(!strut_has_value(&c->strut))
+                client_array_remove(&strut_clients, elem);
+            return;
+        }
+    if(strut_has_value(&c->strut))
+        client_array_append(&strut_clients, c);
+}
+
+/** Forget about the struts of a client which is going away.
+ * \param c The client.
+ */
+void
+screen_client_strut_remove(client_t *c)
+{
+    foreach(elem, strut_clients)
+        if(*elem == c)
+        {
+            client_array_remove(&strut_clients, elem);
+            return;
+        }
+}
+
+/** Add or remove a drawin from the strut windows after its struts changed.
+ * \param w The drawin.
+ */
+void
+screen_drawin_strut_changed(drawin_t *w)
+{
+    foreach(elem, strut_drawins)
+        if(*elem == w)
+        {
+            if(!strut_has_value(&w->strut))
+                drawin_array_remove(&strut_drawins, elem);
+            return;
+        }
+    if(strut_has_value(&w->strut))
+        drawin_array_append(&strut_drawins, w);
+}
+
+/** Forget about the struts of a drawin which is going away.
+ * \param w The drawin.
+ */
+void
+screen_drawin_strut_remove(drawin_t *w)
+{
+    foreach(elem, strut_drawins)
+        if(*elem == w)
+        {
+            drawin_array_remove(&strut_drawins, elem);
+            return;
+        }
+}
+
 void screen_update_workarea(screen_t *screen)
 {
     area_t area = screen->geometry;
     uint16_t top = 0, bottom = 0, left = 0, right = 0;
 
+    workarea_stats.updates++;
+    workarea_stats.visited += strut_clients.len + strut_drawins.len;
+
 #define COMPUTE_STRUT(o) \
     { \
         if((o)->strut.top_start_x || (o)->strut.top_end_x || (o)->strut.top) \
@@ -1320,11 +1413,11 @@ void screen_update_workarea(screen_t *screen)
         } \
     }
 
-    foreach(c, globalconf.clients)
+    foreach(c, strut_clients)
         if((*c)->screen == screen && client_isvisible(*c))
             COMPUTE_STRUT(*c)
 
-    foreach(drawin, globalconf.drawins)
+    foreach(drawin, strut_drawins)
         if((*drawin)->visible)
         {
             screen_t *d_screen =
@@ -1343,6 +1436,8 @@ void screen_update_workarea(screen_t *screen)
     if (AREA_EQUAL(area, screen->workarea))
         return;
 
+    workarea_stats.changes++;
+
     area_t old_workarea = screen->workarea;
     screen->workarea = area;
     lua_State *L = globalconf_get_lua_State();
@@ -1374,6 +1469,14 @@ screen_client_moveto(client_t *c, screen_t *new_screen, bool doresize)
 
     c->screen = new_screen;
 
+    if(strut_has_value(&c->strut))
+    {
+        if(old_screen)
+            screen_update_workarea(old_screen);
+        if(new_screen)
+            screen_update_workarea(new_screen);
+    }
+
     if(!doresize)
     {
         luaA_object_push(L, c);
@@ -1664,6 +1767,63 @@ luaA_screen_count(lua_State *L)
     return 1;
 }
 
+/** Get the screen containing a position.
+ *
+ * Unlike `awful.screen.getbycoord`, this does not fall back to the closest
+ * screen. The lookup uses a spatial index of the screen geometries. When
+ * screens overlap, the one with the lowest index is returned.
+ *
+ * @tparam integer x The X coordinate.
+ * @tparam integer y The Y coordinate.
+ * @treturn screen|nil The screen containing this position, if any.
+ * @staticfct at
+ * @see geometry
+ */
+static int
+luaA_screen_at(lua_State *L)
+{
+    int x = round(luaA_checknumber_range(L, 1, MIN_X11_COORDINATE, MAX_X11_COORDINATE));
+    int y = round(luaA_checknumber_range(L, 2, MIN_X11_COORDINATE, MAX_X11_COORDINATE));
+    screen_t *screen = spatial_screen_at(x, y);
+
+    if(screen)
+        luaA_object_push(L, screen);
+    else
+        lua_pushnil(L);
+
+    return 1;
+}
+
+/** Get statistics about the workarea computations.
+ *
+ * A workarea is computed again each time a window with struts changes, but
+ * `property::workarea` is only emitted when the result is different. Only the
+ * windows which have struts are looked at.
+ *
+ * @treturn table A table with the `updates` count of computations, the
+ *  `changes` count of computations which changed a workarea, the `visited`
+ *  count of windows looked at, and the current `clients` and `drawins`
+ *  counts of windows with struts.
+ * @staticfct workarea_stats
+ * @see workarea
+ */
+static int
+luaA_screen_workarea_stats(lua_State *L)
+{
+    lua_createtable(L, 0, 5);
+    lua_pushinteger(L, workarea_stats.updates);
+    lua_setfield(L, -2, "updates");
+    lua_pushinteger(L, workarea_stats.changes);
+    lua_setfield(L, -2, "changes");
+    lua_pushinteger(L, workarea_stats.visited);
+    lua_setfield(L, -2, "visited");
+    lua_pushinteger(L, strut_clients.len);
+    lua_setfield(L, -2, "clients");
+    lua_pushinteger(L, strut_drawins.len);
+    lua_setfield(L, -2, "drawins");
+    return 1;
+}
+
 /** Add a fake screen.
  *
  * To vertically split the first screen in 2 equal parts, use:
@@ -1786,6 +1946,7 @@ luaA_screen_fake_resize(lua_State *L)
     screen->geometry.y = y;
     screen->geometry.width = width;
     screen->geometry.height = height;
+    spatial_screen_update(screen);
 
     screen_update_workarea(screen);
 
@@ -1855,6 +2016,8 @@ screen_class_setup(lua_State *L)
     {
         LUA_CLASS_METHODS(screen)
         { "count", luaA_screen_count },
+        { "at", luaA_screen_at },
+        { "workarea_stats", luaA_screen_workarea_stats },
         { "_viewports", luaA_viewports },
         { "_scan_quiet", luaA_scan_quiet },
         { "__index", luaA_screen_module_index },
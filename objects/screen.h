@@ -24,6 +24,7 @@
 
 #include "globalconf.h"
 #include "draw.h"
+#include "spatial.h"
 #include "common/array.h"
 #include "common/luaclass.h"
 
@@ -53,6 +54,8 @@ struct a_screen
     struct viewport_t *viewport;
     /** Some XID identifying this screen */
     uint32_t xid;
+    /** Cells of the spatial index containing this screen */
+    spatial_cells_t spatial;
 };
 ARRAY_FUNCS(screen_t *, screen, DO_NOTHING)
 
@@ -65,6 +68,10 @@ int screen_get_index(screen_t *);
 void screen_client_moveto(client_t *, screen_t *, bool);
 void screen_update_primary(void);
 void screen_update_workarea(screen_t *);
+void screen_client_strut_changed(client_t *);
+void screen_client_strut_remove(client_t *);
+void screen_drawin_strut_changed(drawin_t *);
+void screen_drawin_strut_remove(drawin_t *);
 screen_t *screen_get_primary(void);
 void screen_schedule_refresh(void);
 void screen_emit_scanned(void);
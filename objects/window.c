@@ -55,6 +55,8 @@
 #include "common/atoms.h"
 #include "common/xutil.h"
 #include "ewmh.h"
+#include "objects/client.h"
+#include "objects/drawin.h"
 #include "objects/screen.h"
 #include "property.h"
 #include "xwindow.h"
@@ -109,9 +111,23 @@ luaA_window_struts(lua_State *L)
         luaA_tostrut(L, 2, &window->strut);
         ewmh_update_strut(window->window, &window->strut);
         luaA_object_emit_signal(L, 1, "property::struts", 0);
-        /* We don't know the correct screen, update them all */
-        foreach(s, globalconf.screens)
-            screen_update_workarea(*s);
+
+        /* Only the screen of the window is affected */
+        client_t *c = luaA_toudata(L, 1, &client_class);
+        drawin_t *w = luaA_toudata(L, 1, &drawin_class);
+        screen_t *screen = NULL;
+        if(c)
+        {
+            screen_client_strut_changed(c);
+            screen = c->screen;
+        }
+        else if(w)
+        {
+            screen_drawin_strut_changed(w);
+            screen = screen_getbycoord(w->geometry.x, w->geometry.y);
+        }
+        if(screen)
+            screen_update_workarea(screen);
     }
 
     return luaA_pushstrut(L, window->strut);
@@ -21,6 +21,8 @@
 
 #include "options.h"
 #include "common/version.h"
+#include "roundtrip.h"
+#include "startup.h"
 
 #include <unistd.h>
 #include <stdio.h>
@@ -393,6 +395,12 @@ exit_help(int exit_code)
   -a, --no-argb          disable client transparency support\n\
   -l  --api-level LEVEL  select a different API support level than the current version \n\
   -m, --screen on|off    enable or disable automatic screen creation (default: on)\n\
+      --lua-allocator pool|system\n\
+                         select the memory allocator of the Lua VM\n\
+      --no-cache         do not use the Lua bytecode cache\n\
+      --profile-startup FILE\n\
+                         write a timeline of the startup to FILE and FILE.txt\n\
+      --track-roundtrips track the synchronous requests to the X server\n\
   -r, --replace          replace an existing window manager\n");
     exit(exit_code);
 }
@@ -417,6 +425,10 @@ options_check_args(int argc, char **argv, int *init_flags, string_array_t *paths
         { "screen"    , ARG   , NULL, 'm'  },
         { "api-level" , ARG   , NULL, 'l'  },
         { "reap"      , ARG   , NULL, '\1' },
+        { "lua-allocator", ARG, NULL, '\2' },
+        { "no-cache"  , NO_ARG, NULL, '\3' },
+        { "profile-startup", ARG, NULL, '\4' },
+        { "track-roundtrips", NO_ARG, NULL, '\5' },
         { NULL        , NO_ARG, NULL, 0    }
     };
 
@@ -475,6 +487,25 @@ options_check_args(int argc, char **argv, int *init_flags, string_array_t *paths
           case '\1':
             /* Silently ignore --reap and its argument */
             break;
+          case '\2':
+            if ((!optarg) || !(A_STREQ(optarg, "pool") || A_STREQ(optarg, "system")))
+                fatal("The possible values of --lua-allocator are \"pool\" or \"system\"");
+
+            globalconf.lua_pool_allocator = A_STREQ(optarg, "pool");
+            break;
+          case '\3':
+            globalconf.no_lua_cache = true;
+            break;
+          case '\4':
+            startup_profile_enable(optarg);
+            break;
+          case '\5':
+#ifdef WITH_XCB_INTERPOSER
+            roundtrip_enable(true);
+#else
+            warn("--track-roundtrips needs a build with WITH_XCB_INTERPOSER");
+#endif
+            break;
           default:
             if (! ((*init_flags) & INIT_FLAG_ALLOW_FALLBACK))
                 exit_help(EXIT_FAILURE);
@@ -45,6 +45,7 @@
 
 #include "math.h"
 
+#include <gdk-pixbuf/gdk-pixbuf.h>
 #include <xcb/xtest.h>
 #include <xcb/xcb_aux.h>
 #include <cairo-xcb.h>
@@ -53,106 +54,350 @@ static int miss_index_handler    = LUA_REFNIL;
 static int miss_newindex_handler = LUA_REFNIL;
 static int miss_call_handler     = LUA_REFNIL;
 
+/** A request to set an image file as the wallpaper of an area */
+typedef struct
+{
+    /** Path of the image */
+    char *path;
+    /** The area of the root window to cover */
+    area_t geometry;
+    /** Lua function called when done, or LUA_REFNIL */
+    int callback;
+    /** The decoded and scaled image, or NULL */
+    cairo_surface_t *surface;
+    /** The error if the image could not be loaded */
+    GError *error;
+} wallpaper_job_t;
+
+/** The wallpaper pixmap has to outlive awesome, both for other programs that
+ * use it for pseudo-transparency and for a restart. Thus it is created on a
+ * second X11 connection whose resources are retained when it closes. This
+ * connection and the pixmap are kept and reused for every change.
+ */
+static struct
+{
+    /** The connection owning the pixmap */
+    xcb_connection_t *connection;
+    /** Our pixmap, or XCB_NONE if there is none or it is no longer in use */
+    xcb_pixmap_t pixmap;
+    /** The size of the pixmap */
+    uint16_t width, height;
+    /** The queue of wallpaper_job_t for the worker thread */
+    GAsyncQueue *jobs;
+} wallpaper;
+
+static bool
+wallpaper_connect(void)
+{
+    if (wallpaper.connection)
+    {
+        if (!xcb_connection_has_error(wallpaper.connection))
+            return true;
+
+        /* Another program killed us to free our pixmap */
+        xcb_disconnect(wallpaper.connection);
+        wallpaper.pixmap = XCB_NONE;
+    }
+
+    wallpaper.connection = xcb_connect(NULL, NULL);
+    if (xcb_connection_has_error(wallpaper.connection))
+    {
+        xcb_disconnect(wallpaper.connection);
+        wallpaper.connection = NULL;
+        return false;
+    }
+
+    /* Make sure our pixmap is not destroyed when we disconnect. */
+    xcb_set_close_down_mode(wallpaper.connection, XCB_CLOSE_DOWN_RETAIN_PERMANENT);
+    return true;
+}
+
+/** Check if a resource was created on the wallpaper connection. */
+static bool
+wallpaper_owns(uint32_t resource)
+{
+    const xcb_setup_t *setup = xcb_get_setup(wallpaper.connection);
+    return (resource & ~setup->resource_id_mask) == setup->resource_id_base;
+}
+
+/** Another program set the wallpaper, free our pixmap. */
 static void
-root_set_wallpaper_pixmap(xcb_connection_t *c, xcb_pixmap_t p)
+wallpaper_forget(void)
 {
-    xcb_get_property_cookie_t prop_c;
+    xcb_pixmap_t p = wallpaper.pixmap;
+
+    wallpaper.pixmap = XCB_NONE;
+    xcb_free_pixmap(wallpaper.connection, p);
+    xcb_flush(wallpaper.connection);
+
+    /* The other program might have killed our connection instead. Since its
+     * resources were retained, this is needed to really free them. If it also
+     * killed the retained resources, this fails with an error that nobody
+     * needs to hear about.
+     */
+    if (xcb_connection_has_error(wallpaper.connection))
+        xcb_discard_reply(globalconf.connection,
+                          xcb_kill_client_checked(globalconf.connection, p).sequence);
+}
+
+/** Create a new wallpaper pixmap, which is used once it is set on the root
+ * window.
+ */
+static bool
+wallpaper_create_pixmap(uint16_t width, uint16_t height)
+{
+    if (!wallpaper_connect())
+        return false;
+
+    /* Create a pixmap and make sure it is already created, because we are
+     * going to use it from the other X11 connection (Juggling with X11
+     * connections is a really, really bad idea).
+     */
+    wallpaper.pixmap = xcb_generate_id(wallpaper.connection);
+    wallpaper.width = width;
+    wallpaper.height = height;
+    xcb_create_pixmap(wallpaper.connection, globalconf.screen->root_depth,
+                      wallpaper.pixmap, globalconf.screen->root, width, height);
+    xcb_aux_sync(wallpaper.connection);
+
+    if (xcb_connection_has_error(wallpaper.connection))
+    {
+        wallpaper.pixmap = XCB_NONE;
+        return false;
+    }
+    return true;
+}
+
+static void
+root_set_wallpaper_pixmap(xcb_connection_t *c, xcb_pixmap_t p, const area_t *area, bool replaced)
+{
+    xcb_get_property_cookie_t prop_c = { 0 };
     xcb_get_property_reply_t *prop_r;
     const xcb_screen_t *screen = globalconf.screen;
 
     /* We now have the pattern painted to the pixmap p. Now turn p into the root
      * window's background pixmap.
      */
-    xcb_change_window_attributes(c, screen->root, XCB_CW_BACK_PIXMAP, &p);
-    xcb_clear_area(c, 0, screen->root, 0, 0, 0, 0);
+    if (replaced)
+        xcb_change_window_attributes(c, screen->root, XCB_CW_BACK_PIXMAP, &p);
+    if (area && !replaced)
+        xcb_clear_area(c, 0, screen->root, area->x, area->y, area->width, area->height);
+    else
+        xcb_clear_area(c, 0, screen->root, 0, 0, 0, 0);
 
-    prop_c = xcb_get_property_unchecked(c, false,
-            screen->root, ESETROOT_PMAP_ID, XCB_ATOM_PIXMAP, 0, 1);
+    if (replaced)
+        prop_c = xcb_get_property_unchecked(c, false,
+                screen->root, ESETROOT_PMAP_ID, XCB_ATOM_PIXMAP, 0, 1);
 
     /* Theoretically, this should be enough to set the wallpaper. However, to
      * make pseudo-transparency work, clients need a way to get the wallpaper.
      * You can't query a window's back pixmap, so properties are (ab)used.
+     * They are also set when the pixmap is reused so that these clients get a
+     * PropertyNotify event.
      */
     xcb_change_property(c, XCB_PROP_MODE_REPLACE, screen->root, _XROOTPMAP_ID, XCB_ATOM_PIXMAP, 32, 1, &p);
     xcb_change_property(c, XCB_PROP_MODE_REPLACE, screen->root, ESETROOT_PMAP_ID, XCB_ATOM_PIXMAP, 32, 1, &p);
 
+    if (!replaced)
+        return;
+
     /* Now make sure that the old wallpaper is freed (but only do this for ESETROOT_PMAP_ID) */
     prop_r = xcb_get_property_reply(c, prop_c, NULL);
     if (prop_r && prop_r->value_len)
     {
         xcb_pixmap_t *rootpix = xcb_get_property_value(prop_r);
-        if (rootpix)
+        /* Killing our own connection would free the new pixmap as well. The
+         * reply above means that c is done with the old pixmap, so it can be
+         * freed from the other connection.
+         */
+        if (rootpix && wallpaper_owns(*rootpix))
+        {
+            xcb_free_pixmap(wallpaper.connection, *rootpix);
+            xcb_flush(wallpaper.connection);
+        }
+        else if (rootpix)
             xcb_kill_client(c, *rootpix);
     }
     p_delete(&prop_r);
 }
 
+/** Paint a pattern to the wallpaper.
+ * \param pattern The pattern to paint.
+ * \param area The area to repaint, with the pattern's origin at its top left
+ * corner, or NULL for the whole root window.
+ * \return true if the wallpaper was set.
+ */
 static bool
-root_set_wallpaper(cairo_pattern_t *pattern)
+root_set_wallpaper(cairo_pattern_t *pattern, const area_t *area)
 {
     lua_State *L = globalconf_get_lua_State();
-    xcb_connection_t *c = xcb_connect(NULL, NULL);
-    xcb_pixmap_t p = xcb_generate_id(c);
     /* globalconf.connection should be connected to the same X11 server, so we
      * can just use the info from that other connection.
      */
     const xcb_screen_t *screen = globalconf.screen;
     uint16_t width = screen->width_in_pixels;
     uint16_t height = screen->height_in_pixels;
-    bool result = false;
+    bool replaced = false;
     cairo_surface_t *surface;
     cairo_t *cr;
 
-    if (xcb_connection_has_error(c))
-        goto disconnect;
-
-    /* Create a pixmap and make sure it is already created, because we are going
-     * to use it from the other X11 connection (Juggling with X11 connections
-     * is a really, really bad idea).
-     */
-    xcb_create_pixmap(c, screen->root_depth, p, screen->root, width, height);
-    xcb_aux_sync(c);
+    /* The pixmap can be reused unless the size of the root window changed */
+    if (!wallpaper_connect() || wallpaper.pixmap == XCB_NONE
+            || wallpaper.width != width || wallpaper.height != height)
+    {
+        /* Try again if the connection turns out to be dead */
+        if (!wallpaper_create_pixmap(width, height) && !wallpaper_create_pixmap(width, height))
+            return false;
+        replaced = true;
+    }
 
     /* Now paint to the picture from the main connection so that cairo sees that
      * it can tell the X server to copy between the (possible) old pixmap and
      * the new one directly and doesn't need GetImage and PutImage.
      */
-    surface = cairo_xcb_surface_create(globalconf.connection, p, draw_default_visual(screen), width, height);
+    surface = cairo_xcb_surface_create(globalconf.connection, wallpaper.pixmap,
+                                       draw_default_visual(screen), width, height);
     cr = cairo_create(surface);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    if (replaced && area && globalconf.wallpaper)
+    {
+        /* Keep the old wallpaper outside of the repainted area */
+        cairo_set_source_surface(cr, globalconf.wallpaper, 0, 0);
+        cairo_paint(cr);
+    }
+    else if (replaced && area)
+    {
+        /* A new pixmap has undefined content, don't show it outside of the
+         * repainted area.
+         */
+        cairo_set_source_rgb(cr, 0, 0, 0);
+        cairo_paint(cr);
+    }
+    if (area)
+    {
+        cairo_rectangle(cr, area->x, area->y, area->width, area->height);
+        cairo_clip(cr);
+        cairo_translate(cr, area->x, area->y);
+    }
     /* Paint the pattern to the surface */
     cairo_set_source(cr, pattern);
-    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
     cairo_paint(cr);
     cairo_destroy(cr);
     cairo_surface_flush(surface);
-    xcb_aux_sync(globalconf.connection);
 
-    /* Change the wallpaper, without sending us a PropertyNotify event */
+    /* Change the wallpaper, without sending us a PropertyNotify event. The
+     * requests are ordered on the main connection, so the X server has the new
+     * content when the root window is cleared.
+     */
     xcb_grab_server(globalconf.connection);
     xcb_change_window_attributes(globalconf.connection,
                                  globalconf.screen->root,
                                  XCB_CW_EVENT_MASK,
                                  (uint32_t[]) { 0 });
-    root_set_wallpaper_pixmap(globalconf.connection, p);
+    root_set_wallpaper_pixmap(globalconf.connection, wallpaper.pixmap, area, replaced);
     xcb_change_window_attributes(globalconf.connection,
                                  globalconf.screen->root,
                                  XCB_CW_EVENT_MASK,
                                  ROOT_WINDOW_EVENT_MASK);
     xutil_ungrab_server(globalconf.connection);
 
-    /* Make sure our pixmap is not destroyed when we disconnect. */
-    xcb_set_close_down_mode(c, XCB_CLOSE_DOWN_RETAIN_PERMANENT);
-
     /* Tell Lua that the wallpaper changed */
     cairo_surface_destroy(globalconf.wallpaper);
     globalconf.wallpaper = surface;
     signal_object_emit(L, &global_signals, "wallpaper_changed", 0);
 
-    result = true;
-disconnect:
-    xcb_aux_sync(c);
-    xcb_disconnect(c);
-    return result;
+    return true;
+}
+
+/** Decode an image and scale it so that it covers the area of the job. This
+ * runs on the worker thread.
+ */
+static void
+wallpaper_job_decode(wallpaper_job_t *job)
+{
+    int width, height;
+    double scale;
+    GdkPixbuf *buf;
+
+    if (!gdk_pixbuf_get_file_info(job->path, &width, &height))
+    {
+        g_set_error(&job->error, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_UNKNOWN_TYPE,
+                    "Could not load image %s", job->path);
+        return;
+    }
+
+    scale = fmax((double) job->geometry.width / width,
+                 (double) job->geometry.height / height);
+    buf = gdk_pixbuf_new_from_file_at_scale(job->path,
+                                            fmax(1, ceil(width * scale)),
+                                            fmax(1, ceil(height * scale)),
+                                            false, &job->error);
+    if (buf)
+    {
+        job->surface = draw_surface_from_pixbuf(buf);
+        g_object_unref(buf);
+    }
+}
+
+/** Set the decoded image of a job as the wallpaper on the main thread. */
+static gboolean
+wallpaper_job_finish(gpointer data)
+{
+    lua_State *L = globalconf_get_lua_State();
+    wallpaper_job_t *job = data;
+    bool result = false;
+
+    if (job->surface)
+    {
+        cairo_pattern_t *pattern = cairo_pattern_create_for_surface(job->surface);
+        cairo_matrix_t matrix;
+
+        /* Center the image in the area */
+        cairo_matrix_init_translate(&matrix,
+                (cairo_image_surface_get_width(job->surface) - job->geometry.width) / 2.0,
+                (cairo_image_surface_get_height(job->surface) - job->geometry.height) / 2.0);
+        cairo_pattern_set_matrix(pattern, &matrix);
+        result = root_set_wallpaper(pattern, &job->geometry);
+        cairo_pattern_destroy(pattern);
+        cairo_surface_destroy(job->surface);
+    }
+
+    if (job->callback != LUA_REFNIL)
+    {
+        lua_pushboolean(L, result);
+        if (job->error)
+            lua_pushstring(L, job->error->message);
+        else
+            lua_pushnil(L);
+        lua_rawgeti(L, LUA_REGISTRYINDEX, job->callback);
+        luaA_dofunction(L, 2, 0);
+        luaA_unregister(L, &job->callback);
+    }
+
+    if (job->error)
+        g_error_free(job->error);
+    g_free(job->path);
+    p_delete(&job);
+
+    return G_SOURCE_REMOVE;
+}
+
+/** The worker thread. Jobs are handled one after the other so that their
+ * results are applied in the order in which they were requested.
+ */
+static gpointer
+wallpaper_worker(gpointer data)
+{
+    GAsyncQueue *jobs = data;
+
+    while (true)
+    {
+        wallpaper_job_t *job = g_async_queue_pop(jobs);
+        wallpaper_job_decode(job);
+        g_idle_add(wallpaper_job_finish, job);
+    }
+
+    return NULL;
 }
 
 void
@@ -171,13 +416,12 @@ root_update_wallpaper(void)
             globalconf.screen->root, _XROOTPMAP_ID, XCB_ATOM_PIXMAP, 0, 1);
     prop_r = xcb_get_property_reply(globalconf.connection, prop_c, NULL);
 
-    if (!prop_r || !prop_r->value_len)
-    {
-        p_delete(&prop_r);
-        return;
-    }
+    rootpix = prop_r && prop_r->value_len ? xcb_get_property_value(prop_r) : NULL;
+
+    /* Somebody else set the wallpaper */
+    if (wallpaper.pixmap != XCB_NONE && (!rootpix || *rootpix != wallpaper.pixmap))
+        wallpaper_forget();
 
-    rootpix = xcb_get_property_value(prop_r);
     if (!rootpix)
     {
         p_delete(&prop_r);
@@ -483,9 +727,26 @@ luaA_root_drawins(lua_State *L)
     return 1;
 }
 
+/* Get the area given as x, y, width and height starting at index idx. */
+static void
+luaA_root_checkarea(lua_State *L, int idx, area_t *area)
+{
+    area->x = luaA_checkinteger_range(L, idx, INT16_MIN, INT16_MAX);
+    area->y = luaA_checkinteger_range(L, idx + 1, INT16_MIN, INT16_MAX);
+    area->width = luaA_checkinteger_range(L, idx + 2, 1, UINT16_MAX);
+    area->height = luaA_checkinteger_range(L, idx + 3, 1, UINT16_MAX);
+}
+
 /** Get the wallpaper as a cairo surface or set it as a cairo pattern.
+ *
+ * When an area is given, only this part of the wallpaper is repainted and the
+ * origin of the pattern is at its top left corner.
  *
  * @param pattern A cairo pattern as light userdata
+ * @tparam[opt] integer x The x coordinate of the area to repaint.
+ * @tparam[opt] integer y The y coordinate of the area to repaint.
+ * @tparam[opt] integer width The width of the area to repaint.
+ * @tparam[opt] integer height The height of the area to repaint.
  * @return A cairo surface or nothing.
  * @deprecated wallpaper
  * @see awful.wallpaper
@@ -493,15 +754,23 @@ luaA_root_drawins(lua_State *L)
 static int
 luaA_root_wallpaper(lua_State *L)
 {
-    if(lua_gettop(L) == 1)
+    if(lua_gettop(L) >= 1)
     {
+        area_t area;
+
         /* Avoid `error()s` down the line. If this happens during
          * initialization, AwesomeWM can be stuck in an infinite loop */
-        if(lua_isnil(L, -1))
+        if(lua_isnil(L, 1))
             return 0;
 
-        cairo_pattern_t *pattern = (cairo_pattern_t *)lua_touserdata(L, -1);
-        lua_pushboolean(L, root_set_wallpaper(pattern));
+        cairo_pattern_t *pattern = (cairo_pattern_t *)lua_touserdata(L, 1);
+        if(lua_isnoneornil(L, 2))
+            lua_pushboolean(L, root_set_wallpaper(pattern, NULL));
+        else
+        {
+            luaA_root_checkarea(L, 2, &area);
+            lua_pushboolean(L, root_set_wallpaper(pattern, &area));
+        }
         /* Don't return the wallpaper, it's too easy to get memleaks */
         return 1;
     }
@@ -514,6 +783,48 @@ luaA_root_wallpaper(lua_State *L)
     return 1;
 }
 
+/** Set an image file as the wallpaper of an area of the root window.
+ *
+ * The image is decoded and scaled on a worker thread, so this returns
+ * immediately. It is scaled to cover the area while keeping its aspect ratio
+ * and centered. Requests are applied in the order in which they were made.
+ *
+ * @tparam string path The path of the image file.
+ * @tparam integer x The x coordinate of the area.
+ * @tparam integer y The y coordinate of the area.
+ * @tparam integer width The width of the area.
+ * @tparam integer height The height of the area.
+ * @tparam[opt] function callback Called with a boolean telling if the
+ *  wallpaper was set and an error message if the image could not be loaded.
+ * @staticfct _wallpaper_load
+ */
+static int
+luaA_root_wallpaper_load(lua_State *L)
+{
+    const char *path = luaL_checkstring(L, 1);
+    wallpaper_job_t *job;
+    area_t geometry;
+
+    luaA_root_checkarea(L, 2, &geometry);
+    if(!lua_isnoneornil(L, 6))
+        luaA_checkfunction(L, 6);
+
+    job = p_new(wallpaper_job_t, 1);
+    job->path = g_strdup(path);
+    job->geometry = geometry;
+    job->callback = LUA_REFNIL;
+    if(!lua_isnoneornil(L, 6))
+        luaA_registerfct(L, 6, &job->callback);
+
+    if(!wallpaper.jobs)
+    {
+        wallpaper.jobs = g_async_queue_new();
+        g_thread_unref(g_thread_new("wallpaper", wallpaper_worker, wallpaper.jobs));
+    }
+    g_async_queue_push(wallpaper.jobs, job);
+
+    return 0;
+}
 
 /** Get the content of the root window as a cairo surface.
  *
@@ -647,6 +958,7 @@ const struct luaL_Reg awesome_root_methods[] =
     { "fake_input", luaA_root_fake_input },
     { "drawins", luaA_root_drawins },
     { "_wallpaper", luaA_root_wallpaper },
+    { "_wallpaper_load", luaA_root_wallpaper_load },
     { "content", luaA_root_get_content},
     { "size", luaA_root_size },
     { "size_mm", luaA_root_size_mm },
@@ -0,0 +1,296 @@
+/*
+ * roundtrip.c - synchronous X round-trip tracking
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* Every xcb_*_reply() function, as well as xcb_aux_sync(), ends up in
+ * xcb_wait_for_reply() and checked requests end up in xcb_request_check().
+ * awesome is linked with -rdynamic, so defining these functions here makes
+ * libxcb, its extensions and cairo call them instead of the real ones, which
+ * are found with dlsym(RTLD_NEXT). This is only done in builds with
+ * WITH_XCB_INTERPOSER.
+ *
+ * When tracking is enabled, each wait is timed and attributed to the request
+ * whose reply it waits for and the Lua stack at that time. The reply
+ * functions tail-call xcb_wait_for_reply(), so the caller cannot tell which
+ * request it is. Instead, the sequence number is looked up in the opcodes of
+ * the last requests, which xrequest.c keeps.
+ */
+
+#define _GNU_SOURCE
+
+#include "roundtrip.h"
+#include "globalconf.h"
+#include "xrequest.h"
+
+#include <lauxlib.h>
+
+#include <dlfcn.h>
+
+#define ROUNDTRIP_MAX_DEPTH 16
+#define ROUNDTRIP_DEFAULT_LIMIT 20
+
+typedef struct
+{
+    /** The name of the request and the Lua traceback */
+    char *key;
+    /** Number of waits */
+    unsigned int count;
+    /** Total and longest time spent waiting, in microseconds */
+    gint64 time, max;
+} roundtrip_site_t;
+
+static struct
+{
+    /** Is tracking enabled? */
+    bool enabled;
+    /** The only thread whose waits are tracked */
+    GThread *main_thread;
+    /** The call sites, by key */
+    GHashTable *sites;
+    /** Number of waits and time spent in them */
+    unsigned int count;
+    gint64 time;
+} roundtrip;
+
+static void
+roundtrip_site_delete(gpointer data)
+{
+    roundtrip_site_t *site = data;
+    g_free(site->key);
+    p_delete(&site);
+}
+
+/** Enable or disable tracking. Enabling it clears the previous data.
+ * \param enable True to enable tracking.
+ */
+void
+roundtrip_enable(bool enable)
+{
+    if(roundtrip.sites)
+        g_hash_table_unref(roundtrip.sites);
+    roundtrip.sites = NULL;
+    roundtrip.count = 0;
+    roundtrip.time = 0;
+
+    if(enable)
+    {
+        roundtrip.sites = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                NULL, roundtrip_site_delete);
+        roundtrip.main_thread = g_thread_self();
+    }
+    roundtrip.enabled = enable;
+}
+
+#ifdef WITH_XCB_INTERPOSER
+
+/** Describe the current Lua stack.
+ * \param buf The buffer to append the traceback to.
+ */
+static void
+roundtrip_traceback(GString *buf)
+{
+    lua_State *L = globalconf_get_lua_State();
+    lua_Debug ar;
+    int level;
+
+    for(level = 0; L && level < ROUNDTRIP_MAX_DEPTH && lua_getstack(L, level, &ar); level++)
+    {
+        lua_getinfo(L, "Sln", &ar);
+        g_string_append_printf(buf, "\n\t%s:", ar.short_src);
+        if(ar.currentline > 0)
+            g_string_append_printf(buf, "%d:", ar.currentline);
+        if(ar.name)
+            g_string_append_printf(buf, " in function '%s'", ar.name);
+        else if(*ar.what == 'm')
+            g_string_append(buf, " in main chunk");
+        else
+            g_string_append_printf(buf, " in function <%s:%d>", ar.short_src, ar.linedefined);
+    }
+
+    if(level == 0)
+        g_string_append(buf, "\n\t(not called from Lua)");
+}
+
+/** Account for a wait.
+ * \param sequence The sequence number of the request waited for.
+ * \param start When the wait started.
+ */
+static void
+roundtrip_record(uint64_t sequence, gint64 start)
+{
+    gint64 elapsed = g_get_monotonic_time() - start;
+    GString *key = g_string_new(NULL);
+
+    xrequest_describe(key, sequence);
+    roundtrip_traceback(key);
+
+    roundtrip_site_t *site = g_hash_table_lookup(roundtrip.sites, key->str);
+    if(site)
+        g_string_free(key, TRUE);
+    else
+    {
+        site = p_new(roundtrip_site_t, 1);
+        site->key = g_string_free(key, FALSE);
+        g_hash_table_insert(roundtrip.sites, site->key, site);
+    }
+
+    site->count++;
+    site->time += elapsed;
+    site->max = MAX(site->max, elapsed);
+    roundtrip.count++;
+    roundtrip.time += elapsed;
+}
+
+#define ROUNDTRIP_TRACKED \
+    (roundtrip.enabled && g_thread_self() == roundtrip.main_thread)
+
+void *
+xcb_wait_for_reply(xcb_connection_t *c, unsigned int request, xcb_generic_error_t **e)
+{
+    static void *(*real)(xcb_connection_t *, unsigned int, xcb_generic_error_t **);
+    if(!real)
+        real = dlsym(RTLD_NEXT, "xcb_wait_for_reply");
+
+    if(!ROUNDTRIP_TRACKED)
+        return real(c, request, e);
+
+    gint64 start = g_get_monotonic_time();
+    void *reply = real(c, request, e);
+    roundtrip_record(request, start);
+    return reply;
+}
+
+void *
+xcb_wait_for_reply64(xcb_connection_t *c, uint64_t request, xcb_generic_error_t **e)
+{
+    static void *(*real)(xcb_connection_t *, uint64_t, xcb_generic_error_t **);
+    if(!real)
+        real = dlsym(RTLD_NEXT, "xcb_wait_for_reply64");
+
+    if(!ROUNDTRIP_TRACKED)
+        return real(c, request, e);
+
+    gint64 start = g_get_monotonic_time();
+    void *reply = real(c, request, e);
+    roundtrip_record(request, start);
+    return reply;
+}
+
+xcb_generic_error_t *
+xcb_request_check(xcb_connection_t *c, xcb_void_cookie_t cookie)
+{
+    static xcb_generic_error_t *(*real)(xcb_connection_t *, xcb_void_cookie_t);
+    if(!real)
+        real = dlsym(RTLD_NEXT, "xcb_request_check");
+
+    if(!ROUNDTRIP_TRACKED)
+        return real(c, cookie);
+
+    gint64 start = g_get_monotonic_time();
+    xcb_generic_error_t *error = real(c, cookie);
+    roundtrip_record(cookie.sequence, start);
+    return error;
+}
+
+#undef ROUNDTRIP_TRACKED
+
+#endif /* WITH_XCB_INTERPOSER */
+
+/** Enable or disable the tracking of synchronous X round-trips.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam True to enable tracking, false to disable it.
+ * \lreturn Whether tracking was enabled.
+ */
+int
+luaA_track_roundtrips(lua_State *L)
+{
+    bool was_enabled = roundtrip.enabled;
+    roundtrip_enable(luaA_checkboolean(L, 1));
+    lua_pushboolean(L, was_enabled);
+    return 1;
+}
+
+static gint
+roundtrip_site_cmp(gconstpointer a, gconstpointer b)
+{
+    const roundtrip_site_t *sa = *(roundtrip_site_t * const *) a;
+    const roundtrip_site_t *sb = *(roundtrip_site_t * const *) b;
+
+    if(sa->time != sb->time)
+        return sa->time < sb->time ? 1 : -1;
+    return sa->count < sb->count ? 1 : (sa->count > sb->count ? -1 : 0);
+}
+
+/** Get the call sites which waited the longest for the X server.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam The maximum number of call sites, 20 by default.
+ * \lreturn A table of call sites, or nil when tracking is disabled.
+ */
+int
+luaA_roundtrip_report(lua_State *L)
+{
+    int limit = luaL_optinteger(L, 1, ROUNDTRIP_DEFAULT_LIMIT);
+
+    if(!roundtrip.enabled)
+        return 0;
+
+    GPtrArray *sites = g_ptr_array_sized_new(g_hash_table_size(roundtrip.sites));
+    GHashTableIter iter;
+    gpointer value;
+
+    g_hash_table_iter_init(&iter, roundtrip.sites);
+    while(g_hash_table_iter_next(&iter, NULL, &value))
+        g_ptr_array_add(sites, value);
+    g_ptr_array_sort(sites, roundtrip_site_cmp);
+
+    lua_createtable(L, MIN((int) sites->len, limit), 2);
+    lua_pushinteger(L, roundtrip.count);
+    lua_setfield(L, -2, "count");
+    lua_pushinteger(L, roundtrip.time);
+    lua_setfield(L, -2, "time");
+
+    for(int i = 0; i < (int) sites->len && i < limit; i++)
+    {
+        roundtrip_site_t *site = g_ptr_array_index(sites, i);
+        const char *traceback = strchr(site->key, '\n');
+
+        lua_createtable(L, 0, 5);
+        lua_pushlstring(L, site->key, traceback - site->key);
+        lua_setfield(L, -2, "request");
+        lua_pushstring(L, traceback + 1);
+        lua_setfield(L, -2, "traceback");
+        lua_pushinteger(L, site->count);
+        lua_setfield(L, -2, "count");
+        lua_pushinteger(L, site->time);
+        lua_setfield(L, -2, "time");
+        lua_pushinteger(L, site->max);
+        lua_setfield(L, -2, "max");
+        lua_rawseti(L, -2, i + 1);
+    }
+
+    g_ptr_array_free(sites, TRUE);
+    return 1;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
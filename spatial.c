@@ -0,0 +1,351 @@
+/*
+ * spatial.c - spatial index for screens and clients
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* The index is a uniform grid laid over the root window. Every screen and
+ * every managed client is stored in each cell its geometry overlaps.
+ * Coordinates outside of the root window are clamped to the border cells, so
+ * objects and queries outside of it still meet in the same cells. The grid is
+ * rebuilt when the root window size changes.
+ */
+
+#include "spatial.h"
+#include "objects/client.h"
+#include "objects/screen.h"
+
+#include <stdlib.h>
+
+/** Width and height of a grid cell, as a power of two */
+#define SPATIAL_CELL_SHIFT 8
+
+typedef struct
+{
+    client_array_t clients;
+    screen_array_t screens;
+} spatial_cell_t;
+
+static struct
+{
+    /** Root window size the grid was built for */
+    uint16_t width, height;
+    /** Number of columns and rows */
+    int cols, rows;
+    /** The cells, row by row */
+    spatial_cell_t *cells;
+    /** Counter used to visit each object only once per query */
+    uint32_t query;
+} grid;
+
+static inline spatial_cell_t *
+spatial_cell(int col, int row)
+{
+    return &grid.cells[row * grid.cols + col];
+}
+
+static inline int
+spatial_col(int x)
+{
+    if(x < 0)
+        return 0;
+    return MIN(x >> SPATIAL_CELL_SHIFT, grid.cols - 1);
+}
+
+static inline int
+spatial_row(int y)
+{
+    if(y < 0)
+        return 0;
+    return MIN(y >> SPATIAL_CELL_SHIFT, grid.rows - 1);
+}
+
+/** Compute the cells covered by a geometry.
+ * \param geometry The geometry.
+ * \param cells Where to store the cell range.
+ */
+static void
+spatial_cells_for(area_t geometry, spatial_cells_t *cells)
+{
+    cells->col1 = spatial_col(geometry.x);
+    cells->row1 = spatial_row(geometry.y);
+    cells->col2 = spatial_col(geometry.x + MAX(geometry.width, 1) - 1);
+    cells->row2 = spatial_row(geometry.y + MAX(geometry.height, 1) - 1);
+}
+
+/** Get the area covered by a client, including its border.
+ * \param c The client.
+ * \return The covered area.
+ */
+static area_t
+spatial_client_area(client_t *c)
+{
+    area_t area = c->geometry;
+    area.width += 2 * c->border_width;
+    area.height += 2 * c->border_width;
+    return area;
+}
+
+static bool
+spatial_area_contains(area_t area, int x, int y)
+{
+    return x >= area.x && x < area.x + area.width
+        && y >= area.y && y < area.y + area.height;
+}
+
+static bool
+spatial_area_intersects(area_t a, area_t b)
+{
+    return a.x < b.x + b.width && b.x < a.x + a.width
+        && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+static void
+spatial_client_insert(client_t *c)
+{
+    spatial_cells_for(spatial_client_area(c), &c->spatial);
+    for(int row = c->spatial.row1; row <= c->spatial.row2; row++)
+        for(int col = c->spatial.col1; col <= c->spatial.col2; col++)
+            client_array_append(&spatial_cell(col, row)->clients, c);
+    c->spatial.indexed = true;
+}
+
+static void
+spatial_screen_insert(screen_t *s)
+{
+    spatial_cells_for(s->geometry, &s->spatial);
+    for(int row = s->spatial.row1; row <= s->spatial.row2; row++)
+        for(int col = s->spatial.col1; col <= s->spatial.col2; col++)
+            screen_array_append(&spatial_cell(col, row)->screens, s);
+    s->spatial.indexed = true;
+}
+
+/** Make sure the grid matches the current root window size, rebuilding it
+ * from scratch if it does not.
+ */
+static void
+spatial_grid_check(void)
+{
+    uint16_t width = MAX(globalconf.screen->width_in_pixels, 1);
+    uint16_t height = MAX(globalconf.screen->height_in_pixels, 1);
+
+    if(grid.cells && grid.width == width && grid.height == height)
+        return;
+
+    for(int i = 0; i < grid.cols * grid.rows; i++)
+    {
+        client_array_wipe(&grid.cells[i].clients);
+        screen_array_wipe(&grid.cells[i].screens);
+    }
+    p_delete(&grid.cells);
+
+    grid.width = width;
+    grid.height = height;
+    grid.cols = ((width - 1) >> SPATIAL_CELL_SHIFT) + 1;
+    grid.rows = ((height - 1) >> SPATIAL_CELL_SHIFT) + 1;
+    grid.cells = p_new(spatial_cell_t, grid.cols * grid.rows);
+
+    foreach(c, globalconf.clients)
+        if((*c)->spatial.indexed)
+            spatial_client_insert(*c);
+    foreach(s, globalconf.screens)
+        if((*s)->spatial.indexed)
+            spatial_screen_insert(*s);
+}
+
+/** Remove a client from the index.
+ * \param c The client.
+ */
+void
+spatial_client_remove(client_t *c)
+{
+    if(!c->spatial.indexed)
+        return;
+
+    spatial_grid_check();
+
+    /* The cell range may come from a larger grid, stay within this one */
+    c->spatial.indexed = false;
+    for(int row = c->spatial.row1; row <= c->spatial.row2 && row < grid.rows; row++)
+        for(int col = c->spatial.col1; col <= c->spatial.col2 && col < grid.cols; col++)
+        {
+            spatial_cell_t *cell = spatial_cell(col, row);
+            foreach(elem, cell->clients)
+                if(*elem == c)
+                {
+                    client_array_remove(&cell->clients, elem);
+                    break;
+                }
+        }
+}
+
+/** Add a client to the index, or move it after its geometry or border width
+ * changed.
+ * \param c The client.
+ */
+void
+spatial_client_update(client_t *c)
+{
+    spatial_grid_check();
+
+    if(c->spatial.indexed)
+    {
+        spatial_cells_t cells;
+        spatial_cells_for(spatial_client_area(c), &cells);
+        if(cells.col1 == c->spatial.col1 && cells.row1 == c->spatial.row1
+           && cells.col2 == c->spatial.col2 && cells.row2 == c->spatial.row2)
+            return;
+        spatial_client_remove(c);
+    }
+
+    spatial_client_insert(c);
+}
+
+/** Remove a screen from the index.
+ * \param s The screen.
+ */
+void
+spatial_screen_remove(screen_t *s)
+{
+    if(!s->spatial.indexed)
+        return;
+
+    spatial_grid_check();
+
+    s->spatial.indexed = false;
+    for(int row = s->spatial.row1; row <= s->spatial.row2 && row < grid.rows; row++)
+        for(int col = s->spatial.col1; col <= s->spatial.col2 && col < grid.cols; col++)
+        {
+            spatial_cell_t *cell = spatial_cell(col, row);
+            foreach(elem, cell->screens)
+                if(*elem == s)
+                {
+                    screen_array_remove(&cell->screens, elem);
+                    break;
+                }
+        }
+}
+
+/** Add a screen to the index, or move it after its geometry changed.
+ * \param s The screen.
+ */
+void
+spatial_screen_update(screen_t *s)
+{
+    spatial_screen_remove(s);
+    spatial_grid_check();
+    spatial_screen_insert(s);
+}
+
+/** Get the topmost visible client at the given coordinates.
+ * \param x X coordinate.
+ * \param y Y coordinate.
+ * \return The client, or NULL if there is none.
+ */
+client_t *
+spatial_client_at(int x, int y)
+{
+    client_t *found = NULL;
+
+    spatial_grid_check();
+
+    foreach(c, spatial_cell(spatial_col(x), spatial_row(y))->clients)
+        if((!found || (*c)->stack_position > found->stack_position)
+           && client_isvisible(*c)
+           && spatial_area_contains(spatial_client_area(*c), x, y))
+            found = *c;
+
+    return found;
+}
+
+static int
+spatial_stack_cmp(const void *a, const void *b)
+{
+    const client_t *ca = *(client_t * const *) a, *cb = *(client_t * const *) b;
+    if(ca->stack_position == cb->stack_position)
+        return 0;
+    return ca->stack_position > cb->stack_position ? -1 : 1;
+}
+
+/** Get all visible clients intersecting a geometry, topmost first.
+ * \param geometry The geometry.
+ * \param result Array the clients are appended to.
+ */
+void
+spatial_clients_intersecting(area_t geometry, client_array_t *result)
+{
+    spatial_cells_t cells;
+    int first = result->len;
+
+    spatial_grid_check();
+    spatial_cells_for(geometry, &cells);
+    grid.query++;
+
+    for(int row = cells.row1; row <= cells.row2; row++)
+        for(int col = cells.col1; col <= cells.col2; col++)
+            foreach(c, spatial_cell(col, row)->clients)
+            {
+                if((*c)->spatial.query == grid.query)
+                    continue;
+                (*c)->spatial.query = grid.query;
+                if(client_isvisible(*c)
+                   && spatial_area_intersects(spatial_client_area(*c), geometry))
+                    client_array_append(result, *c);
+            }
+
+    qsort(result->tab + first, result->len - first, sizeof(client_t *),
+          spatial_stack_cmp);
+}
+
+/** Get the screen containing the given coordinates. When screens overlap,
+ * the first one in the screen list wins, like screen_getbycoord().
+ * \param x X coordinate.
+ * \param y Y coordinate.
+ * \return The screen, or NULL if no screen contains the point.
+ */
+screen_t *
+spatial_screen_at(int x, int y)
+{
+    screen_t *found = NULL;
+    int found_index = 0;
+
+    spatial_grid_check();
+
+    foreach(s, spatial_cell(spatial_col(x), spatial_row(y))->screens)
+        if(screen_coord_in_screen(*s, x, y))
+        {
+            if(!found)
+                found = *s;
+            else
+            {
+                /* Only pay for the index lookup on overlapping screens */
+                if(!found_index)
+                    found_index = screen_get_index(found);
+                int index = screen_get_index(*s);
+                if(index < found_index)
+                {
+                    found = *s;
+                    found_index = index;
+                }
+            }
+        }
+
+    return found;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,49 @@
+/*
+ * spatial.h - spatial index for screens and clients header
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_SPATIAL_H
+#define AWESOME_SPATIAL_H
+
+#include "globalconf.h"
+#include "draw.h"
+
+/** Grid cells the object is currently stored in */
+typedef struct
+{
+    /** True if the object is in the index */
+    bool indexed;
+    /** Inclusive range of grid columns and rows */
+    uint16_t col1, row1, col2, row2;
+    /** Last query which visited this object */
+    uint32_t query;
+} spatial_cells_t;
+
+void spatial_client_update(client_t *);
+void spatial_client_remove(client_t *);
+void spatial_screen_update(screen_t *);
+void spatial_screen_remove(screen_t *);
+
+client_t *spatial_client_at(int, int);
+void spatial_clients_intersecting(area_t, client_array_t *);
+screen_t *spatial_screen_at(int, int);
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -112,7 +112,7 @@ spawn_monitor_timeout(gpointer sequence)
 {
     if(spawn_sequence_remove(sequence))
     {
-         signal_t *sig = signal_array_getbyname(&global_signals, "spawn::timeout");
+         signal_t *sig = signal_hashmap_getbyname(&global_signals, "spawn::timeout");
          if(sig)
          {
              /* send a timeout signal */
@@ -219,7 +219,7 @@ spawn_monitor_event(SnMonitorEvent *event, void *data)
     }
 
     /* send the signal */
-    signal_t *sig = signal_array_getbyname(&global_signals, event_type_str);
+    signal_t *sig = signal_hashmap_getbyname(&global_signals, event_type_str);
 
     if(sig)
     {
@@ -0,0 +1,105 @@
+---------------------------------------------------------------------------
+-- @author awesome developers
+-- @copyright 2026 awesome developers
+---------------------------------------------------------------------------
+
+local lru_cache = require("gears.lru_cache")
+
+describe("gears.lru_cache", function()
+    local num_calls, c
+    before_each(function()
+        num_calls = 0
+        c = lru_cache(function(a, b)
+            num_calls = num_calls + 1
+            return a + b, a - b
+        end, 3)
+    end)
+
+    it("Cache works", function()
+        assert.is.same({ c:get(1, 2) }, { 3, -1 })
+        assert.is.same({ c:get(1, 3) }, { 4, -2 })
+        assert.is.same({ c:get(1, 2) }, { 3, -1 })
+        assert.is.equal(num_calls, 2)
+        assert.is.same(c.stats, { hits = 1, misses = 2, evictions = 0 })
+    end)
+
+    it("Zero arguments", function()
+        local called = 0
+        local c2 = lru_cache(function()
+            called = called + 1
+        end)
+        assert.is_nil(c2:get())
+        assert.is_nil(c2:get())
+        assert.is.equal(called, 1)
+    end)
+
+    it("Least recently used entry is evicted", function()
+        c:get(1, 1)
+        c:get(1, 2)
+        c:get(1, 3)
+        -- Make (1, 1) the most recently used entry
+        c:get(1, 1)
+        c:get(2, 1)
+        assert.is.equal(c:get_count(), 3)
+        assert.is.equal(c.stats.evictions, 1)
+        assert.is.equal(num_calls, 4)
+
+        -- (1, 2) was evicted
+        c:get(1, 1)
+        c:get(1, 3)
+        assert.is.equal(num_calls, 4)
+        c:get(1, 2)
+        assert.is.equal(num_calls, 5)
+    end)
+
+    it("Invalidation of a prefix", function()
+        c:get(1, 1)
+        c:get(1, 2)
+        c:get(2, 1)
+        c:invalidate(1)
+        assert.is.equal(c:get_count(), 1)
+        c:get(2, 1)
+        assert.is.equal(num_calls, 3)
+        c:get(1, 1)
+        assert.is.equal(num_calls, 4)
+
+        -- Unknown prefixes are ignored
+        c:invalidate(5, 5)
+        assert.is.equal(c:get_count(), 2)
+    end)
+
+    it("Clear", function()
+        c:get(1, 1)
+        c:get(1, 2)
+        c:clear()
+        assert.is.equal(c:get_count(), 0)
+        c:get(1, 1)
+        assert.is.equal(num_calls, 3)
+    end)
+
+    it("Clear during the creation callback", function()
+        local c2
+        c2 = lru_cache(function(a)
+            num_calls = num_calls + 1
+            c2:clear()
+            return a
+        end)
+        assert.is.equal(c2:get(1), 1)
+        assert.is.equal(c2:get(1), 1)
+        assert.is.equal(num_calls, 2)
+        assert.is.equal(c2:get_count(), 0)
+    end)
+
+    it("Shared statistics", function()
+        local stats = { hits = 0, misses = 0, evictions = 0 }
+        local c1 = lru_cache(function() end, 1, stats)
+        local c2 = lru_cache(function() end, 1, stats)
+        c1:get(1)
+        c2:get(1)
+        c2:get(1)
+        c2:get(2)
+        assert.is.same(stats, { hits = 1, misses = 3, evictions = 1 })
+    end)
+end)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
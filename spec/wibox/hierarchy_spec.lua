@@ -320,6 +320,47 @@ describe("wibox.hierarchy", function()
             assert.is.equal(0, #weak)
         end)
     end)
+
+    describe("relayout", function()
+        local base = require("wibox.widget.base")
+        local child, parent, context, instance
+        local child_size, parent_layouts
+        before_each(function()
+            local function nop() end
+            context = {}
+            child_size = 5
+            parent_layouts = 0
+            child = base.make_widget()
+            child.fit = function()
+                return child_size, 10
+            end
+            parent = base.make_widget()
+            parent.layout = function(self, ctx, width, height)
+                parent_layouts = parent_layouts + 1
+                local w = base.fit_widget(self, ctx, child, width, height)
+                return { base.place_widget_at(child, width - w, 0, w, height) }
+            end
+            instance = hierarchy.new(context, parent, 20, 10, nop, nop)
+        end)
+
+        it("same size", function()
+            child:emit_signal("widget::layout_changed")
+            local region = instance:update(context, parent, 20, 10)
+            assert.is.equal(1, parent_layouts)
+            assert.is.equal(region:num_rectangles(), 0)
+        end)
+
+        it("size changed", function()
+            child_size = 7
+            child:emit_signal("widget::layout_changed")
+            local region = instance:update(context, parent, 20, 10)
+            assert.is.equal(2, parent_layouts)
+            assert.is.equal(region:num_rectangles(), 1)
+            local rect = region:get_rectangle(0)
+            assert.is.same({ rect.x, rect.y, rect.width, rect.height }, { 13, 0, 7, 10 })
+            assert.is.same({ instance:get_children()[1]:get_size() }, { 7, 10 })
+        end)
+    end)
 end)
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -47,6 +47,20 @@ describe("wibox.widget.base", function()
             collectgarbage("collect")
             assert.is.equal(0, #alive)
         end)
+
+        it("does not keep the context alive", function()
+            local context = { "fake context" }
+            local alive = setmetatable({ context }, { __mode = "v" })
+            base.fit_widget(no_parent, context, widget1, 20, 20)
+            base.layout_widget(no_parent, context, widget1, 20, 20)
+
+            context = nil
+            collectgarbage("collect")
+            assert.is_nil(alive[1])
+
+            -- The widget still works with new contexts.
+            base.layout_widget(no_parent, { "other context" }, widget1, 20, 20)
+        end)
     end)
 
     describe("setup", function()
@@ -147,6 +147,30 @@ describe("wibox.widget.textbox", function()
 
     end)
 
+    describe("layout cache", function()
+
+        it("shares layouts between textboxes", function()
+            local before = textbox.get_cache_stats()
+            local w1, h1 = textbox("shared layout"):get_preferred_size_at_dpi(96)
+            local w2, h2 = textbox("shared layout"):get_preferred_size_at_dpi(96)
+            local after = textbox.get_cache_stats()
+            assert.is.equal(w1, w2)
+            assert.is.equal(h1, h2)
+            assert.is.equal(1, after.misses - before.misses)
+            assert.is.equal(1, after.hits - before.hits)
+        end)
+
+        it("depends on the properties of the textbox", function()
+            local box = textbox("changing font")
+            local w1 = box:get_preferred_size_at_dpi(96)
+            box:set_font("Monospace 20")
+            local w2 = box:get_preferred_size_at_dpi(96)
+            assert.is_true(w2 > w1)
+            assert.is_true(box:get_preferred_size_at_dpi(192) > w2)
+        end)
+
+    end)
+
 end)
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
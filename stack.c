@@ -62,6 +62,8 @@ stack_client_append(client_t *c)
 }
 
 static bool need_stack_refresh = false;
+/** Counter giving clients their position in the stacking order */
+static uint32_t stack_position = 0;
 
 void
 stack_windows(void)
@@ -97,6 +99,8 @@ stack_client_above(client_t *c, xcb_window_t previous)
 {
     stack_window_above(c->frame_window, previous);
 
+    c->stack_position = ++stack_position;
+
     previous = c->frame_window;
 
     /* stack transient window on top of their parents */
@@ -171,6 +175,8 @@ stack_refresh()
 
     xcb_window_t next = XCB_NONE;
 
+    stack_position = 0;
+
     /* stack desktop windows */
     for(window_layer_t layer = WINDOW_LAYER_DESKTOP; layer < WINDOW_LAYER_BELOW; layer++)
         foreach(node, globalconf.stack)
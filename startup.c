@@ -0,0 +1,467 @@
+/*
+ * startup.c - startup profiler
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* With --profile-startup=FILE, awesome records a timeline of its startup
+ * until the end of the first main loop iteration: the phases of main(), each
+ * require() which loads a module, beautiful.init() and the first paint of
+ * drawables. Spans nest, so that the time spent in a module can be split
+ * between the module itself and the modules it requires.
+ *
+ * FILE is written in the Trace Event Format, which tools like
+ * chrome://tracing or Perfetto display, and FILE.txt gets a human summary.
+ *
+ * A Lua error may leave spans open. Each span opened from Lua remembers the
+ * depth of the Lua stack, so that the spans left behind are closed when a
+ * span at the same or a lower depth opens or closes.
+ */
+
+#include "startup.h"
+#include "common/array.h"
+#include "config.h"
+#include "xrequest.h"
+
+#include <lauxlib.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+
+typedef enum
+{
+    SPAN_PHASE,
+    SPAN_REQUIRE,
+    SPAN_MARK
+} startup_span_kind_t;
+
+static const char * const startup_span_kinds[] = { "phase", "require", "mark" };
+
+typedef struct
+{
+    char *name;
+    startup_span_kind_t kind;
+    /** Start and end time, in microseconds */
+    gint64 start, end;
+    /** Time not spent in child spans, in microseconds */
+    gint64 self;
+    /** Index of the parent span, -1 for top level spans */
+    int parent;
+    /** Nesting depth in the tree */
+    int depth;
+    /** Depth of the Lua stack when it was opened, 0 for spans from C */
+    int level;
+    /** Number of X requests sent before it opened and before it closed */
+    unsigned int requests_start, requests_end;
+    /** Was the span left open by an error? */
+    bool failed;
+} startup_span_t;
+
+static void
+startup_span_wipe(startup_span_t *span)
+{
+    p_delete(&span->name);
+}
+
+DO_ARRAY(startup_span_t, startup_span, startup_span_wipe)
+
+static struct
+{
+    /** Where to write the profile, NULL when not profiling */
+    char *path;
+    /** Start of the timeline */
+    gint64 start;
+    /** All spans, in the order they were opened */
+    startup_span_array_t spans;
+    /** The innermost open span, -1 if none */
+    int current;
+} profile = { .current = -1 };
+
+/** Record the start of the timeline.
+ * \return The start time.
+ */
+gint64
+startup_profile_init(void)
+{
+    profile.start = g_get_monotonic_time();
+    return profile.start;
+}
+
+/** Enable the startup profiler.
+ * \param path The file to write the profile to.
+ */
+void
+startup_profile_enable(const char *path)
+{
+    p_delete(&profile.path);
+    profile.path = a_strdup(path);
+    xrequest_enable(true);
+}
+
+static startup_span_t *
+startup_profile_open(const char *name, startup_span_kind_t kind, int level)
+{
+    int parent = profile.current;
+
+    startup_span_array_append(&profile.spans, (startup_span_t) {
+        .name = a_strdup(name),
+        .kind = kind,
+        .start = g_get_monotonic_time(),
+        .parent = parent,
+        .depth = parent < 0 ? 0 : profile.spans.tab[parent].depth + 1,
+        .level = level,
+        .requests_start = xrequest_count(),
+    });
+
+    return &profile.spans.tab[profile.spans.len - 1];
+}
+
+/** Close the spans left open by an error.
+ * \param level The Lua stack depth from which spans are left behind.
+ */
+static void
+startup_profile_unwind(int level)
+{
+    gint64 now = g_get_monotonic_time();
+
+    while(profile.current >= 0 && profile.spans.tab[profile.current].level >= level)
+    {
+        startup_span_t *span = &profile.spans.tab[profile.current];
+        span->end = now;
+        span->requests_end = xrequest_count();
+        span->failed = true;
+        profile.current = span->parent;
+    }
+}
+
+/** Close the innermost open span, if it was opened at the given Lua stack
+ * depth, and every span left open above it.
+ * \param level The Lua stack depth, 0 for spans opened from C.
+ */
+static void
+startup_profile_close(int level)
+{
+    startup_profile_unwind(level + 1);
+
+    if(profile.current >= 0 && profile.spans.tab[profile.current].level == level)
+    {
+        startup_span_t *span = &profile.spans.tab[profile.current];
+        span->end = g_get_monotonic_time();
+        span->requests_end = xrequest_count();
+        profile.current = span->parent;
+    }
+}
+
+static void
+startup_profile_push(const char *name, startup_span_kind_t kind, int level)
+{
+    if(!profile.path)
+        return;
+    if(level > 0)
+        startup_profile_unwind(level);
+    startup_profile_open(name, kind, level);
+    profile.current = profile.spans.len - 1;
+}
+
+/** Open a span for a startup phase.
+ * \param name The name of the phase.
+ */
+void
+startup_profile_begin(const char *name)
+{
+    startup_profile_push(name, SPAN_PHASE, 0);
+}
+
+/** Close the span of the current startup phase. */
+void
+startup_profile_end(void)
+{
+    if(profile.path)
+        startup_profile_close(0);
+}
+
+/** Add a span for a phase which already finished.
+ * \param name The name of the phase.
+ * \param start The start time of the phase, the end is now.
+ */
+void
+startup_profile_add(const char *name, gint64 start)
+{
+    if(!profile.path)
+        return;
+    startup_span_t *span = startup_profile_open(name, SPAN_PHASE, 0);
+    span->end = span->start;
+    span->start = start;
+    span->requests_end = span->requests_start;
+}
+
+/** Add an instant event to the timeline.
+ * \param fmt The name of the event, as a printf format.
+ */
+void
+startup_profile_mark(const char *fmt, ...)
+{
+    if(!profile.path)
+        return;
+
+    va_list ap;
+    va_start(ap, fmt);
+    char *name = g_strdup_vprintf(fmt, ap);
+    va_end(ap);
+
+    startup_span_t *span = startup_profile_open(name, SPAN_MARK, 0);
+    span->end = span->start;
+    span->requests_end = span->requests_start;
+    g_free(name);
+}
+
+/** Get the depth of the Lua stack.
+ * \param L The Lua VM state.
+ * \return The number of active functions.
+ */
+static int
+startup_profile_level(lua_State *L)
+{
+    lua_Debug ar;
+    int level = 0;
+
+    while(lua_getstack(L, level, &ar))
+        level++;
+    return level;
+}
+
+/** Replacement for require() which records the modules it loads.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+static int
+startup_profile_require(lua_State *L)
+{
+    bool record = false;
+    int level = 0;
+
+    if(profile.path)
+    {
+        const char *name = luaL_checkstring(L, 1);
+
+        /* Modules already loaded take no time */
+        lua_getfield(L, LUA_REGISTRYINDEX, "_LOADED");
+        if(lua_istable(L, -1))
+        {
+            lua_getfield(L, -1, name);
+            record = !lua_toboolean(L, -1);
+            lua_pop(L, 1);
+        }
+        lua_pop(L, 1);
+
+        if(record)
+        {
+            level = startup_profile_level(L);
+            startup_profile_push(name, SPAN_REQUIRE, level);
+        }
+    }
+
+    lua_pushvalue(L, lua_upvalueindex(1));
+    lua_insert(L, 1);
+    lua_call(L, lua_gettop(L) - 1, LUA_MULTRET);
+
+    if(record)
+        startup_profile_close(level);
+
+    return lua_gettop(L);
+}
+
+/** Make require() record the modules it loads, when profiling.
+ * \param L The Lua VM state.
+ */
+void
+startup_profile_setup(lua_State *L)
+{
+    if(!profile.path)
+        return;
+
+    lua_getglobal(L, "require");
+    if(!lua_isfunction(L, -1))
+    {
+        lua_pop(L, 1);
+        return;
+    }
+    lua_pushcclosure(L, startup_profile_require, 1);
+    lua_setglobal(L, "require");
+}
+
+/** Open a span from Lua.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+luaA_startup_profile_begin(lua_State *L)
+{
+    const char *name = luaL_checkstring(L, 1);
+    if(profile.path)
+        startup_profile_push(name, SPAN_PHASE, startup_profile_level(L));
+    return 0;
+}
+
+/** Close the span opened from Lua by the calling function.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+luaA_startup_profile_end(lua_State *L)
+{
+    if(profile.path)
+        startup_profile_close(startup_profile_level(L));
+    return 0;
+}
+
+static void
+startup_profile_write_string(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for(; *s; s++)
+    {
+        if(*s == '"' || *s == '\\')
+            fprintf(f, "\\%c", *s);
+        else if((unsigned char) *s < 0x20)
+            fprintf(f, "\\u%04x", (unsigned char) *s);
+        else
+            fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+/** Write the timeline in the Trace Event Format. */
+static bool
+startup_profile_write_trace(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if(!f)
+        return false;
+
+    fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    for(int i = 0; i < profile.spans.len; i++)
+    {
+        startup_span_t *span = &profile.spans.tab[i];
+
+        fprintf(f, "  {\"name\": ");
+        startup_profile_write_string(f, span->name);
+        fprintf(f, ", \"cat\": \"%s\", \"pid\": 1, \"tid\": 1, \"ts\": %" G_GINT64_FORMAT,
+                startup_span_kinds[span->kind], span->start - profile.start);
+        if(span->kind == SPAN_MARK)
+            fprintf(f, ", \"ph\": \"i\", \"s\": \"g\"}");
+        else
+        {
+            fprintf(f, ", \"ph\": \"X\", \"dur\": %" G_GINT64_FORMAT
+                    ", \"args\": {\"self\": %" G_GINT64_FORMAT ", \"depth\": %d",
+                    span->end - span->start, span->self, span->depth);
+#ifdef WITH_XCB_INTERPOSER
+            /* X requests are only counted with the interposer */
+            fprintf(f, ", \"x_requests\": %u", span->requests_end - span->requests_start);
+#endif
+            fprintf(f, "%s}}", span->failed ? ", \"failed\": true" : "");
+        }
+        fprintf(f, "%s\n", i + 1 < profile.spans.len ? "," : "");
+    }
+    fprintf(f, "]}\n");
+
+    return fclose(f) == 0;
+}
+
+static int
+startup_profile_cmp_self(const void *a, const void *b)
+{
+    const startup_span_t *sa = *(startup_span_t * const *) a;
+    const startup_span_t *sb = *(startup_span_t * const *) b;
+    return (sa->self < sb->self) - (sa->self > sb->self);
+}
+
+/** Write a human readable summary of the timeline. */
+static bool
+startup_profile_write_summary(const char *path, gint64 total)
+{
+    FILE *f = fopen(path, "w");
+    if(!f)
+        return false;
+
+    fprintf(f, "Startup took %.2f ms until the end of the first main loop iteration.\n",
+            total / 1000.0);
+#ifdef WITH_XCB_INTERPOSER
+    fprintf(f, "%u X requests were sent.\n", xrequest_count());
+#endif
+    fprintf(f, "\n");
+    fprintf(f, "   total ms     self ms\n");
+
+    foreach(span, profile.spans)
+        if(span->kind == SPAN_MARK)
+            fprintf(f, "%11s @%9.2f  %*s%s\n", "", (span->start - profile.start) / 1000.0,
+                    2 * span->depth, "", span->name);
+        else
+            fprintf(f, "%11.2f %11.2f  %*s%s%s%s\n",
+                    (span->end - span->start) / 1000.0, span->self / 1000.0,
+                    2 * span->depth, "",
+                    span->kind == SPAN_REQUIRE ? "require " : "", span->name,
+                    span->failed ? " (failed)" : "");
+
+    /* The modules worth looking at first */
+    const startup_span_t **requires = p_new(const startup_span_t *, profile.spans.len);
+    int count = 0;
+    foreach(span, profile.spans)
+        if(span->kind == SPAN_REQUIRE)
+            requires[count++] = span;
+    qsort(requires, count, sizeof(*requires), startup_profile_cmp_self);
+
+    fprintf(f, "\nSlowest modules by self time:\n");
+    for(int i = 0; i < count && i < 15; i++)
+        fprintf(f, "%11.2f  %s\n", requires[i]->self / 1000.0, requires[i]->name);
+    p_delete(&requires);
+
+    return fclose(f) == 0;
+}
+
+/** Write the profile at the end of the startup, and stop profiling. */
+void
+startup_profile_finish(void)
+{
+    if(!profile.path)
+        return;
+
+    gint64 total = g_get_monotonic_time() - profile.start;
+
+    while(profile.current >= 0)
+        startup_profile_close(0);
+
+    /* The self time of a span is its duration minus the one of its children */
+    foreach(span, profile.spans)
+        span->self = span->end - span->start;
+    foreach(span, profile.spans)
+        if(span->parent >= 0 && span->kind != SPAN_MARK)
+            profile.spans.tab[span->parent].self -= span->end - span->start;
+
+    char *summary = g_strdup_printf("%s.txt", profile.path);
+    if(!startup_profile_write_trace(profile.path))
+        warn("cannot write the startup profile to %s", profile.path);
+    if(!startup_profile_write_summary(summary, total))
+        warn("cannot write the startup profile summary to %s", summary);
+    g_free(summary);
+
+    startup_span_array_wipe(&profile.spans);
+    p_delete(&profile.path);
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,42 @@
+/*
+ * startup.h - startup profiler header
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_STARTUP_H
+#define AWESOME_STARTUP_H
+
+#include <glib.h>
+#include <lua.h>
+
+gint64 startup_profile_init(void);
+void startup_profile_enable(const char *);
+void startup_profile_begin(const char *);
+void startup_profile_end(void);
+void startup_profile_add(const char *, gint64);
+void startup_profile_mark(const char *, ...)
+    __attribute__ ((format(printf, 1, 2)));
+void startup_profile_setup(lua_State *);
+void startup_profile_finish(void);
+
+int luaA_startup_profile_begin(lua_State *);
+int luaA_startup_profile_end(lua_State *);
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
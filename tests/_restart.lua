@@ -0,0 +1,101 @@
+--- Helpers for tests which continue in a new awesome process.
+--
+-- `restart.exec` replaces awesome with a new process which runs the given
+-- test file again once it loaded the configuration. The arguments and the
+-- configuration of the new process are kept by `awesome.restart`, so a test
+-- can go through several processes. Each process finds out where the test is
+-- with `restart.get_phase`.
+
+local restart = {}
+
+local xproperty = "_test_restart"
+local header = "-- Written by _restart.lua\n"
+
+awesome.register_xproperty(xproperty, "string")
+
+-- Get the arguments of the running awesome process.
+local function get_arguments()
+    local f = assert(io.open("/proc/self/cmdline", "rb"))
+    local cmdline = f:read("*all")
+    f:close()
+
+    local ret = {}
+    for arg in cmdline:gmatch("([^%z]*)%z") do
+        table.insert(ret, arg)
+    end
+    return ret
+end
+
+local function quote(s)
+    return "'" .. (s:gsub("'", "'\\''")) .. "'"
+end
+
+--- Get the phase of a test, as set by a previous process.
+-- @tparam string name The name of the test.
+-- @treturn string|nil The phase.
+function restart.get_phase(name)
+    local value = awesome.get_xproperty(xproperty)
+    if not value then return nil end
+
+    local test, phase = value:match("^([^\n]*)\n(.*)$")
+    if test == name then
+        return phase
+    end
+end
+
+--- Set the phase of a test, for the next process.
+-- @tparam string name The name of the test.
+-- @tparam string|nil phase The phase, nil once the test is done.
+function restart.set_phase(name, phase)
+    awesome.set_xproperty(xproperty, phase and (name .. "\n" .. phase) or nil)
+end
+
+--- Replace awesome with a new process which runs a test file after its
+-- configuration.
+-- @tparam string file The test file.
+-- @tparam[opt={}] table args Additional arguments for the new process.
+function restart.exec(file, args)
+    local argv = get_arguments()
+    local rc_file = os.tmpname()
+
+    local found = false
+    for i = 1, #argv - 1 do
+        if argv[i] == "-c" or argv[i] == "--config" then
+            local f = assert(io.open(rc_file, "w"))
+            f:write(header)
+            f:write(string.format("dofile(%q)\ndofile(%q)\n", argv[i + 1], file))
+            f:close()
+            argv[i + 1] = rc_file
+            found = true
+            break
+        end
+    end
+    assert(found, "awesome was started without a configuration file")
+
+    for _, arg in ipairs(args or {}) do
+        table.insert(argv, arg)
+    end
+
+    local cmd = {}
+    for i, arg in ipairs(argv) do
+        cmd[i] = quote(arg)
+    end
+
+    awesome.exec("exec " .. table.concat(cmd, " "))
+end
+
+--- Remove the configuration file written by `restart.exec`.
+function restart.cleanup()
+    local f = io.open(awesome.conffile)
+    if not f then return end
+
+    local first = f:read("*line")
+    f:close()
+    if (first or "") .. "\n" == header then
+        os.remove(awesome.conffile)
+    end
+end
+
+return restart
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,621 @@
+/*
+ * Microbenchmarks for the C core primitives.
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * This program times the primitives that awesome runs all the time, so that
+ * changes to the data structures behind them can be compared before they
+ * land:
+ *
+ *   ./bench-core -j > before.json
+ *   ./bench-core -j > after.json
+ *
+ * Each benchmark is first run for some warmup samples, which also pick how
+ * many operations a sample does so that it lasts long enough to be timed.
+ * Then the time per operation of each sample is recorded, and its
+ * percentiles are printed. Arguments select the benchmarks whose name
+ * contains one of them.
+ */
+
+#include "globalconf.h"
+#include "draw.h"
+#include "common/atoms.h"
+#include "common/luaobject.h"
+#include "common/xutil.h"
+
+#include <lualib.h>
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* These are defined by awesome.c and luaa.c, which are not linked in */
+awesome_t globalconf;
+signal_hashmap_t global_signals;
+
+/** The shortest duration of a sample, in nanoseconds */
+#define SAMPLE_MIN_NS 20000
+
+#define NAMES_COUNT 40
+
+/* Property names of a client, which is the class with the most properties */
+static const char *names[NAMES_COUNT] = {
+    "above", "below", "border_color", "border_width", "class", "client_shape_bounding",
+    "client_shape_clip", "content", "focusable", "fullscreen", "group_window",
+    "height", "hidden", "icon", "icon_name", "icon_sizes", "instance", "leader_window",
+    "machine", "maximized", "maximized_horizontal", "maximized_vertical",
+    "minimized", "modal", "motif_wm_hints", "name", "ontop", "opacity", "pid",
+    "role", "screen", "shape_bounding", "shape_clip", "size_hints",
+    "skip_taskbar", "startup_id", "sticky", "transient_for", "type", "urgent",
+};
+
+typedef struct
+{
+    LUA_OBJECT_HEADER
+    int value;
+} bench_object_t;
+
+static lua_class_t bench_class;
+LUA_OBJECT_FUNCS(bench_class, bench_object_t, bench_object)
+
+static lua_State *L;
+static signal_hashmap_t signals;
+static const void *refs[1024];
+static uint32_t icon16[16 * 16], icon64[64 * 64];
+static struct
+{
+    xcb_get_property_reply_t reply;
+    char value[64];
+} property;
+
+/* Results go there so that the compiler cannot drop the benchmarked code */
+static volatile uintptr_t sink;
+
+static int
+bench_object_get_value(lua_State *state, bench_object_t *object)
+{
+    lua_pushinteger(state, object->value);
+    return 1;
+}
+
+static void
+setup_lua(void)
+{
+    L = luaL_newstate();
+    luaL_openlibs(L);
+    luaA_object_setup(L);
+}
+
+static void
+teardown_lua(void)
+{
+    lua_close(L);
+    L = NULL;
+}
+
+static void
+setup_signals(void)
+{
+    for(int i = 0; i < NAMES_COUNT; i++)
+        signal_connect(&signals, names[i], &names[i]);
+}
+
+static void
+teardown_signals(void)
+{
+    signal_hashmap_wipe(&signals);
+}
+
+/* The ordered array signals were kept in, to compare the hash map with */
+DO_BARRAY(signal_t, bsignal, signal_wipe, signal_cmp)
+
+/** The number of signal ids of the large containers */
+#define IDS_COUNT 1024
+
+static unsigned long ids[IDS_COUNT];
+static bsignal_array_t bsignals;
+
+static void
+setup_ids(void)
+{
+    char name[32];
+
+    for(int i = 0; i < IDS_COUNT; i++)
+    {
+        snprintf(name, sizeof(name), "property::name%d", i);
+        ids[i] = a_strhash((const unsigned char *) name);
+    }
+}
+
+static void
+setup_bsignals(void)
+{
+    for(int i = 0; i < NAMES_COUNT; i++)
+    {
+        signal_t sig = { .id = a_strhash((const unsigned char *) names[i]) };
+        bsignal_array_insert(&bsignals, sig);
+    }
+}
+
+static void
+teardown_bsignals(void)
+{
+    bsignal_array_wipe(&bsignals);
+}
+
+static void
+run_barray_lookup(unsigned int n)
+{
+    for(unsigned int i = 0; i < n; i++)
+    {
+        signal_t sig = { .id = a_strhash((const unsigned char *) names[i % NAMES_COUNT]) };
+        sink += (uintptr_t) bsignal_array_lookup(&bsignals, &sig);
+    }
+}
+
+static void
+run_hashmap_lookup(unsigned int n)
+{
+    for(unsigned int i = 0; i < n; i++)
+        sink += (uintptr_t) signal_hashmap_getbyname(&signals, names[i % NAMES_COUNT]);
+}
+
+/* Fill containers of count signals, such as the one of a client, insert
+ * being the slow operation of ordered arrays */
+static void
+barray_fill(unsigned int n, int count)
+{
+    bsignal_array_t arr;
+
+    for(unsigned int done = 0; done < n; done += count)
+    {
+        bsignal_array_init(&arr);
+        for(int i = 0; i < count; i++)
+        {
+            signal_t sig = { .id = ids[i] };
+            bsignal_array_insert(&arr, sig);
+        }
+        bsignal_array_wipe(&arr);
+    }
+}
+
+static void
+hashmap_fill(unsigned int n, int count)
+{
+    signal_hashmap_t map;
+
+    for(unsigned int done = 0; done < n; done += count)
+    {
+        signal_hashmap_init(&map);
+        for(int i = 0; i < count; i++)
+        {
+            signal_t sig = { .id = ids[i] };
+            signal_hashmap_insert(&map, sig);
+        }
+        signal_hashmap_wipe(&map);
+    }
+}
+
+static void
+run_barray_insert(unsigned int n)
+{
+    barray_fill(n, NAMES_COUNT);
+}
+
+static void
+run_hashmap_insert(unsigned int n)
+{
+    hashmap_fill(n, NAMES_COUNT);
+}
+
+static void
+run_barray_insert_large(unsigned int n)
+{
+    barray_fill(n, IDS_COUNT);
+}
+
+static void
+run_hashmap_insert_large(unsigned int n)
+{
+    hashmap_fill(n, IDS_COUNT);
+}
+
+static void
+run_signal_connect(unsigned int n)
+{
+    for(unsigned int i = 0; i < n; i++)
+    {
+        const char *name = names[i % NAMES_COUNT];
+        signal_connect(&signals, name, &sink);
+        signal_disconnect(&signals, name, &sink);
+    }
+}
+
+static void
+setup_signal_emit(void)
+{
+    setup_lua();
+    for(int i = 0; i < 4; i++)
+    {
+        luaL_dostring(L, "return function(o) return o end");
+        signal_connect(&signals, "property::name", luaA_object_ref(L, -1));
+    }
+}
+
+static void
+teardown_signal_emit(void)
+{
+    teardown_signals();
+    teardown_lua();
+}
+
+static void
+run_signal_emit(unsigned int n)
+{
+    for(unsigned int i = 0; i < n; i++)
+    {
+        lua_pushinteger(L, i);
+        signal_object_emit(L, &signals, "property::name", 1);
+    }
+}
+
+static void
+setup_signal_churn(void)
+{
+    setup_signal_emit();
+    luaL_dostring(L, "return function() end");
+}
+
+static void
+run_signal_churn(unsigned int n)
+{
+    for(unsigned int i = 0; i < n; i++)
+    {
+        const char *name = names[i % NAMES_COUNT];
+        lua_pushvalue(L, -1);
+        const void *ref = luaA_object_ref(L, -1);
+        signal_connect(&signals, name, ref);
+        signal_object_emit(L, &signals, name, 0);
+        signal_disconnect(&signals, name, ref);
+        luaA_object_unref(L, ref);
+    }
+}
+
+static void
+setup_class_index(void)
+{
+    static const struct luaL_Reg methods[] =
+    {
+        { NULL, NULL }
+    };
+    static const struct luaL_Reg meta[] =
+    {
+        LUA_OBJECT_META(bench_object)
+        LUA_CLASS_META
+        { NULL, NULL }
+    };
+
+    setup_lua();
+    luaA_class_setup(L, &bench_class, "bench_object", NULL,
+                     (lua_class_allocator_t) bench_object_new, NULL, NULL,
+                     NULL, NULL, methods, meta);
+    for(int i = 0; i < NAMES_COUNT; i++)
+        luaA_class_add_property(&bench_class, names[i], NULL,
+                                (lua_class_propfunc_t) bench_object_get_value,
+                                NULL);
+    bench_object_new(L);
+}
+
+static void
+run_class_index(unsigned int n)
+{
+    for(unsigned int i = 0; i < n; i++)
+    {
+        lua_getfield(L, 1, names[i % NAMES_COUNT]);
+        lua_pop(L, 1);
+    }
+}
+
+static void
+setup_table_index(void)
+{
+    setup_lua();
+    lua_createtable(L, 0, NAMES_COUNT);
+    for(int i = 0; i < NAMES_COUNT; i++)
+    {
+        lua_pushinteger(L, i);
+        lua_setfield(L, -2, names[i]);
+    }
+}
+
+static void
+run_table_index(unsigned int n)
+{
+    for(unsigned int i = 0; i < n; i++)
+    {
+        lua_getfield(L, 1, names[i % NAMES_COUNT]);
+        lua_pop(L, 1);
+    }
+}
+
+static void
+teardown_class_index(void)
+{
+    teardown_lua();
+    p_delete(&bench_class.properties.tab);
+    p_clear(&bench_class.properties, 1);
+}
+
+static void
+setup_object_push(void)
+{
+    setup_lua();
+    for(int i = 0; i < countof(refs); i++)
+    {
+        lua_newtable(L);
+        refs[i] = luaA_object_ref(L, -1);
+    }
+}
+
+static void
+run_object_push(unsigned int n)
+{
+    for(unsigned int i = 0; i < n; i++)
+    {
+        luaA_object_push(L, refs[i % countof(refs)]);
+        lua_pop(L, 1);
+    }
+}
+
+static void
+run_strhash(unsigned int n)
+{
+    for(unsigned int i = 0; i < n; i++)
+        sink += a_strhash((const unsigned char *) names[i % NAMES_COUNT]);
+}
+
+static void
+setup_icons(void)
+{
+    for(int i = 0; i < countof(icon64); i++)
+        icon64[i] = (i * 2654435761u) | 0x80000000u;
+    memcpy(icon16, icon64, sizeof(icon16));
+}
+
+static void
+run_surface_from_data16(unsigned int n)
+{
+    for(unsigned int i = 0; i < n; i++)
+        cairo_surface_destroy(draw_surface_from_data(16, 16, icon16));
+}
+
+static void
+run_surface_from_data64(unsigned int n)
+{
+    for(unsigned int i = 0; i < n; i++)
+        cairo_surface_destroy(draw_surface_from_data(64, 64, icon64));
+}
+
+static void
+setup_text_property(void)
+{
+    /* The value of a property follows its reply */
+    const char title[] = "awesome - ~/src/awesome/common/xutil.h";
+
+    property.reply.type = XCB_ATOM_STRING;
+    property.reply.format = 8;
+    property.reply.value_len = sizeof(title) - 1;
+    memcpy(property.value, title, sizeof(title) - 1);
+}
+
+static void
+run_text_property(unsigned int n)
+{
+    for(unsigned int i = 0; i < n; i++)
+    {
+        char *text = xutil_get_text_property_from_reply(&property.reply);
+        sink += (uintptr_t) text;
+        p_delete(&text);
+    }
+}
+
+typedef struct
+{
+    const char *name;
+    void (*setup)(void);
+    /** Run the given number of operations */
+    void (*run)(unsigned int);
+    void (*teardown)(void);
+} benchmark_t;
+
+static const benchmark_t benchmarks[] =
+{
+    { "barray_lookup", setup_bsignals, run_barray_lookup, teardown_bsignals },
+    { "hashmap_lookup", setup_signals, run_hashmap_lookup, teardown_signals },
+    { "barray_insert", setup_ids, run_barray_insert, NULL },
+    { "hashmap_insert", setup_ids, run_hashmap_insert, NULL },
+    { "barray_insert_1024", setup_ids, run_barray_insert_large, NULL },
+    { "hashmap_insert_1024", setup_ids, run_hashmap_insert_large, NULL },
+    { "signal_connect_disconnect", setup_signals, run_signal_connect, teardown_signals },
+    { "signal_object_emit", setup_signal_emit, run_signal_emit, teardown_signal_emit },
+    { "signal_churn", setup_signal_churn, run_signal_churn, teardown_signal_emit },
+    { "luaA_class_index", setup_class_index, run_class_index, teardown_class_index },
+    { "lua_table_index", setup_table_index, run_table_index, teardown_lua },
+    { "luaA_object_push", setup_object_push, run_object_push, teardown_lua },
+    { "a_strhash", NULL, run_strhash, NULL },
+    { "draw_surface_from_data_16x16", setup_icons, run_surface_from_data16, NULL },
+    { "draw_surface_from_data_64x64", setup_icons, run_surface_from_data64, NULL },
+    { "xutil_get_text_property_from_reply", setup_text_property, run_text_property, NULL },
+};
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+static int
+compare_double(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+    return x > y ? 1 : (x < y ? -1 : 0);
+}
+
+static double
+percentile(const double *sorted, int count, double p)
+{
+    int i = count * p;
+    return sorted[i < count ? i : count - 1];
+}
+
+/** Time a benchmark.
+ * \param bench The benchmark.
+ * \param warmup The number of warmup samples.
+ * \param samples Where to store the time per operation of each sample.
+ * \param count The number of samples.
+ * \return The number of operations in a sample.
+ */
+static unsigned int
+bench_run(const benchmark_t *bench, int warmup, double *samples, int count)
+{
+    unsigned int batch = 1;
+
+    if(bench->setup)
+        bench->setup();
+
+    /* Warm the caches up and find a batch long enough to be timed */
+    for(int i = 0; i < warmup; i++)
+    {
+        uint64_t start = now_ns();
+        bench->run(batch);
+        if(now_ns() - start < SAMPLE_MIN_NS && batch < (1u << 24))
+            batch *= 2;
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        uint64_t start = now_ns();
+        bench->run(batch);
+        samples[i] = (double) (now_ns() - start) / batch;
+    }
+
+    if(bench->teardown)
+        bench->teardown();
+
+    return batch;
+}
+
+static bool
+bench_selected(const benchmark_t *bench, int argc, char **argv)
+{
+    if(optind >= argc)
+        return true;
+    for(int i = optind; i < argc; i++)
+        if(strstr(bench->name, argv[i]))
+            return true;
+    return false;
+}
+
+int
+main(int argc, char **argv)
+{
+    bool json = false;
+    int warmup = 100, count = 1000;
+    int opt;
+
+    while((opt = getopt(argc, argv, "jw:n:h")) != -1)
+        switch(opt)
+        {
+          case 'j':
+            json = true;
+            break;
+          case 'w':
+            warmup = atoi(optarg);
+            break;
+          case 'n':
+            count = atoi(optarg);
+            break;
+          default:
+            fprintf(opt == 'h' ? stdout : stderr,
+                    "Usage: %s [-j] [-w WARMUP] [-n SAMPLES] [BENCHMARK...]\n",
+                    argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+    if(count < 1 || warmup < 0)
+    {
+        fprintf(stderr, "There must be at least one sample\n");
+        return EXIT_FAILURE;
+    }
+
+    double *samples = p_new(double, count);
+    bool first = true;
+
+    if(json)
+        printf("{\"warmup\":%d,\"samples\":%d,\"benchmarks\":[", warmup, count);
+    else
+        printf("%-36s %10s %10s %10s %10s %10s  (ns/op)\n",
+               "benchmark", "min", "p50", "p90", "p99", "max");
+
+    for(int i = 0; i < countof(benchmarks); i++)
+    {
+        const benchmark_t *bench = &benchmarks[i];
+
+        if(!bench_selected(bench, argc, argv))
+            continue;
+
+        unsigned int batch = bench_run(bench, warmup, samples, count);
+        double mean = 0;
+        for(int j = 0; j < count; j++)
+            mean += samples[j] / count;
+        qsort(samples, count, sizeof(*samples), compare_double);
+
+        if(json)
+            printf("%s\n{\"name\":\"%s\",\"batch\":%u,\"ns_per_op\":{"
+                   "\"min\":%.3f,\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,"
+                   "\"max\":%.3f,\"mean\":%.3f}}",
+                   first ? "" : ",", bench->name, batch, samples[0],
+                   percentile(samples, count, 0.5),
+                   percentile(samples, count, 0.9),
+                   percentile(samples, count, 0.99),
+                   samples[count - 1], mean);
+        else
+            printf("%-36s %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                   bench->name, samples[0],
+                   percentile(samples, count, 0.5),
+                   percentile(samples, count, 0.9),
+                   percentile(samples, count, 0.99),
+                   samples[count - 1]);
+        first = false;
+    }
+
+    if(json)
+        printf("\n]}\n");
+
+    p_delete(&samples);
+
+    return EXIT_SUCCESS;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,152 @@
+/*
+ * A soak benchmark for the Lua allocators.
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * This program runs a workload looking like what a long running session does
+ * to the Lua heap: small tables, closures and strings with mixed lifetimes,
+ * and from time to time a burst of larger objects. After each round, it
+ * prints the resident set size of the process and the size of the Lua heap,
+ * so that the growth over time of both allocators can be compared:
+ *
+ *   ./bench-lua-alloc system 200 > system.txt
+ *   ./bench-lua-alloc pool 200 > pool.txt
+ */
+
+#include "luaalloc.h"
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+static const char workload[] =
+"local round = ...\n"
+"keep = keep or {}\n"
+"local keep = keep\n"
+"local slots = 20000\n"
+"for i = 1, 50000 do\n"
+"    local slot = (i * 7919 + round * 104729) % slots + 1\n"
+"    local kind = (i + round) % 5\n"
+"    if kind == 0 then\n"
+"        keep[slot] = { x = i, y = round, width = i % 300, height = 20 }\n"
+"    elseif kind == 1 then\n"
+"        local n = i\n"
+"        keep[slot] = function() return n + round end\n"
+"    elseif kind == 2 then\n"
+"        keep[slot] = 'client ' .. i .. ' on tag ' .. round\n"
+"    elseif kind == 3 then\n"
+"        keep[slot] = { i, i + 1, i + 2, { name = tostring(i) } }\n"
+"    else\n"
+"        local t = {}\n"
+"        for j = 1, 8 do t[j] = j * i end\n"
+"        keep[slot] = nil\n"
+"    end\n"
+"end\n"
+"if round % 10 == 0 then\n"
+"    local burst = {}\n"
+"    for i = 1, 200 do burst[i] = string.rep('x', 1000 + i * 10) end\n"
+"    keep.burst = burst\n"
+"end\n";
+
+/** Get the resident set size of this process, in kilobytes */
+static long
+rss_kb(void)
+{
+    long size, resident;
+    FILE *f = fopen("/proc/self/statm", "r");
+
+    if(!f)
+        return -1;
+    if(fscanf(f, "%ld %ld", &size, &resident) != 2)
+        resident = -1;
+    fclose(f);
+
+    return resident < 0 ? -1 : resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+int
+main(int argc, char **argv)
+{
+    luaA_pool_t *pool = NULL;
+    lua_State *L;
+    int rounds = 100;
+
+    if(argc < 2 || (strcmp(argv[1], "pool") && strcmp(argv[1], "system")))
+    {
+        fprintf(stderr, "Usage: %s pool|system [rounds]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if(argc > 2)
+        rounds = atoi(argv[2]);
+
+    if(!strcmp(argv[1], "pool"))
+    {
+        pool = luaA_pool_new();
+        L = lua_newstate(luaA_pool_alloc, pool);
+    }
+    else
+        L = luaL_newstate();
+
+    if(!L)
+    {
+        fprintf(stderr, "Cannot create the Lua state\n");
+        return EXIT_FAILURE;
+    }
+
+    luaL_openlibs(L);
+    if(luaL_loadstring(L, workload))
+    {
+        fprintf(stderr, "%s\n", lua_tostring(L, -1));
+        return EXIT_FAILURE;
+    }
+
+    printf("# allocator=%s\n# round rss_kb heap_kb seconds\n", argv[1]);
+
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for(int round = 1; round <= rounds; round++)
+    {
+        lua_pushvalue(L, -1);
+        lua_pushinteger(L, round);
+        if(lua_pcall(L, 1, 0, 0))
+        {
+            fprintf(stderr, "%s\n", lua_tostring(L, -1));
+            return EXIT_FAILURE;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        printf("%d %ld %d %.3f\n", round, rss_kb(), lua_gc(L, LUA_GCCOUNT, 0),
+               (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9);
+    }
+
+    lua_close(L);
+    luaA_pool_delete(&pool);
+
+    return EXIT_SUCCESS;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
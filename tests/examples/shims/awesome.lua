@@ -61,9 +61,19 @@ awesome._forward_class = forward_class
 -- Avoid c.screen = acreen.focused() to be called, all tests will fail
 awesome.startup = true
 
+local xproperties = {}
+
 function awesome.register_xproperty()
 end
 
+function awesome.set_xproperty(name, value)
+    xproperties[name] = value
+end
+
+function awesome.get_xproperty(name)
+    return xproperties[name]
+end
+
 function awesome.xkb_get_group_names()
     return "pc+us+inet(evdev)"
 end
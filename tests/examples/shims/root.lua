@@ -171,7 +171,7 @@ function root._write_string(string, c)
     end
 end
 
-function root._wallpaper(pattern)
+function root._wallpaper(pattern, x, y, width, height)
     if not pattern then return root._wallpaper_surface end
 
     -- Make a copy because `:finish()` is called by `root.wallpaper` to avoid
@@ -179,8 +179,20 @@ function root._wallpaper(pattern)
     local target = cairo.ImageSurface(cairo.Format.RGB32, root.size())
     local cr     = cairo.Context(target)
 
+    -- Only an area is repainted, keep the rest.
+    if x and root._wallpaper_surface then
+        cr:set_source_surface(root._wallpaper_surface)
+        cr:paint()
+    end
+
+    if x then
+        cr:translate(x, y)
+    else
+        width, height = root.size()
+    end
+
     cr:set_source(pattern)
-    cr:rectangle(0, 0, root.size())
+    cr:rectangle(0, 0, width, height)
     cr:fill()
 
     root._wallpaper_pattern = cairo.Pattern.create_for_surface(target)
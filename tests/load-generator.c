@@ -0,0 +1,353 @@
+/*
+ * A synthetic X client load generator.
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <xcb/xcb.h>
+#include <xcb/xcb_aux.h>
+#include <xcb/xcb_icccm.h>
+#include <getopt.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * This program maps N windows and, once the window manager mapped all of
+ * them, changes random windows at the given rates:
+ * - the title (_NET_WM_NAME and WM_NAME), which ends with the time it was set
+ *   at, in microseconds of CLOCK_MONOTONIC,
+ * - the icon (_NET_WM_ICON),
+ * - the urgency hint (WM_HINTS),
+ * - the size hints (WM_NORMAL_HINTS),
+ * - the geometry, with a ConfigureWindow request.
+ *
+ * It prints "READY <n>" once all windows are mapped, then "DONE <changes>"
+ * after the given duration, and exits.
+ */
+
+#define ICON_SIZE 16
+
+enum change {
+    CHANGE_TITLE,
+    CHANGE_ICON,
+    CHANGE_URGENCY,
+    CHANGE_HINTS,
+    CHANGE_GEOMETRY,
+    CHANGE_COUNT
+};
+
+static const char *change_names[CHANGE_COUNT] = {
+    [CHANGE_TITLE] = "title",
+    [CHANGE_ICON] = "icon",
+    [CHANGE_URGENCY] = "urgency",
+    [CHANGE_HINTS] = "hints",
+    [CHANGE_GEOMETRY] = "geometry",
+};
+
+struct window {
+    xcb_window_t id;
+    bool mapped;
+    bool urgent;
+};
+
+static xcb_connection_t *c;
+static xcb_screen_t *screen;
+static xcb_atom_t net_wm_name, net_wm_icon, utf8_string;
+static struct window *windows;
+static int window_count;
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * INT64_C(1000000) + ts.tv_nsec / 1000;
+}
+
+static xcb_atom_t intern(const char *name)
+{
+    xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(c,
+            xcb_intern_atom(c, false, strlen(name), name), NULL);
+    xcb_atom_t atom = reply ? reply->atom : XCB_NONE;
+    free(reply);
+    return atom;
+}
+
+static void set_title(struct window *w, int index)
+{
+    char title[64];
+    int len = snprintf(title, sizeof(title), "load-generator %d %lld",
+            index, (long long) now_us());
+
+    xcb_change_property(c, XCB_PROP_MODE_REPLACE, w->id, net_wm_name,
+            utf8_string, 8, len, title);
+    xcb_change_property(c, XCB_PROP_MODE_REPLACE, w->id, XCB_ATOM_WM_NAME,
+            XCB_ATOM_STRING, 8, len, title);
+}
+
+static void set_icon(struct window *w)
+{
+    uint32_t data[2 + ICON_SIZE * ICON_SIZE];
+    uint32_t color = 0xff000000 | (rand() & 0xffffff);
+
+    data[0] = ICON_SIZE;
+    data[1] = ICON_SIZE;
+    for (int i = 0; i < ICON_SIZE * ICON_SIZE; i++)
+        data[2 + i] = color;
+
+    xcb_change_property(c, XCB_PROP_MODE_REPLACE, w->id, net_wm_icon,
+            XCB_ATOM_CARDINAL, 32, sizeof(data) / sizeof(data[0]), data);
+}
+
+static void set_urgency(struct window *w)
+{
+    xcb_icccm_wm_hints_t hints;
+
+    memset(&hints, 0, sizeof(hints));
+    xcb_icccm_wm_hints_set_input(&hints, true);
+    w->urgent = !w->urgent;
+    if (w->urgent)
+        xcb_icccm_wm_hints_set_urgency(&hints);
+    xcb_icccm_set_wm_hints(c, w->id, &hints);
+}
+
+static void set_size_hints(struct window *w)
+{
+    xcb_size_hints_t hints;
+
+    memset(&hints, 0, sizeof(hints));
+    xcb_icccm_size_hints_set_min_size(&hints, 10 + rand() % 20, 10 + rand() % 20);
+    xcb_icccm_size_hints_set_resize_inc(&hints, 1 + rand() % 3, 1 + rand() % 3);
+    xcb_icccm_set_wm_normal_hints(c, w->id, &hints);
+}
+
+static void request_geometry(struct window *w)
+{
+    uint32_t values[] = {
+        rand() % (screen->width_in_pixels / 2),
+        rand() % (screen->height_in_pixels / 2),
+        50 + rand() % 200,
+        50 + rand() % 200,
+    };
+
+    xcb_configure_window(c, w->id,
+            XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y |
+            XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, values);
+}
+
+static void do_change(enum change change)
+{
+    int index = rand() % window_count;
+    struct window *w = &windows[index];
+
+    switch (change)
+    {
+    case CHANGE_TITLE:
+        set_title(w, index);
+        break;
+    case CHANGE_ICON:
+        set_icon(w);
+        break;
+    case CHANGE_URGENCY:
+        set_urgency(w);
+        break;
+    case CHANGE_HINTS:
+        set_size_hints(w);
+        break;
+    case CHANGE_GEOMETRY:
+        request_geometry(w);
+        break;
+    case CHANGE_COUNT:
+        break;
+    }
+}
+
+static void create_windows(void)
+{
+    static const char class[] = "load-generator\0load-generator";
+    uint32_t mask = XCB_CW_EVENT_MASK;
+    uint32_t values[] = { XCB_EVENT_MASK_STRUCTURE_NOTIFY };
+
+    for (int i = 0; i < window_count; i++)
+    {
+        struct window *w = &windows[i];
+
+        w->id = xcb_generate_id(c);
+        xcb_create_window(c, XCB_COPY_FROM_PARENT, w->id, screen->root,
+                0, 0, 100, 100, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                XCB_COPY_FROM_PARENT, mask, values);
+        xcb_icccm_set_wm_class(c, w->id, sizeof(class), class);
+        set_title(w, i);
+        xcb_map_window(c, w->id);
+    }
+    xcb_flush(c);
+}
+
+/* Returns the number of windows which got mapped */
+static int handle_events(void)
+{
+    xcb_generic_event_t *event;
+    int mapped = 0;
+
+    while ((event = xcb_poll_for_event(c)))
+    {
+        if ((event->response_type & 0x7f) == XCB_MAP_NOTIFY)
+        {
+            xcb_map_notify_event_t *ev = (xcb_map_notify_event_t *) event;
+            for (int i = 0; i < window_count; i++)
+                if (windows[i].id == ev->window && !windows[i].mapped)
+                {
+                    windows[i].mapped = true;
+                    mapped++;
+                }
+        }
+        free(event);
+    }
+
+    if (xcb_connection_has_error(c))
+    {
+        fprintf(stderr, "ERROR: X connection broke\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return mapped;
+}
+
+static void wait_for_input(int timeout_ms)
+{
+    struct pollfd pfd = { .fd = xcb_get_file_descriptor(c), .events = POLLIN };
+    poll(&pfd, 1, timeout_ms);
+}
+
+static void usage(const char *name, int code)
+{
+    fprintf(code ? stderr : stdout,
+            "Usage: %s [-n WINDOWS] [-d SECONDS] [-s SEED] [-t RATE] [-i RATE]\n"
+            "          [-u RATE] [-H RATE] [-g RATE]\n"
+            "Rates are changes per second, of the title (-t), icon (-i),\n"
+            "urgency (-u), size hints (-H) and geometry (-g).\n", name);
+    exit(code);
+}
+
+int main(int argc, char **argv)
+{
+    double rates[CHANGE_COUNT] = { 0 };
+    double duration = 5;
+    int64_t next[CHANGE_COUNT];
+    unsigned long changes[CHANGE_COUNT] = { 0 };
+    int opt;
+
+    window_count = 10;
+    srand(1);
+
+    while ((opt = getopt(argc, argv, "n:d:s:t:i:u:H:g:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n': window_count = atoi(optarg); break;
+        case 'd': duration = atof(optarg); break;
+        case 's': srand(atoi(optarg)); break;
+        case 't': rates[CHANGE_TITLE] = atof(optarg); break;
+        case 'i': rates[CHANGE_ICON] = atof(optarg); break;
+        case 'u': rates[CHANGE_URGENCY] = atof(optarg); break;
+        case 'H': rates[CHANGE_HINTS] = atof(optarg); break;
+        case 'g': rates[CHANGE_GEOMETRY] = atof(optarg); break;
+        case 'h': usage(argv[0], EXIT_SUCCESS); break;
+        default: usage(argv[0], EXIT_FAILURE); break;
+        }
+    }
+    if (window_count <= 0)
+        usage(argv[0], EXIT_FAILURE);
+
+    int screen_number;
+    c = xcb_connect(NULL, &screen_number);
+    if (xcb_connection_has_error(c))
+    {
+        fprintf(stderr, "ERROR: cannot connect to the X server\n");
+        return EXIT_FAILURE;
+    }
+    screen = xcb_aux_get_screen(c, screen_number);
+
+    net_wm_name = intern("_NET_WM_NAME");
+    net_wm_icon = intern("_NET_WM_ICON");
+    utf8_string = intern("UTF8_STRING");
+
+    windows = calloc(window_count, sizeof(*windows));
+    create_windows();
+
+    int mapped = handle_events();
+    while (mapped < window_count)
+    {
+        wait_for_input(-1);
+        mapped += handle_events();
+    }
+    printf("READY %d\n", window_count);
+    fflush(stdout);
+
+    int64_t start = now_us();
+    int64_t end = start + duration * 1000000;
+    for (int i = 0; i < CHANGE_COUNT; i++)
+        next[i] = start;
+
+    for (int64_t now = start; now < end; now = now_us())
+    {
+        int64_t wakeup = end;
+
+        for (int i = 0; i < CHANGE_COUNT; i++)
+        {
+            if (rates[i] <= 0)
+                continue;
+
+            /* Catch up when late, so that the rate is kept on average */
+            while (next[i] <= now)
+            {
+                do_change(i);
+                changes[i]++;
+                next[i] += 1000000 / rates[i];
+            }
+            if (next[i] < wakeup)
+                wakeup = next[i];
+        }
+        xcb_flush(c);
+
+        wait_for_input((wakeup - now + 999) / 1000);
+        handle_events();
+    }
+
+    /* Make sure everything reached the X server */
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+
+    unsigned long total = 0;
+    for (int i = 0; i < CHANGE_COUNT; i++)
+    {
+        total += changes[i];
+        if (rates[i] > 0)
+            printf("LOG: %lu %s changes\n", changes[i], change_names[i]);
+    }
+    printf("DONE %lu\n", total);
+    fflush(stdout);
+
+    xcb_disconnect(c);
+    free(windows);
+    return EXIT_SUCCESS;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
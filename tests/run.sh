@@ -197,6 +197,7 @@ start_awesome() {
         AWESOME_THEMES_PATH="$AWESOME_THEMES_PATH" \
         AWESOME_ICON_PATH="$AWESOME_ICON_PATH" \
         XDG_CONFIG_HOME="$build_dir" \
+        XDG_CACHE_HOME="$tmp_files/cache" \
         timeout "$TEST_TIMEOUT" "$AWESOME" -c "$RC_FILE" "${awesome_options[@]}" > "$awesome_log" 2>&1 &
     awesome_pid=$!
     cd - >/dev/null
@@ -0,0 +1,76 @@
+--- Tests for awesome.batch
+
+local runner = require("_runner")
+local awful = require("awful")
+
+local emitted = {}
+
+local function record(name)
+    return function(t)
+        table.insert(emitted, t.name .. " " .. name)
+    end
+end
+
+local steps = {
+    function()
+        local s = screen.primary
+        local t1 = awful.tag.add("t1", { screen = s })
+        local t2 = awful.tag.add("t2", { screen = s })
+
+        for _, t in ipairs { t1, t2 } do
+            t:connect_signal("property::name", record("name"))
+            t:connect_signal("property::selected", record("selected"))
+            t:connect_signal("property::custom", record("custom"))
+        end
+
+        -- Signals are merged and only emitted at the end, in the order they
+        -- were first emitted.
+        local a, b = awesome.batch(function(x, y)
+            t2.name = "t2"
+            t1.name = "t1"
+            t1.name = "t1"
+            t2.selected = true
+            t2.name = "t2"
+            assert(#emitted == 0)
+            return x + y, "done"
+        end, 1, 2)
+        assert(a == 3 and b == "done")
+        assert(#emitted == 3, #emitted)
+        assert(emitted[1] == "t2 name")
+        assert(emitted[2] == "t1 name")
+        assert(emitted[3] == "t2 selected")
+
+        -- Signals emitted from Lua are not batched. Nested batches are
+        -- emitted by the outermost one.
+        emitted = {}
+        awesome.batch(function()
+            t1:emit_signal("property::custom")
+            assert(#emitted == 1)
+            awesome.batch(function()
+                t1.name = "t1"
+            end)
+            assert(#emitted == 1)
+        end)
+        assert(#emitted == 2)
+        assert(emitted[2] == "t1 name")
+
+        -- Errors are propagated, and the signals are still emitted.
+        emitted = {}
+        local ok, err = pcall(awesome.batch, function()
+            t1.name = "t1"
+            error("batch error")
+        end)
+        assert(not ok and err:match("batch error"))
+        assert(#emitted == 1)
+
+        t2.selected = false
+        t1:delete()
+        t2:delete()
+
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
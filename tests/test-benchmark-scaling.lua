@@ -0,0 +1,203 @@
+-- Measure how awesome scales with the number of clients, with the help of the
+-- load-generator program. For each number of clients, it measures:
+--
+-- * the time to manage all the clients,
+-- * the latency from a title change to the next refresh,
+-- * the CPU time and X requests per change,
+-- * the RSS of awesome.
+--
+-- The results are printed as a JSON object on a line starting with
+-- "BENCHMARK_JSON: " and written to $BENCHMARK_JSON if set, to compare them
+-- between builds.
+--
+-- Without BENCHMARK_EXACT, only a quick run with few clients is done. With it,
+-- the runs take a while, so TEST_TIMEOUT must be raised. BENCHMARK_CLIENTS can
+-- be set to a comma separated list of client counts.
+
+local runner = require("_runner")
+local spawn = require("awful.spawn")
+local GLib = require("lgi").GLib
+
+local BENCHMARK_EXACT = os.getenv("BENCHMARK_EXACT")
+local counts_env = os.getenv("BENCHMARK_CLIENTS")
+    or (BENCHMARK_EXACT and "10,100,500,1000" or "10,50")
+local duration = BENCHMARK_EXACT and 5 or 1
+local rate = 200
+
+local counts = {}
+for n in counts_env:gmatch("%d+") do
+    table.insert(counts, tonumber(n))
+end
+
+local function rss_kb()
+    local f = io.open("/proc/self/status")
+    if not f then return nil end
+    local status = f:read("*a")
+    f:close()
+    return tonumber(status:match("VmRSS:%s*(%d+)"))
+end
+
+local function percentile(sorted, p)
+    if #sorted == 0 then return nil end
+    return sorted[math.max(1, math.ceil(#sorted * p))]
+end
+
+-- A tiny JSON encoder, enough for numbers, strings, arrays and objects.
+local function to_json(value)
+    local t = type(value)
+    if t == "table" then
+        local parts = {}
+        if #value > 0 then
+            for _, v in ipairs(value) do
+                table.insert(parts, to_json(v))
+            end
+            return "[" .. table.concat(parts, ",") .. "]"
+        end
+        local keys = {}
+        for k in pairs(value) do
+            table.insert(keys, k)
+        end
+        table.sort(keys)
+        for _, k in ipairs(keys) do
+            table.insert(parts, string.format("%q:%s", k, to_json(value[k])))
+        end
+        return "{" .. table.concat(parts, ",") .. "}"
+    elseif t == "number" then
+        return string.format("%.6g", value)
+    elseif t == "string" then
+        return string.format("%q", value)
+    end
+    return "null"
+end
+
+local function generator_clients()
+    local ret = 0
+    for _, c in ipairs(client.get()) do
+        if c.class == "load-generator" then
+            ret = ret + 1
+        end
+    end
+    return ret
+end
+
+local results = {}
+local run
+
+-- Title changes carry the time they were made at, their latency is measured
+-- at the next refresh.
+local pending = {}
+client.connect_signal("property::name", function(c)
+    if run and run.churning and c.class == "load-generator" then
+        local sent = tonumber(c.name:match(" (%d+)$"))
+        if sent then
+            table.insert(pending, sent)
+        end
+    end
+end)
+awesome.connect_signal("refresh", function()
+    if #pending == 0 then return end
+    local now = GLib.get_monotonic_time()
+    for _, sent in ipairs(pending) do
+        table.insert(run.latencies, now - sent)
+    end
+    pending = {}
+end)
+
+local steps = {}
+
+for _, n in ipairs(counts) do
+    -- Start the load generator and wait until it mapped all its windows.
+    table.insert(steps, function(count)
+        if count == 1 then
+            run = { clients = n, latencies = {} }
+            run.start = GLib.get_monotonic_time()
+            spawn.with_line_callback({ "./load-generator", "-n", n,
+                "-d", duration, "-t", rate, "-i", rate / 4, "-u", rate / 4,
+                "-H", rate / 4, "-g", rate / 4 }, {
+                stdout = function(line)
+                    if line:match("^READY") then
+                        run.ready = true
+                    elseif line:match("^DONE") then
+                        run.changes = tonumber(line:match("(%d+)"))
+                    end
+                end,
+                stderr = function(line)
+                    print("load-generator: " .. line)
+                end,
+            })
+        end
+
+        if not (run.ready and generator_clients() == n) then return end
+
+        run.manage_time = GLib.get_monotonic_time() - run.start
+        run.rss_start = rss_kb()
+        run.cpu_start = os.clock()
+        run.churning = true
+        if awesome.track_xrequests then
+            awesome.track_xrequests(true)
+        end
+        return true
+    end)
+
+    -- Wait until the load generator is done, then collect the results.
+    table.insert(steps, function()
+        if not run.changes then return end
+
+        run.churning = false
+        local cpu = os.clock() - run.cpu_start
+        local xrequests = 0
+        if awesome.track_xrequests then
+            xrequests = awesome.xrequest_report().requests
+            awesome.track_xrequests(false)
+        end
+
+        table.sort(run.latencies)
+        local result = {
+            clients = n,
+            changes = run.changes,
+            manage_ms = run.manage_time / 1000,
+            latency_us = {
+                samples = #run.latencies,
+                p50 = percentile(run.latencies, 0.5),
+                p90 = percentile(run.latencies, 0.9),
+                p99 = percentile(run.latencies, 0.99),
+                max = run.latencies[#run.latencies],
+            },
+            cpu_us_per_change = run.changes > 0 and cpu * 1e6 / run.changes or nil,
+            xrequests_per_change = run.changes > 0 and xrequests / run.changes or nil,
+            rss_kb = { start = run.rss_start, ["end"] = rss_kb() },
+        }
+        table.insert(results, result)
+        print(string.format("%5d clients: managed in %.1f ms, latency p50 %s us, "..
+            "%.1f us CPU and %.2f X requests per change", n, result.manage_ms,
+            tostring(result.latency_us.p50), result.cpu_us_per_change or 0,
+            result.xrequests_per_change or 0))
+
+        assert(run.changes > 0)
+        assert(#run.latencies > 0)
+        return true
+    end)
+
+    -- The windows go away with the load generator.
+    table.insert(steps, function()
+        return generator_clients() == 0
+    end)
+end
+
+table.insert(steps, function()
+    local json = to_json({ duration = duration, rate = rate, runs = results })
+    print("BENCHMARK_JSON: " .. json)
+
+    local path = os.getenv("BENCHMARK_JSON")
+    if path then
+        local f = assert(io.open(path, "w"))
+        f:write(json, "\n")
+        f:close()
+    end
+
+    return true
+end)
+
+runner.run_steps(steps, { wait_per_step = BENCHMARK_EXACT and 120 or 10 })
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
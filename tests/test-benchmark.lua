@@ -5,6 +5,7 @@ local runner = require("_runner")
 local awful = require("awful")
 local GLib = require("lgi").GLib
 local create_wibox = require("_wibox_helper").create_wibox
+local test_client = require("_client")
 
 local BENCHMARK_EXACT = os.getenv("BENCHMARK_EXACT")
 if not BENCHMARK_EXACT then
@@ -71,12 +72,111 @@ local function e2e_tag_switch()
     do_pending_repaint()
 end
 
+-- A bar with many widgets where only one of them changes.
+local large_bar, large_bar_widget
+do
+    local wibox = require("wibox")
+    local left, right = wibox.layout.fixed.horizontal(), wibox.layout.fixed.horizontal()
+    for i = 1, 30 do
+        left:add(wibox.widget.textbox("left " .. i))
+        right:add(wibox.widget.textbox("right " .. i))
+    end
+    large_bar_widget = right:get_children()[15]
+
+    large_bar = wibox({ width = 1920, height = 20, screen = 1 })
+    large_bar:set_widget(wibox.layout.align.horizontal(left, nil, right))
+    do_pending_repaint()
+end
+
+local function relayout_large_bar()
+    large_bar_widget:emit_signal("widget::layout_changed")
+    do_pending_repaint()
+end
+
 benchmark(create_and_draw_wibox, "create&draw wibox")
 benchmark(update_textclock, "update textclock")
 benchmark(relayout_textclock, "relayout textclock")
+benchmark(relayout_large_bar, "relayout large bar")
 benchmark(redraw_textclock, "redraw textclock")
 benchmark(e2e_tag_switch, "tag switch")
 
-runner.run_steps({ function() return true end })
+-- Resizing goes through many sizes, but the fit and layout caches of the
+-- widgets only keep the most recent results.
+do
+    local base = require("wibox.widget.base")
+    local before = base.get_cache_stats()
+    local width = 0
+    benchmark(function()
+        width = (width + 1) % 100
+        large_bar.width = 1820 + width
+        do_pending_repaint()
+    end, "resize large bar")
+    local after = base.get_cache_stats()
+    for _, kind in ipairs { "fit", "layout" } do
+        print(string.format("%20s: %d hits, %d misses, %d evictions", kind .. " cache",
+            after[kind].hits - before[kind].hits,
+            after[kind].misses - before[kind].misses,
+            after[kind].evictions - before[kind].evictions))
+    end
+end
+
+-- Compare the Lua and the C implementations of the signals of gears.object on
+-- the propagation of widget::redraw_needed from a widget to its drawable.
+do
+    local gobject = require("gears.object")
+    local default_backend = gobject._signal_backend
+
+    for _, backend in ipairs { "lua", "c" } do
+        gobject._signal_backend = backend
+        local _, clock = create_wibox()
+        gobject._signal_backend = default_backend
+        do_pending_repaint()
+
+        benchmark(function()
+            for _ = 1, 100 do
+                clock:emit_signal("widget::redraw_needed")
+            end
+            do_pending_repaint()
+        end, "redraw signals (" .. backend .. ")")
+    end
+end
+
+-- Compare reading the properties of a client with reading the fields of a
+-- plain table.
+local client_properties = { "name", "class", "instance", "icon", "minimized",
+    "urgent", "sticky", "ontop", "above", "below", "maximized", "fullscreen",
+    "screen", "type", "skip_taskbar" }
+
+runner.run_steps({
+    function(count)
+        if count == 1 then
+            test_client("benchmark")
+        end
+
+        local c = client.get()[1]
+        if not c then return end
+
+        local plain = {}
+        for _, prop in ipairs(client_properties) do
+            plain[prop] = c[prop]
+        end
+
+        benchmark(function()
+            for _, prop in ipairs(client_properties) do
+                local _ = c[prop]
+            end
+        end, "client properties")
+        benchmark(function()
+            for _, prop in ipairs(client_properties) do
+                local _ = plain[prop]
+            end
+        end, "table fields")
+        benchmark(function()
+            c:get_properties(client_properties)
+        end, "get_properties")
+
+        return true
+    end
+})
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,111 @@
+--- Tests for the Lua bytecode cache, and a measurement of what it saves.
+
+local runner = require("_runner")
+local GLib = require("lgi").GLib
+
+local searcher = (package.searchers or package.loaders)[2]
+
+-- Modules with a lot of code.
+local modules = {
+    "awful.client", "awful.tag", "awful.placement", "awful.layout",
+    "awful.widget.tasklist", "awful.widget.taglist", "wibox.widget.base",
+    "wibox.hierarchy", "naughty.core", "menubar.utils", "gears.object",
+    "gears.shape", "beautiful",
+}
+
+local base = os.tmpname()
+local module_file = base .. "_bytecode_cache_test.lua"
+
+local function write_module(value)
+    local f = assert(io.open(module_file, "w"))
+    f:write("return " .. value .. "\n")
+    f:close()
+end
+
+local steps = {
+    function()
+        local stats = awesome._bytecode_cache_stats()
+        if not stats.enabled then
+            print("The bytecode cache is disabled, skipping")
+            return true
+        end
+
+        -- rc.lua and its modules were loaded through the cache.
+        assert(stats.hits + stats.misses > 0)
+        local startup = stats
+
+        -- Make sure everything is in the cache, then each lookup is a hit.
+        for _, name in ipairs(modules) do
+            searcher(name)
+        end
+        stats = awesome._bytecode_cache_stats()
+
+        local timer = GLib.Timer()
+        for _, name in ipairs(modules) do
+            local loader = searcher(name)
+            assert(type(loader) == "function")
+        end
+        local cached = timer:elapsed()
+        local after = awesome._bytecode_cache_stats()
+        assert(after.hits == stats.hits + #modules,
+            "expected " .. #modules .. " hits, got " .. after.hits - stats.hits)
+
+        timer:start()
+        for _, name in ipairs(modules) do
+            local _, path = searcher(name)
+            assert(loadfile(path))
+        end
+        local source = timer:elapsed()
+
+        print(string.format("Loading %d modules: %.2f ms from source, %.2f ms "..
+            "from the cache (%.1fx)", #modules, source * 1000, cached * 1000,
+            source / cached))
+        print(string.format("Startup: %d hits in %.2f ms, %d misses in %.2f ms",
+            startup.hits, startup.hit_time / 1000, startup.misses,
+            startup.miss_time / 1000))
+
+        -- Debug information is kept.
+        local loader, path = searcher("gears.object")
+        assert(debug.getinfo(loader, "S").source == "@" .. path)
+
+        return true
+    end,
+    function()
+        if not awesome._bytecode_cache_stats().enabled then return true end
+
+        package.path = base .. "_?.lua;" .. package.path
+        write_module("1")
+
+        local stats = awesome._bytecode_cache_stats()
+        assert(searcher("bytecode_cache_test")() == 1)
+        assert(searcher("bytecode_cache_test")() == 1)
+        local after = awesome._bytecode_cache_stats()
+        assert(after.misses == stats.misses + 1)
+        assert(after.hits == stats.hits + 1)
+        assert(after.writes == stats.writes + 1)
+
+        -- A different size means a different source.
+        write_module("1000")
+        assert(searcher("bytecode_cache_test")() == 1000)
+        assert(awesome._bytecode_cache_stats().misses == after.misses + 1)
+
+        -- Syntax errors are reported like with the default searcher.
+        write_module("+")
+        local ok, err = pcall(searcher, "bytecode_cache_test")
+        assert(not ok)
+        assert(err:find("error loading module 'bytecode_cache_test'", 1, true), err)
+
+        -- Unknown modules are left to the other searchers.
+        assert(searcher("no.such.module.anywhere") == nil)
+
+        package.path = package.path:sub(#base + #"_?.lua;" + 1)
+        os.remove(module_file)
+        os.remove(base)
+
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,90 @@
+--- Test that drawables keep the wallpaper below them for pseudo-transparency.
+
+local runner = require("_runner")
+local wibox = require("wibox")
+local gears = require("gears")
+
+local wallpaper_reads = 0
+local root_wallpaper = root.wallpaper
+root.wallpaper = function(...) -- luacheck: globals root
+    if select("#", ...) == 0 then
+        wallpaper_reads = wallpaper_reads + 1
+    end
+    return root_wallpaper(...)
+end
+
+local textbox = wibox.widget.textbox("test")
+local w = wibox {
+    x = 10,
+    y = 10,
+    width = 100,
+    height = 20,
+    visible = true,
+    bg = "#00000000",
+    widget = textbox,
+}
+
+local function do_pending_repaint()
+    gears.timer.run_delayed_calls_now()
+end
+
+local reads
+
+runner.run_steps({
+    function()
+        root.wallpaper(gears.color("#ff0000"))
+        return true
+    end,
+
+    -- Wait for the wallpaper to be drawn below the wibox
+    function()
+        -- True transparency does not need the wallpaper
+        if awesome.composite_manager_running then
+            return true
+        end
+        do_pending_repaint()
+        if wallpaper_reads == 0 then return end
+        reads = wallpaper_reads
+        return true
+    end,
+
+    -- Redraws reuse the wallpaper
+    function()
+        if awesome.composite_manager_running then
+            return true
+        end
+        for i = 1, 3 do
+            textbox.text = "test " .. i
+            do_pending_repaint()
+        end
+        assert(wallpaper_reads == reads, wallpaper_reads)
+        root.wallpaper(gears.color("#00ff00"))
+        return true
+    end,
+
+    -- Changing the wallpaper reads it again
+    function()
+        if awesome.composite_manager_running then
+            return true
+        end
+        do_pending_repaint()
+        if wallpaper_reads == reads then return end
+        assert(wallpaper_reads == reads + 1, wallpaper_reads)
+        reads = wallpaper_reads
+        w.x = 20
+        return true
+    end,
+
+    -- Moving the drawable reads it again
+    function()
+        if awesome.composite_manager_running then
+            return true
+        end
+        do_pending_repaint()
+        if wallpaper_reads == reads then return end
+        assert(wallpaper_reads == reads + 1, wallpaper_reads)
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
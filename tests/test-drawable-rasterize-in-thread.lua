@@ -0,0 +1,140 @@
+--- Test drawing widgets with the rasterisation on another thread.
+
+local runner = require("_runner")
+local wibox = require("wibox")
+local gears = require("gears")
+local lgi = require("lgi")
+local cairo = lgi.cairo
+local gdk = lgi.require("Gdk", "3.0")
+
+local w, other
+
+-- Get the color of a pixel of the wibox as a "#rrggbb" string.
+local function get_pixel(x, y)
+    local surf = gears.surface(w._drawable.drawable.surface)
+    local img = cairo.ImageSurface(cairo.Format.RGB24, 1, 1)
+    local cr = cairo.Context(img)
+    cr:set_source_surface(surf, -x, -y)
+    cr:paint()
+    img:flush()
+
+    local bytes = gdk.pixbuf_get_from_surface(img, 0, 0, 1, 1):get_pixels()
+    return "#" .. bytes:gsub('.', function(c) return ('%02x'):format(c:byte()) end)
+end
+
+local function do_pending_repaint()
+    gears.timer.run_delayed_calls_now()
+end
+
+runner.run_steps({
+    function()
+        wibox.drawable.rasterize_in_thread = true
+        w = wibox {
+            x       = 10,
+            y       = 10,
+            width   = 100,
+            height  = 20,
+            visible = true,
+            bg      = "#ff0000",
+            widget  = wibox.widget.textbox("test"),
+        }
+        return true
+    end,
+
+    -- The drawing shows up once it was rasterised
+    function()
+        do_pending_repaint()
+        if get_pixel(90, 10) ~= "#ff0000" then return end
+
+        w.bg = "#00ff00"
+        return true
+    end,
+
+    function()
+        do_pending_repaint()
+        if get_pixel(90, 10) ~= "#00ff00" then return end
+
+        -- Without the worker thread, the drawing is done right away
+        wibox.drawable.rasterize_in_thread = false
+        w.bg = "#0000ff"
+        do_pending_repaint()
+        assert(get_pixel(90, 10) == "#0000ff", get_pixel(90, 10))
+        return true
+    end,
+
+    -- A pending rasterised drawing does not overwrite a later one
+    function()
+        wibox.drawable.rasterize_in_thread = true
+        w.bg = "#ff0000"
+        do_pending_repaint()
+        wibox.drawable.rasterize_in_thread = false
+        w.bg = "#00ff00"
+        do_pending_repaint()
+        return true
+    end,
+
+    function(count)
+        if count < 3 then return end
+        assert(get_pixel(90, 10) == "#00ff00", get_pixel(90, 10))
+
+        -- Only the last of several drawings of the same area is needed
+        wibox.drawable.rasterize_in_thread = true
+        for _, color in ipairs { "#ff0000", "#00ff00", "#ffff00", "#00ffff", "#0000ff" } do
+            w.bg = color
+            do_pending_repaint()
+        end
+        return true
+    end,
+
+    function(count)
+        if get_pixel(90, 10) ~= "#0000ff" and count < 5 then return end
+        assert(get_pixel(90, 10) == "#0000ff", get_pixel(90, 10))
+
+        -- The content of another drawable is an X11 surface, so this drawing
+        -- is rasterised on the main thread
+        other = wibox {
+            x       = 10,
+            y       = 40,
+            width   = 100,
+            height  = 20,
+            visible = true,
+            bg      = "#ffff00",
+        }
+        do_pending_repaint()
+        return true
+    end,
+
+    function(count)
+        local surf = gears.surface(other._drawable.drawable.surface)
+        if count == 1 then
+            assert(surf.type ~= "IMAGE")
+            w.widget = wibox.widget.imagebox(surf)
+        end
+        do_pending_repaint()
+
+        if get_pixel(90, 10) ~= "#ffff00" and count < 5 then return end
+        assert(get_pixel(90, 10) == "#ffff00", get_pixel(90, 10))
+
+        -- The same goes for X11 surfaces used as a mask
+        local masked = wibox.widget.base.make_widget()
+        function masked:fit(_, width, height) return width, height end
+        function masked:draw(_, cr)
+            cr:set_source_rgb(0, 1, 1)
+            cr:mask_surface(surf, 0, 0)
+        end
+        w.widget = masked
+        return true
+    end,
+
+    function(count)
+        do_pending_repaint()
+        if get_pixel(90, 10) ~= "#00ffff" and count < 5 then return end
+        assert(get_pixel(90, 10) == "#00ffff", get_pixel(90, 10))
+
+        wibox.drawable.rasterize_in_thread = false
+        other.visible = false
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,90 @@
+--- Tests that the _NET_CLIENT_LIST and _NET_CLIENT_LIST_STACKING properties
+-- are written at most once per main loop iteration.
+
+local runner = require("_runner")
+local test_client = require("_client")
+
+local c1, c2, before
+
+local function written(stats)
+    return stats.replaced + stats.appended
+end
+
+-- Get the windows of a root window list as written in the X property.
+local function get_root_list(name)
+    local file = io.popen("xprop -notype -root " .. name)
+    local result = file:read("*all")
+    file:close()
+
+    local ret = {}
+    for win in result:gmatch("0x%x+") do
+        table.insert(ret, tonumber(win))
+    end
+    return ret
+end
+
+local steps = {
+    function(count)
+        if count == 1 then
+            test_client("ewmh1")
+            test_client("ewmh2")
+        end
+
+        if #client.get() ~= 2 then return end
+
+        for _, c in ipairs(client.get()) do
+            if c.class == "ewmh1" then c1 = c else c2 = c end
+        end
+
+        return true
+    end,
+    function()
+        before = awesome._ewmh_stats()
+
+        -- Change the stacking order several times in the same iteration.
+        for _ = 1, 5 do
+            c1:raise()
+            c2:raise()
+        end
+        c1:raise()
+
+        return true
+    end,
+    function()
+        local after = awesome._ewmh_stats()
+
+        -- Every change was recorded, but only the stacking list was written
+        -- and only once.
+        assert(after.requested - before.requested >= 11)
+        assert(written(after) - written(before) == 1,
+            "the lists were written " .. (written(after) - written(before)) .. " times")
+        assert(after.saved > before.saved)
+
+        return true
+    end,
+    function()
+        -- The single write has the final order.
+        local stacking = get_root_list("_NET_CLIENT_LIST_STACKING")
+        assert(stacking[#stacking] == c1.window)
+        assert(#get_root_list("_NET_CLIENT_LIST") == 2)
+
+        before = awesome._ewmh_stats()
+
+        -- Nothing changed in the end, nothing is written.
+        c2:raise()
+        c1:raise()
+
+        return true
+    end,
+    function()
+        local after = awesome._ewmh_stats()
+        assert(written(after) == written(before))
+        assert(after.unchanged > before.unchanged)
+
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,55 @@
+--- Tests for the garbage collection done while idle.
+
+local runner = require("_runner")
+
+local initial, disabled
+
+local steps = {
+    function()
+        assert(awesome.gc_budget() > 0)
+        initial = awesome.gc_stats()
+        assert(initial.heap > 0)
+
+        -- Make some garbage.
+        for i = 1, 100000 do
+            local _ = { i }
+        end
+
+        return true
+    end,
+    function(count)
+        -- Idle collection happens before the main loop sleeps.
+        local stats = awesome.gc_stats()
+        if stats.steps == initial.steps and count < 10 then return end
+
+        assert(stats.steps > initial.steps)
+        assert(stats.time >= initial.time)
+
+        assert(awesome.gc_budget(0) == 0)
+        assert(not pcall(awesome.gc_budget, -1))
+        disabled = awesome.gc_stats()
+
+        -- Without idle collection, the Lua defaults are back. Before, the
+        -- automatic collector was at most twice as lazy.
+        assert(stats.pause >= disabled.pause)
+        assert(stats.pause <= disabled.pause * 2)
+        assert(stats.stepmul <= disabled.stepmul)
+        assert(stats.stepmul >= math.floor(disabled.stepmul / 2))
+
+        return true
+    end,
+    function()
+        local stats = awesome.gc_stats()
+        assert(stats.budget == 0)
+
+        -- Nothing is collected while idle anymore.
+        assert(stats.steps == disabled.steps)
+
+        awesome.gc_budget(1000)
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,60 @@
+--- Tests for get_properties and set_properties
+
+local runner = require("_runner")
+local awful = require("awful")
+local wibox = require("wibox")
+
+local steps = {
+    function()
+        local t = awful.tag.add("props", { screen = screen.primary, gap = 3 })
+
+        -- C properties, properties handled by Lua and special fields.
+        local props = t:get_properties { "name", "selected", "gap", "valid",
+            "screen", "nonexistent" }
+        assert(props.name == "props")
+        assert(props.selected == false)
+        assert(props.gap == 3)
+        assert(props.valid == true)
+        assert(props.screen == screen.primary)
+        assert(props.nonexistent == nil)
+
+        local s = screen.primary:get_properties { "geometry", "index" }
+        assert(s.geometry.width == screen.primary.geometry.width)
+        assert(s.index == screen.primary.index)
+
+        -- Each signal is emitted once, after all the properties were set.
+        local names = {}
+        t:connect_signal("property::name", function()
+            table.insert(names, t.name .. " " .. tostring(t.gap))
+        end)
+        t:set_properties { name = "renamed", gap = 5, selected = true }
+        assert(t.name == "renamed" and t.gap == 5 and t.selected)
+        assert(#names == 1, #names)
+        assert(names[1] == "renamed 5")
+
+        -- Errors are propagated, with the location of the failing setter.
+        assert(not pcall(t.set_properties, t, { "not a property name" }))
+        local ok, err = pcall(t.set_properties, t, { selected = "not a boolean" })
+        assert(not ok)
+        assert(tostring(err):find("traceback", 1, true), err)
+
+        -- Properties that emit the same signal cause it only once.
+        local w = wibox { x = 10, y = 10, width = 20, height = 20 }
+        local geometries = {}
+        w.drawin:connect_signal("property::geometry", function(d)
+            table.insert(geometries, d:geometry())
+        end)
+        w.drawin:set_properties { x = 30, width = 40 }
+        assert(#geometries == 1, #geometries)
+        assert(geometries[1].x == 30 and geometries[1].width == 40)
+
+        t.selected = false
+        t:delete()
+
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,93 @@
+--- Tests for the C implementation of the signals of gears.object
+
+local runner = require("_runner")
+local gobject = require("gears.object")
+
+local steps = {
+    function()
+        -- LuaJIT uses the Lua implementation by default.
+        local default_backend = gobject._signal_backend
+        gobject._signal_backend = "c"
+        local obj = gobject()
+        assert(type(obj._signals) == "userdata")
+
+        -- Connecting twice only calls once.
+        local calls = {}
+        local function cb(o, arg)
+            assert(o == obj)
+            table.insert(calls, arg)
+        end
+        obj:connect_signal("test", cb)
+        obj:connect_signal("test", cb)
+        obj:emit_signal("test", 42)
+        assert(#calls == 1 and calls[1] == 42)
+        obj:disconnect_signal("test", cb)
+        obj:emit_signal("test", 43)
+        assert(#calls == 1)
+
+        -- Weak connections go away with their function.
+        local called = false
+        obj:weak_connect_signal("weak", function() called = true end)
+        collectgarbage("collect")
+        obj:emit_signal("weak")
+        assert(not called)
+
+        local function weak_cb() called = true end
+        obj:weak_connect_signal("weak", weak_cb)
+        collectgarbage("collect")
+        obj:emit_signal("weak")
+        assert(called)
+        assert(not pcall(obj.connect_signal, obj, "weak", weak_cb))
+        obj:connect_signal("strong", weak_cb)
+        assert(not pcall(obj.weak_connect_signal, obj, "strong", weak_cb))
+
+        -- Functions disconnected by a previous one are not called.
+        local count = 0
+        local first, second
+        first = function()
+            count = count + 1
+            obj:disconnect_signal("chain", second)
+        end
+        second = function()
+            count = count + 1
+            obj:disconnect_signal("chain", first)
+        end
+        obj:connect_signal("chain", first)
+        obj:connect_signal("chain", second)
+        obj:emit_signal("chain")
+        assert(count == 1)
+
+        -- Global receivers get the signal name first.
+        local received
+        obj:_connect_everything(function(...) received = { ... } end)
+        obj:emit_signal("global", 1)
+        assert(received[1] == "global" and received[2] == obj and received[3] == 1)
+
+        -- The module functions work with both implementations.
+        gobject._signal_backend = "lua"
+        local lua_obj = gobject()
+        gobject._signal_backend = "c"
+        assert(type(lua_obj._signals) == "table")
+        count = 0
+        gobject.connect_signal(lua_obj, "test", function() count = count + 1 end)
+        gobject.connect_signal(obj, "test", function() count = count + 1 end)
+        gobject.emit_signal(lua_obj, "test")
+        gobject.emit_signal(obj, "test")
+        assert(count == 2)
+
+        -- Errors are propagated.
+        obj:connect_signal("error", function() error("signal error") end)
+        local ok, err = pcall(obj.emit_signal, obj, "error")
+        assert(not ok and err:match("signal error"))
+        assert(not pcall(obj.connect_signal, obj, "test", 42))
+        assert(not pcall(obj.emit_signal, {}, "test"))
+
+        gobject._signal_backend = default_backend
+
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,71 @@
+--- Tests for `--profile-startup`.
+--
+-- The test starts a new awesome process with the option and checks the
+-- timeline it writes.
+
+local runner = require("_runner")
+local restart = require("_restart")
+
+local name = "test-profile-startup"
+local file = debug.getinfo(1, "S").source:sub(2)
+local profile = restart.get_phase(name)
+
+local function read_file(path)
+    local f = io.open(path)
+    if not f then return nil end
+    local ret = f:read("*all")
+    f:close()
+    return ret
+end
+
+local steps
+
+if not profile then
+    steps = {
+        function()
+            profile = os.tmpname()
+            restart.set_phase(name, profile)
+            restart.exec(file, { "--profile-startup", profile })
+
+            -- Not reached.
+            return false
+        end,
+    }
+else
+    steps = {
+        function(count)
+            -- The profile is written at the end of the first main loop
+            -- iteration.
+            local trace = read_file(profile)
+            if (not trace or trace == "") and count < 10 then return end
+
+            restart.set_phase(name, nil)
+
+            assert(trace:find('"traceEvents"', 1, true), trace)
+            for _, phase in ipairs { "options", "X connection", "WM selection",
+                                     "Lua setup", "rc.lua", "scan",
+                                     "first refresh" } do
+                assert(trace:find('"name": "' .. phase .. '", "cat": "phase"', 1, true),
+                    "missing phase " .. phase)
+            end
+
+            -- The modules loaded by the configuration are recorded.
+            assert(trace:find('"name": "awful", "cat": "require"', 1, true))
+            assert(trace:find('"name": "beautiful.init"', 1, true))
+
+            local summary = read_file(profile .. ".txt")
+            assert(summary and summary:find("^Startup took"), summary)
+            assert(summary:find("Slowest modules by self time:", 1, true))
+
+            os.remove(profile)
+            os.remove(profile .. ".txt")
+            restart.cleanup()
+
+            return true
+        end,
+    }
+end
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,99 @@
+--- Tests for the Lua sampling profiler.
+
+local runner = require("_runner")
+
+local function busy_leaf(n)
+    local x = 0
+    for i = 1, n do
+        x = x + i % 7
+    end
+    return x
+end
+
+local function busy_caller()
+    -- Not a tail call, so that the caller stays on the stack.
+    local x = busy_leaf(200000)
+    return x
+end
+
+local function check_profile(samples, profile)
+    assert(samples > 0)
+
+    local total, found = 0, false
+    for line in profile:gmatch("[^\n]+") do
+        local stack, count = line:match("^(.+) (%d+)$")
+        assert(stack, line)
+        total = total + tonumber(count)
+        local caller = stack:find("busy_caller", 1, true)
+        local leaf = stack:find("busy_leaf", 1, true)
+        -- Frames go from the outermost to the innermost one.
+        if caller and leaf then
+            assert(caller < leaf, stack)
+            found = true
+        end
+    end
+    assert(total == samples, total .. " ~= " .. samples)
+    assert(found, profile)
+end
+
+local steps = {
+    function()
+        awesome.profiler_start { instructions = 1000 }
+        assert(not pcall(awesome.profiler_start))
+        busy_caller()
+        check_profile(awesome.profiler_stop())
+        assert(not pcall(awesome.profiler_stop))
+
+        assert(not pcall(awesome.profiler_start, { frequency = 0 }))
+
+        return true
+    end,
+    function()
+        awesome.profiler_start { frequency = 5000 }
+        -- Spin long enough to get samples from the CPU time timer.
+        local start = os.clock()
+        while os.clock() - start < 0.2 do
+            busy_caller()
+        end
+
+        local path = os.tmpname()
+        local samples = awesome.profiler_stop(path)
+        local f = assert(io.open(path))
+        check_profile(samples, f:read("*a"))
+        f:close()
+        os.remove(path)
+
+        return true
+    end,
+    function()
+        -- A hook set before is back once the profiler stops, also with the
+        -- timer, which replaces the hook for each sample.
+        local calls = 0
+        local function hook() calls = calls + 1 end
+
+        for _, args in ipairs { { instructions = 1000 }, { frequency = 5000 } } do
+            debug.sethook(hook, "", 100)
+            awesome.profiler_start(args)
+            local start = os.clock()
+            while os.clock() - start < 0.05 do
+                busy_caller()
+            end
+            assert(awesome.profiler_stop() > 0)
+
+            local current, mask, count = debug.gethook()
+            assert(current == hook and mask == "" and count == 100)
+            debug.sethook()
+        end
+        assert(calls > 0)
+
+        -- A whole second between samples.
+        awesome.profiler_start { frequency = 1 }
+        assert(awesome.profiler_stop() == 0)
+
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,63 @@
+--- Tests for the tracking of synchronous X round-trips.
+
+local runner = require("_runner")
+
+if not awesome.track_roundtrips then
+    print("awesome was built without WITH_XCB_INTERPOSER, skipping")
+    runner.run_steps { function() return true end }
+    return
+end
+
+local function sync_caller()
+    awesome.sync()
+end
+
+local steps = {
+    function()
+        local was_enabled = awesome.track_roundtrips(true)
+
+        for _ = 1, 5 do
+            sync_caller()
+        end
+        local _ = mouse.coords()
+
+        local report = awesome.roundtrip_report()
+        assert(report.count >= 6, report.count)
+        assert(report.time >= 0)
+
+        local found, pointer = false, false
+        for i, entry in ipairs(report) do
+            assert(entry.request and entry.traceback, i)
+            assert(entry.count > 0 and entry.max <= entry.time)
+            if i > 1 then
+                assert(report[i - 1].time >= entry.time)
+            end
+            if entry.traceback:find("sync_caller", 1, true) then
+                -- xcb_aux_sync() waits for the reply of a GetInputFocus.
+                assert(entry.request == "GetInputFocus", entry.request)
+                assert(entry.count == 5, entry.count)
+                found = true
+            end
+            pointer = pointer or entry.request == "QueryPointer"
+        end
+        assert(found)
+        assert(pointer)
+
+        assert(#awesome.roundtrip_report(1) == 1)
+
+        -- Enabling the tracking again starts from scratch.
+        awesome.track_roundtrips(true)
+        assert(awesome.roundtrip_report().count == 0)
+
+        assert(awesome.track_roundtrips(was_enabled))
+        if not was_enabled then
+            assert(awesome.roundtrip_report() == nil)
+        end
+
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
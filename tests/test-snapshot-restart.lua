@@ -0,0 +1,125 @@
+--- Tests that `awful.snapshot` restores the state across `awesome.restart`.
+--
+-- The clients are not spawned with `_client.lua`: its clients quit when the
+-- pipe to awesome is closed, which happens when it restarts.
+
+local runner = require("_runner")
+local restart = require("_restart")
+local awful = require("awful")
+
+local name = "test-snapshot-restart"
+local file = debug.getinfo(1, "S").source:sub(2)
+local phase = restart.get_phase(name)
+
+local lua_executable = os.getenv("LUA")
+if lua_executable == nil or lua_executable == "" then
+    lua_executable = "lua"
+end
+
+local client_source = [[
+pcall(require, 'luarocks.loader')
+local Gtk = require('lgi').require('Gtk', '3.0')
+Gtk.init()
+local window = Gtk.Window { default_width = 100, default_height = 100,
+                            on_destroy = Gtk.main_quit }
+window:set_wmclass(%q, %q)
+window:show_all()
+Gtk:main()
+]]
+
+local function spawn_client(class)
+    awful.spawn({ lua_executable, "-e", string.format(client_source, class, class) }, false)
+end
+
+local s = screen[1]
+local c1, c2
+
+local function find_clients()
+    for _, c in ipairs(client.get()) do
+        if c.class == "snapshot1" then c1 = c end
+        if c.class == "snapshot2" then c2 = c end
+    end
+    return c1 and c2
+end
+
+local steps
+
+if not phase then
+    -- Continue in a process which runs this file after the configuration.
+    steps = {
+        function()
+            restart.set_phase(name, "setup")
+            restart.exec(file)
+            return false
+        end,
+    }
+elseif phase == "setup" then
+    steps = {
+        function(count)
+            if count == 1 then
+                spawn_client("snapshot1")
+                spawn_client("snapshot2")
+            end
+            return find_clients()
+        end,
+        function()
+            local tags = s.tags
+
+            tags[2].layout = awful.layout.suit.fair
+            tags[2].master_width_factor = 0.7
+            tags[2].master_count = 2
+            awful.tag.viewmore({ tags[2], tags[3] }, s)
+
+            c1:tags { tags[2] }
+            c2:tags { tags[2], tags[3] }
+            c2.floating = true
+
+            client.focus = c2
+            client.focus = c1
+
+            return true
+        end,
+        function()
+            restart.set_phase(name, "restarted")
+            awesome.restart()
+            return false
+        end,
+    }
+else
+    steps = {
+        function()
+            restart.set_phase(name, nil)
+            restart.cleanup()
+
+            -- The snapshot is only for this process.
+            assert(awesome.get_xproperty("awful.snapshot") == nil)
+
+            return find_clients()
+        end,
+        function()
+            local tags = s.tags
+
+            assert(not tags[1].selected)
+            assert(tags[2].selected)
+            assert(tags[3].selected)
+            assert(tags[2].layout == awful.layout.suit.fair)
+            assert(tags[2].master_width_factor == 0.7)
+            assert(tags[2].master_count == 2)
+
+            assert(not c1.floating)
+            assert(#c1:tags() == 1 and c1:tags()[1] == tags[2])
+            assert(c2.floating)
+            assert(#c2:tags() == 2)
+
+            assert(client.focus == c1)
+            assert(awful.client.focus.history.get(s, 0) == c1)
+            assert(awful.client.focus.history.get(s, 1) == c2)
+
+            return true
+        end,
+    }
+end
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
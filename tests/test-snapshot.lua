@@ -0,0 +1,105 @@
+--- Tests for the state snapshot kept across restarts.
+
+local runner = require("_runner")
+local test_client = require("_client")
+local awful = require("awful")
+local snapshot = require("awful.snapshot")
+
+local s = screen[1]
+local c1, c2, data
+
+local steps = {
+    function(count)
+        if count == 1 then
+            test_client("snapshot1")
+            test_client("snapshot2")
+        end
+
+        for _, c in ipairs(client.get()) do
+            if c.class == "snapshot1" then c1 = c end
+            if c.class == "snapshot2" then c2 = c end
+        end
+
+        return c1 and c2
+    end,
+    function()
+        local tags = s.tags
+
+        tags[2].layout = awful.layout.suit.fair
+        tags[2].master_width_factor = 0.7
+        tags[2].master_count = 2
+        tags[2].gap = 4
+        tags[2].name = "two words"
+        tags[3].name = ""
+        awful.tag.viewmore({ tags[2], tags[3] }, s)
+
+        c1:tags { tags[2] }
+        c2:tags { tags[2], tags[3] }
+        c2.floating = true
+
+        client.focus = c2
+        client.focus = c1
+
+        data = snapshot.serialize()
+        assert(data:find("two%20words", 1, true), data)
+
+        return true
+    end,
+    function()
+        local tags = s.tags
+
+        -- Mess the state up.
+        awful.tag.viewonly(tags[1])
+        tags[2].layout = awful.layout.suit.tile
+        tags[2].master_width_factor = 0.5
+        tags[2].master_count = 1
+        tags[2].gap = 0
+        tags[2].name = "2"
+        c1:tags { tags[1] }
+        c2:tags { tags[1] }
+        c2.floating = false
+        client.focus = c2
+
+        local parsed = snapshot.parse(data)
+        assert(parsed)
+        snapshot.restore_tags(parsed)
+
+        assert(not tags[1].selected)
+        assert(tags[2].selected)
+        assert(tags[3].selected)
+        assert(tags[2].layout == awful.layout.suit.fair)
+        assert(tags[2].master_width_factor == 0.7)
+        assert(tags[2].master_count == 2)
+        assert(tags[2].gap == 4)
+        assert(tags[2].name == "2")
+
+        local props = snapshot.client_properties(parsed, c2)
+        assert(props.screen == s)
+        assert(props.floating)
+        assert(#props.tags == 2 and props.tags[1] == tags[2] and props.tags[2] == tags[3])
+
+        props = snapshot.client_properties(parsed, c1)
+        assert(not props.floating)
+        assert(#props.tags == 1 and props.tags[1] == tags[2])
+
+        assert(snapshot.restore_focus_history(parsed) == c1)
+        assert(awful.client.focus.history.get(s, 0) == c1)
+        assert(awful.client.focus.history.get(s, 1) == c2)
+
+        -- Tags missing from the configuration are created.
+        local count = #tags
+        parsed = snapshot.parse(data:gsub("\ntag 1 3 ", "\ntag 1 " .. (count + 1) .. " "))
+        snapshot.restore_tags(parsed)
+        assert(#s.tags == count + 1)
+        assert(s.tags[count + 1].name == nil or s.tags[count + 1].name == "")
+        s.tags[count + 1]:delete()
+
+        assert(snapshot.parse("garbage") == nil)
+
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
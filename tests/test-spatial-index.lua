@@ -0,0 +1,128 @@
+--- Tests for the `client.at`, `client.intersecting` and `screen.at` lookups.
+
+local runner = require("_runner")
+local test_client = require("_client")
+local awful = require("awful")
+
+local c1, c2
+
+local steps = {
+    function(count)
+        if count == 1 then
+            test_client("spatial1")
+            test_client("spatial2")
+        end
+
+        if #client.get() ~= 2 then return end
+
+        for _, c in ipairs(client.get()) do
+            if c.class == "spatial1" then c1 = c else c2 = c end
+            c.floating = true
+            c.border_width = 5
+        end
+
+        c1:geometry { x = 100, y = 100, width = 300, height = 300 }
+        c2:geometry { x = 200, y = 200, width = 300, height = 300 }
+        c2:raise()
+
+        return true
+    end,
+    function()
+        -- The border is part of the client.
+        assert(client.at(100, 100) == c1)
+        assert(client.at(409, 409) == c2)
+        assert(client.at(405, 150) == c1)
+        assert(client.at(99, 99) == nil)
+        assert(client.at(510, 510) == nil)
+
+        -- Overlapping area, c2 is on top.
+        assert(client.at(250, 250) == c2)
+        c1:raise()
+        return true
+    end,
+    function()
+        assert(client.at(250, 250) == c1)
+
+        local found = client.intersecting { x = 0, y = 0, width = 250, height = 250 }
+        assert(#found == 2)
+        assert(found[1] == c1 and found[2] == c2)
+
+        found = client.intersecting { x = 0, y = 0, width = 150, height = 150 }
+        assert(#found == 1 and found[1] == c1)
+
+        assert(#client.intersecting { x = 1000, y = 1000, width = 10, height = 10 } == 0)
+
+        -- Move a client across grid cells.
+        c2:geometry { x = 900, y = 600, width = 50, height = 50 }
+
+        -- Minimized clients are not visible.
+        c1.minimized = true
+
+        return true
+    end,
+    function()
+        assert(client.at(250, 250) == nil)
+        assert(client.at(920, 620) == c2)
+
+        local found = client.intersecting { x = 0, y = 0, width = 1024, height = 768 }
+        assert(#found == 1 and found[1] == c2)
+
+        c1.minimized = false
+        return true
+    end,
+    -- The callers of the index.
+    function()
+        client.focus = c1
+        awful.client.focus.bydirection("right")
+        assert(client.focus == c2)
+        awful.client.focus.bydirection("down")
+        assert(client.focus == c2)
+        awful.client.focus.bydirection("up")
+        assert(client.focus == c1)
+
+        -- Move c1 over c2 and let the placement find a free area for it.
+        c1:geometry { x = 850, y = 550, width = 100, height = 100 }
+        awful.placement.no_overlap(c1)
+        local g1, g2 = c1:geometry(), c2:geometry()
+        assert(g1.x + g1.width <= g2.x or g2.x + g2.width <= g1.x
+            or g1.y + g1.height <= g2.y or g2.y + g2.height <= g1.y)
+
+        mouse.coords { x = g2.x + 10, y = g2.y + 10 }
+        return true
+    end,
+    function()
+        if mouse.object_under_pointer() ~= c2 then return end
+        return true
+    end,
+    function()
+        for s in screen do
+            local geo = s.geometry
+            assert(screen.at(geo.x, geo.y) == s)
+            assert(screen.at(geo.x + geo.width - 1, geo.y + geo.height - 1) == s)
+        end
+        assert(screen.at(-10, -10) == nil)
+
+        -- Resized screens are found at their new position.
+        local s = screen[1]
+        local geo = s.geometry
+        s:fake_resize(geo.x + 10, geo.y, geo.width - 10, geo.height)
+        assert(screen.at(geo.x, geo.y) ~= s)
+        assert(screen.at(geo.x + 10, geo.y) == s)
+        s:fake_resize(geo.x, geo.y, geo.width, geo.height)
+        assert(screen.at(geo.x, geo.y) == s)
+
+        c1:kill()
+        c2:kill()
+        return true
+    end,
+    function()
+        if #client.get() ~= 0 then return end
+
+        assert(client.at(920, 620) == nil)
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
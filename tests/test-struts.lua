@@ -616,6 +616,31 @@ table.insert(steps, function()
     return true
 end)
 
+-- Test that setting the same struts again does not emit a workarea change.
+table.insert(steps, function()
+    local emitted = 0
+    local function count() emitted = emitted + 1 end
+    s:connect_signal("property::workarea", count)
+
+    local stats = screen.workarea_stats()
+    assert(stats.drawins >= 1)
+
+    twibar:struts(twibar:struts())
+    assert(emitted == 0)
+
+    local after = screen.workarea_stats()
+    assert(after.updates > stats.updates)
+    assert(after.changes == stats.changes)
+
+    -- Only windows with struts are looked at.
+    assert(after.visited - stats.visited
+        == (after.updates - stats.updates) * (after.clients + after.drawins))
+
+    s:disconnect_signal("property::workarea", count)
+
+    return true
+end)
+
 require("_runner").run_steps(steps)
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
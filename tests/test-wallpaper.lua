@@ -291,6 +291,113 @@ table.insert(steps, function(count)
     return true
 end)
 
+-- Load an image without blocking.
+local async_result
+
+table.insert(steps, function()
+    local changed = false
+    local function on_changed() changed = true end
+    awesome.connect_signal("wallpaper_changed", on_changed)
+
+    local path = require("gears.filesystem").get_themes_dir() .. "default/background.png"
+    awall.load_image_async(path, screen[1], function(success, err)
+        awesome.disconnect_signal("wallpaper_changed", on_changed)
+        async_result = { success = success, err = err, changed = changed }
+    end)
+
+    -- The image is loaded on another thread.
+    assert(not async_result)
+
+    return true
+end)
+
+table.insert(steps, function()
+    if not async_result then return end
+
+    assert(async_result.success, async_result.err)
+    assert(async_result.changed)
+
+    async_result = nil
+    awall.load_image_async("/does/not/exist.png", screen[1], function(success, err)
+        async_result = { success = success, err = err }
+    end)
+
+    return true
+end)
+
+table.insert(steps, function()
+    if not async_result then return end
+
+    assert(not async_result.success)
+    assert(async_result.err)
+
+    return true
+end)
+
+-- Repainting the wallpaper of one screen leaves the other screens alone.
+local gdk = require("lgi").require("Gdk", "3.0")
+local split_walls, other_screen, painted_areas, set_wallpaper
+
+local function get_pixel(s)
+    local geo = s.geometry
+    local pixbuf = gdk.pixbuf_get_from_surface(surface(root.wallpaper()),
+        geo.x + math.floor(geo.width/2), geo.y + math.floor(geo.height/2), 1, 1)
+    local bytes = pixbuf:get_pixels():sub(1, 3)
+    return "#" .. bytes:gsub('.', function(c) return ('%02x'):format(c:byte()) end)
+end
+
+table.insert(steps, function()
+    local geo = screen[1].geometry
+    local half = math.floor(geo.width/2)
+
+    screen[1]:fake_resize(geo.x, geo.y, half, geo.height)
+    other_screen = screen.fake_add(geo.x + half, geo.y, geo.width - half, geo.height)
+
+    split_walls = {
+        awall { screen = screen[1]    , bg = "#ff0000" },
+        awall { screen = other_screen , bg = "#0000ff" },
+    }
+
+    return true
+end)
+
+table.insert(steps, function(count)
+    if get_pixel(screen[1]) ~= "#ff0000" and count < 5 then return end
+
+    assert(get_pixel(screen[1]) == "#ff0000", get_pixel(screen[1]))
+    assert(get_pixel(other_screen) == "#0000ff", get_pixel(other_screen))
+
+    painted_areas = {}
+    set_wallpaper = root.wallpaper
+    root.wallpaper = function(pattern, x, y, width, height)
+        if pattern then
+            table.insert(painted_areas, { x = x, y = y, width = width, height = height })
+        end
+        return set_wallpaper(pattern, x, y, width, height)
+    end
+
+    split_walls[2].bg = "#00ff00"
+
+    return true
+end)
+
+table.insert(steps, function(count)
+    if #painted_areas == 0 and count < 5 then return end
+
+    -- Only the area of the screen whose wallpaper changed was sent.
+    local geo = other_screen.geometry
+    assert(#painted_areas == 1)
+    assert(painted_areas[1].x == geo.x and painted_areas[1].y == geo.y)
+    assert(painted_areas[1].width == geo.width and painted_areas[1].height == geo.height)
+
+    assert(get_pixel(other_screen) == "#00ff00", get_pixel(other_screen))
+    assert(get_pixel(screen[1]) == "#ff0000", get_pixel(screen[1]))
+
+    root.wallpaper = set_wallpaper
+
+    return true
+end)
+
 runner.run_steps(steps)
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,82 @@
+--- Tests for the accounting of X requests.
+
+local runner = require("_runner")
+local wibox = require("wibox")
+
+if not awesome.track_xrequests then
+    print("awesome was built without WITH_XCB_INTERPOSER, skipping")
+    runner.run_steps { function() return true end }
+    return
+end
+
+local w
+
+local function sum(t)
+    local requests, bytes = 0, 0
+    for _, counter in pairs(t) do
+        requests = requests + counter.requests
+        bytes = bytes + counter.bytes
+    end
+    return requests, bytes
+end
+
+local function check_report(report)
+    assert(report.requests > 0)
+    assert(report.bytes >= 4 * report.requests)
+
+    -- Each request is counted once by phase and once by opcode.
+    local requests, bytes = sum(report.phases)
+    assert(requests == report.requests and bytes == report.bytes)
+    requests, bytes = sum(report.opcodes)
+    assert(requests == report.requests and bytes == report.bytes)
+
+    local iterations = 0
+    for _, bucket in ipairs(report.histogram) do
+        iterations = iterations + bucket.iterations
+    end
+    assert(iterations == report.iterations)
+    assert(report.max_iteration.requests <= report.requests)
+end
+
+local steps = {
+    function()
+        assert(not awesome.track_xrequests(true))
+
+        w = wibox {
+            x = 10, y = 10, width = 50, height = 50, visible = true,
+        }
+
+        return true
+    end,
+    function()
+        local report = awesome.xrequest_report()
+        check_report(report)
+        assert(report.iterations >= 1)
+        assert(report.opcodes.CreateWindow.requests >= 1)
+        assert(report.opcodes.MapWindow.requests >= 1)
+
+        -- Moves are applied by the drawin refresh.
+        awesome.track_xrequests(true)
+        w.x = 20
+        return true
+    end,
+    function()
+        local report = awesome.xrequest_report()
+        check_report(report)
+        assert(report.phases.drawin.requests >= 1)
+        assert(report.opcodes.ConfigureWindow.requests >= 1)
+
+        -- A main loop iteration with nothing to do sends nothing.
+        assert(report.histogram[1].max == 0)
+
+        w.visible = false
+        assert(awesome.track_xrequests(false))
+        assert(awesome.xrequest_report() == nil)
+
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
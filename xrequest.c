@@ -0,0 +1,492 @@
+/*
+ * xrequest.c - X request accounting
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* Every request, be it from awesome, cairo or an XCB extension library, is
+ * queued by one of the xcb_send_request*() functions. Like for round-trip
+ * tracking, awesome defines them and forwards them to libxcb. Depending on
+ * its version, libxcb implements some of them with the others, so only the
+ * outermost call is counted.
+ *
+ * Requests are counted by opcode and by the phase of the main loop iteration
+ * which sent them, with the size of their data. The number of requests sent
+ * by each iteration goes into a histogram. The opcodes of the last requests
+ * are also kept by sequence number, for the round-trip tracking to name the
+ * request whose reply it waits for.
+ *
+ * The functions of libxcb are only replaced in builds with
+ * WITH_XCB_INTERPOSER.
+ */
+
+#define _GNU_SOURCE
+
+#include "xrequest.h"
+#include "globalconf.h"
+
+#include <lauxlib.h>
+
+#include <dlfcn.h>
+#include <xcb/xcbext.h>
+
+/* Number of requests per iteration: 0, 1, 2-3, 4-7, ..., 32768 and more */
+#define XREQUEST_HISTOGRAM_BUCKETS 17
+/* Number of requests whose opcode is kept, a power of two */
+#define XREQUEST_RECENT 256
+
+typedef struct
+{
+    unsigned int requests;
+    uint64_t bytes;
+} xrequest_counter_t;
+
+typedef struct
+{
+    const xcb_extension_t *ext;
+    uint8_t minor;
+    xrequest_counter_t counter;
+} xrequest_ext_op_t;
+
+DO_ARRAY(xrequest_ext_op_t, xrequest_ext_op, DO_NOTHING)
+
+typedef struct
+{
+    /** Sequence number, 0 for an unused slot */
+    uint64_t sequence;
+    const xcb_extension_t *ext;
+    uint8_t opcode;
+} xrequest_recent_t;
+
+static const char * const xrequest_phase_names[XREQUEST_PHASE_COUNT] =
+{
+    [XREQUEST_PHASE_EVENTS] = "events",
+    [XREQUEST_PHASE_REFRESH] = "refresh",
+    [XREQUEST_PHASE_DRAWIN] = "drawin",
+    [XREQUEST_PHASE_CLIENT_GEOMETRY] = "client_geometry",
+    [XREQUEST_PHASE_CLIENT] = "client",
+    [XREQUEST_PHASE_BANNING] = "banning",
+    [XREQUEST_PHASE_STACK] = "stack",
+    [XREQUEST_PHASE_DESTROY] = "destroy",
+    [XREQUEST_PHASE_EWMH] = "ewmh",
+    [XREQUEST_PHASE_GRABS] = "grabs",
+};
+
+/* The requests of the core protocol */
+static const char * const xrequest_core_names[128] =
+{
+    [1] = "CreateWindow", "ChangeWindowAttributes", "GetWindowAttributes",
+    "DestroyWindow", "DestroySubwindows", "ChangeSaveSet", "ReparentWindow",
+    "MapWindow", "MapSubwindows", "UnmapWindow", "UnmapSubwindows",
+    "ConfigureWindow", "CirculateWindow", "GetGeometry", "QueryTree",
+    "InternAtom", "GetAtomName", "ChangeProperty", "DeleteProperty",
+    "GetProperty", "ListProperties", "SetSelectionOwner", "GetSelectionOwner",
+    "ConvertSelection", "SendEvent", "GrabPointer", "UngrabPointer",
+    "GrabButton", "UngrabButton", "ChangeActivePointerGrab", "GrabKeyboard",
+    "UngrabKeyboard", "GrabKey", "UngrabKey", "AllowEvents", "GrabServer",
+    "UngrabServer", "QueryPointer", "GetMotionEvents", "TranslateCoordinates",
+    "WarpPointer", "SetInputFocus", "GetInputFocus", "QueryKeymap", "OpenFont",
+    "CloseFont", "QueryFont", "QueryTextExtents", "ListFonts",
+    "ListFontsWithInfo", "SetFontPath", "GetFontPath", "CreatePixmap",
+    "FreePixmap", "CreateGC", "ChangeGC", "CopyGC", "SetDashes",
+    "SetClipRectangles", "FreeGC", "ClearArea", "CopyArea", "CopyPlane",
+    "PolyPoint", "PolyLine", "PolySegment", "PolyRectangle", "PolyArc",
+    "FillPoly", "PolyFillRectangle", "PolyFillArc", "PutImage", "GetImage",
+    "PolyText8", "PolyText16", "ImageText8", "ImageText16", "CreateColormap",
+    "FreeColormap", "CopyColormapAndFree", "InstallColormap",
+    "UninstallColormap", "ListInstalledColormaps", "AllocColor",
+    "AllocNamedColor", "AllocColorCells", "AllocColorPlanes", "FreeColors",
+    "StoreColors", "StoreNamedColor", "QueryColors", "LookupColor",
+    "CreateCursor", "CreateGlyphCursor", "FreeCursor", "RecolorCursor",
+    "QueryBestSize", "QueryExtension", "ListExtensions",
+    "ChangeKeyboardMapping", "GetKeyboardMapping", "ChangeKeyboardControl",
+    "GetKeyboardControl", "Bell", "ChangePointerControl", "GetPointerControl",
+    "SetScreenSaver", "GetScreenSaver", "ChangeHosts", "ListHosts",
+    "SetAccessControl", "SetCloseDownMode", "KillClient", "RotateProperties",
+    "ForceScreenSaver", "SetPointerMapping", "GetPointerMapping",
+    "SetModifierMapping", "GetModifierMapping",
+    [127] = "NoOperation",
+};
+
+static struct
+{
+    /** Are requests counted? */
+    bool enabled;
+    /** The only thread whose requests are counted */
+    GThread *main_thread;
+    /** Depth of the xcb_send_request*() calls of the main thread */
+    int depth;
+    /** The current phase, tracked even when counting is disabled */
+    xrequest_phase_t phase;
+    /** All requests */
+    xrequest_counter_t total;
+    /** Requests by phase */
+    xrequest_counter_t phases[XREQUEST_PHASE_COUNT];
+    /** Requests of the core protocol, by opcode */
+    xrequest_counter_t core[countof(xrequest_core_names)];
+    /** Requests of extensions, by extension and minor opcode */
+    xrequest_ext_op_array_t ext_ops;
+    /** Requests sent by the current main loop iteration */
+    xrequest_counter_t iteration;
+    /** Number of main loop iterations */
+    unsigned int iterations;
+    /** Number of main loop iterations by number of requests sent */
+    unsigned int histogram[XREQUEST_HISTOGRAM_BUCKETS];
+    /** Most requests and bytes sent by a main loop iteration */
+    xrequest_counter_t max_iteration;
+    /** The last requests sent by the main thread, by sequence number */
+    xrequest_recent_t recent[XREQUEST_RECENT];
+} xrequest;
+
+/** Set the thread whose requests are counted and remembered. */
+void
+xrequest_init(void)
+{
+    xrequest.main_thread = g_thread_self();
+}
+
+/** Enable or disable the request accounting. Enabling it clears the
+ * previous data.
+ * \param enable True to enable accounting.
+ */
+void
+xrequest_enable(bool enable)
+{
+    xrequest_ext_op_array_wipe(&xrequest.ext_ops);
+    xrequest.total = xrequest.iteration = xrequest.max_iteration = (xrequest_counter_t) { 0, 0 };
+    xrequest.iterations = 0;
+    p_clear(xrequest.phases, countof(xrequest.phases));
+    p_clear(xrequest.core, countof(xrequest.core));
+    p_clear(xrequest.histogram, countof(xrequest.histogram));
+
+    xrequest.main_thread = g_thread_self();
+    xrequest.enabled = enable;
+}
+
+/** Set the phase of the main loop iteration.
+ * \param phase The new phase.
+ * \return The previous phase.
+ */
+xrequest_phase_t
+xrequest_phase_set(xrequest_phase_t phase)
+{
+    xrequest_phase_t previous = xrequest.phase;
+    xrequest.phase = phase;
+    return previous;
+}
+
+/** Get the number of requests counted so far.
+ * \return The number of requests.
+ */
+unsigned int
+xrequest_count(void)
+{
+    return xrequest.total.requests;
+}
+
+/** Account for the end of a main loop iteration. */
+void
+xrequest_iteration_end(void)
+{
+    if(!xrequest.enabled)
+        return;
+
+    unsigned int bucket = 0;
+    for(unsigned int n = xrequest.iteration.requests; n && bucket < XREQUEST_HISTOGRAM_BUCKETS - 1; n >>= 1)
+        bucket++;
+
+    xrequest.histogram[bucket]++;
+    xrequest.iterations++;
+    xrequest.max_iteration.requests = MAX(xrequest.max_iteration.requests, xrequest.iteration.requests);
+    xrequest.max_iteration.bytes = MAX(xrequest.max_iteration.bytes, xrequest.iteration.bytes);
+    xrequest.iteration = (xrequest_counter_t) { 0, 0 };
+}
+
+static inline void
+xrequest_counter_add(xrequest_counter_t *counter, uint64_t bytes)
+{
+    counter->requests++;
+    counter->bytes += bytes;
+}
+
+/** Append the name of a request sent by the main thread to a string.
+ * \param buf The string.
+ * \param sequence The sequence number of the request. Only the low 32 bits
+ * are compared, since libxcb hands those out in most places.
+ */
+void
+xrequest_describe(GString *buf, uint64_t sequence)
+{
+    const xrequest_recent_t *recent = &xrequest.recent[sequence % XREQUEST_RECENT];
+
+    if(!recent->sequence || (uint32_t) recent->sequence != (uint32_t) sequence)
+        g_string_append(buf, "unknown request");
+    else if(recent->ext)
+        g_string_append_printf(buf, "%s:%d", recent->ext->name, (int) recent->opcode);
+    else if(recent->opcode < countof(xrequest_core_names) && xrequest_core_names[recent->opcode])
+        g_string_append(buf, xrequest_core_names[recent->opcode]);
+    else
+        g_string_append_printf(buf, "%d", (int) recent->opcode);
+}
+
+#ifdef WITH_XCB_INTERPOSER
+
+/** Count a request.
+ * \param vector The data of the request.
+ * \param request Information about the request.
+ */
+static void
+xrequest_record(const struct iovec *vector, const xcb_protocol_request_t *request)
+{
+    uint64_t bytes = 0;
+    for(size_t i = 0; i < request->count; i++)
+        bytes += vector[i].iov_len;
+
+    xrequest_counter_add(&xrequest.total, bytes);
+    xrequest_counter_add(&xrequest.phases[xrequest.phase], bytes);
+    xrequest_counter_add(&xrequest.iteration, bytes);
+
+    if(!request->ext)
+    {
+        if(request->opcode < countof(xrequest.core))
+            xrequest_counter_add(&xrequest.core[request->opcode], bytes);
+        return;
+    }
+
+    foreach(op, xrequest.ext_ops)
+        if(op->ext == request->ext && op->minor == request->opcode)
+        {
+            xrequest_counter_add(&op->counter, bytes);
+            return;
+        }
+
+    xrequest_ext_op_array_append(&xrequest.ext_ops, (xrequest_ext_op_t) {
+        .ext = request->ext,
+        .minor = request->opcode,
+        .counter = { 1, bytes },
+    });
+}
+
+/** Remember the opcode of a request.
+ * \param request Information about the request.
+ * \param sequence Its sequence number.
+ */
+static void
+xrequest_remember(const xcb_protocol_request_t *request, uint64_t sequence)
+{
+    xrequest_recent_t *recent = &xrequest.recent[sequence % XREQUEST_RECENT];
+    recent->sequence = sequence;
+    recent->ext = request->ext;
+    recent->opcode = request->opcode;
+}
+
+/** Account for a request about to be sent.
+ * \param vector The data of the request.
+ * \param request Information about the request.
+ * \return The depth of the call, 0 outside of the main thread.
+ */
+static int
+xrequest_enter(const struct iovec *vector, const xcb_protocol_request_t *request)
+{
+    /* Other threads can send requests too. They are not counted and must
+     * not touch the depth. */
+    if(g_thread_self() != xrequest.main_thread)
+        return 0;
+
+    if(++xrequest.depth == 1 && xrequest.enabled)
+        xrequest_record(vector, request);
+    return xrequest.depth;
+}
+
+/** Account for a request which was sent.
+ * \param depth The value returned by xrequest_enter().
+ * \param request Information about the request.
+ * \param sequence Its sequence number.
+ */
+static void
+xrequest_leave(int depth, const xcb_protocol_request_t *request, uint64_t sequence)
+{
+    if(depth == 1)
+        xrequest_remember(request, sequence);
+    if(depth)
+        xrequest.depth--;
+}
+
+unsigned int
+xcb_send_request(xcb_connection_t *c, int flags, struct iovec *vector,
+                 const xcb_protocol_request_t *request)
+{
+    static unsigned int (*real)(xcb_connection_t *, int, struct iovec *,
+                                const xcb_protocol_request_t *);
+    if(!real)
+        real = dlsym(RTLD_NEXT, "xcb_send_request");
+
+    int depth = xrequest_enter(vector, request);
+    unsigned int sequence = real(c, flags, vector, request);
+    xrequest_leave(depth, request, sequence);
+    return sequence;
+}
+
+uint64_t
+xcb_send_request64(xcb_connection_t *c, int flags, struct iovec *vector,
+                   const xcb_protocol_request_t *request)
+{
+    static uint64_t (*real)(xcb_connection_t *, int, struct iovec *,
+                            const xcb_protocol_request_t *);
+    if(!real)
+        real = dlsym(RTLD_NEXT, "xcb_send_request64");
+
+    int depth = xrequest_enter(vector, request);
+    uint64_t sequence = real(c, flags, vector, request);
+    xrequest_leave(depth, request, sequence);
+    return sequence;
+}
+
+unsigned int
+xcb_send_request_with_fds(xcb_connection_t *c, int flags, struct iovec *vector,
+                          const xcb_protocol_request_t *request,
+                          unsigned int num_fds, int *fds)
+{
+    static unsigned int (*real)(xcb_connection_t *, int, struct iovec *,
+                                const xcb_protocol_request_t *, unsigned int, int *);
+    if(!real)
+        real = dlsym(RTLD_NEXT, "xcb_send_request_with_fds");
+
+    int depth = xrequest_enter(vector, request);
+    unsigned int sequence = real(c, flags, vector, request, num_fds, fds);
+    xrequest_leave(depth, request, sequence);
+    return sequence;
+}
+
+uint64_t
+xcb_send_request_with_fds64(xcb_connection_t *c, int flags, struct iovec *vector,
+                            const xcb_protocol_request_t *request,
+                            unsigned int num_fds, int *fds)
+{
+    static uint64_t (*real)(xcb_connection_t *, int, struct iovec *,
+                            const xcb_protocol_request_t *, unsigned int, int *);
+    if(!real)
+        real = dlsym(RTLD_NEXT, "xcb_send_request_with_fds64");
+
+    int depth = xrequest_enter(vector, request);
+    uint64_t sequence = real(c, flags, vector, request, num_fds, fds);
+    xrequest_leave(depth, request, sequence);
+    return sequence;
+}
+
+#endif /* WITH_XCB_INTERPOSER */
+
+/** Enable or disable the accounting of X requests.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam True to enable accounting, false to disable it.
+ * \lreturn Whether accounting was enabled.
+ */
+int
+luaA_track_xrequests(lua_State *L)
+{
+    bool was_enabled = xrequest.enabled;
+    xrequest_enable(luaA_checkboolean(L, 1));
+    lua_pushboolean(L, was_enabled);
+    return 1;
+}
+
+static void
+luaA_xrequest_push_counter(lua_State *L, const xrequest_counter_t *counter)
+{
+    lua_createtable(L, 0, 2);
+    lua_pushinteger(L, counter->requests);
+    lua_setfield(L, -2, "requests");
+    lua_pushinteger(L, counter->bytes);
+    lua_setfield(L, -2, "bytes");
+}
+
+/** Get the number of X requests sent, by phase and by opcode.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lreturn A table with the counters, or nil when accounting is disabled.
+ */
+int
+luaA_xrequest_report(lua_State *L)
+{
+    if(!xrequest.enabled)
+        return 0;
+
+    lua_createtable(L, 0, 7);
+    lua_pushinteger(L, xrequest.total.requests);
+    lua_setfield(L, -2, "requests");
+    lua_pushinteger(L, xrequest.total.bytes);
+    lua_setfield(L, -2, "bytes");
+    lua_pushinteger(L, xrequest.iterations);
+    lua_setfield(L, -2, "iterations");
+    luaA_xrequest_push_counter(L, &xrequest.max_iteration);
+    lua_setfield(L, -2, "max_iteration");
+
+    lua_createtable(L, 0, XREQUEST_PHASE_COUNT);
+    for(int i = 0; i < XREQUEST_PHASE_COUNT; i++)
+        if(xrequest.phases[i].requests)
+        {
+            luaA_xrequest_push_counter(L, &xrequest.phases[i]);
+            lua_setfield(L, -2, xrequest_phase_names[i]);
+        }
+    lua_setfield(L, -2, "phases");
+
+    lua_newtable(L);
+    for(size_t i = 0; i < countof(xrequest.core); i++)
+        if(xrequest.core[i].requests)
+        {
+            luaA_xrequest_push_counter(L, &xrequest.core[i]);
+            if(xrequest_core_names[i])
+                lua_setfield(L, -2, xrequest_core_names[i]);
+            else
+            {
+                lua_pushfstring(L, "%d", (int) i);
+                lua_insert(L, -2);
+                lua_rawset(L, -3);
+            }
+        }
+    foreach(op, xrequest.ext_ops)
+    {
+        lua_pushfstring(L, "%s:%d", op->ext->name, (int) op->minor);
+        luaA_xrequest_push_counter(L, &op->counter);
+        lua_rawset(L, -3);
+    }
+    lua_setfield(L, -2, "opcodes");
+
+    /* Each bucket counts the iterations which sent up to "max" requests */
+    lua_createtable(L, XREQUEST_HISTOGRAM_BUCKETS, 0);
+    for(int i = 0; i < XREQUEST_HISTOGRAM_BUCKETS; i++)
+    {
+        lua_createtable(L, 0, 2);
+        if(i < XREQUEST_HISTOGRAM_BUCKETS - 1)
+        {
+            lua_pushinteger(L, i ? (1 << i) - 1 : 0);
+            lua_setfield(L, -2, "max");
+        }
+        lua_pushinteger(L, xrequest.histogram[i]);
+        lua_setfield(L, -2, "iterations");
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_setfield(L, -2, "histogram");
+
+    return 1;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
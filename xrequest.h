@@ -0,0 +1,60 @@
+/*
+ * xrequest.h - X request accounting header
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_XREQUEST_H
+#define AWESOME_XREQUEST_H
+
+#include <glib.h>
+#include <lua.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/** The part of the main loop iteration which sends X requests */
+typedef enum
+{
+    /** Event handling, Lua callbacks and timers */
+    XREQUEST_PHASE_EVENTS,
+    /** The "refresh" signal */
+    XREQUEST_PHASE_REFRESH,
+    XREQUEST_PHASE_DRAWIN,
+    XREQUEST_PHASE_CLIENT_GEOMETRY,
+    XREQUEST_PHASE_CLIENT,
+    XREQUEST_PHASE_BANNING,
+    XREQUEST_PHASE_STACK,
+    XREQUEST_PHASE_DESTROY,
+    /** The EWMH properties of the root window */
+    XREQUEST_PHASE_EWMH,
+    /** Key and button grabs */
+    XREQUEST_PHASE_GRABS,
+    XREQUEST_PHASE_COUNT
+} xrequest_phase_t;
+
+void xrequest_init(void);
+void xrequest_enable(bool);
+xrequest_phase_t xrequest_phase_set(xrequest_phase_t);
+unsigned int xrequest_count(void);
+void xrequest_iteration_end(void);
+void xrequest_describe(GString *, uint64_t);
+int luaA_track_xrequests(lua_State *);
+int luaA_xrequest_report(lua_State *);
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
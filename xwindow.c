@@ -22,6 +22,7 @@
 #include "xwindow.h"
 #include "common/atoms.h"
 #include "objects/button.h"
+#include "xrequest.h"
 
 #include <xcb/xcb.h>
 #include <xcb/shape.h>
@@ -109,6 +110,8 @@ xwindow_buttons_grab(xcb_window_t win, button_array_t *buttons)
     if(win == XCB_NONE)
         return;
 
+    xrequest_phase_t phase = xrequest_phase_set(XREQUEST_PHASE_GRABS);
+
     /* Ungrab everything first */
     xcb_ungrab_button(globalconf.connection, XCB_BUTTON_INDEX_ANY, win, XCB_BUTTON_MASK_ANY);
 
@@ -116,6 +119,8 @@ xwindow_buttons_grab(xcb_window_t win, button_array_t *buttons)
         xcb_grab_button(globalconf.connection, false, win, BUTTONMASK,
                         XCB_GRAB_MODE_SYNC, XCB_GRAB_MODE_ASYNC, XCB_NONE, XCB_NONE,
                         (*b)->button, (*b)->modifiers);
+
+    xrequest_phase_set(phase);
 }
 
 /** Grab key on a window.
@@ -144,11 +149,15 @@ xwindow_grabkey(xcb_window_t win, keyb_t *k)
 void
 xwindow_grabkeys(xcb_window_t win, key_array_t *keys)
 {
+    xrequest_phase_t phase = xrequest_phase_set(XREQUEST_PHASE_GRABS);
+
     /* Ungrab everything first */
     xcb_ungrab_key(globalconf.connection, XCB_GRAB_ANY, win, XCB_BUTTON_MASK_ANY);
 
     foreach(k, *keys)
         xwindow_grabkey(win, *k);
+
+    xrequest_phase_set(phase);
 }
 
 /** Send a request for a window's opacity.